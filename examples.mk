@@ -40,6 +40,19 @@ vpxenc.DESCRIPTION           = Full featured encoder
 UTILS-$(CONFIG_ENCODERS)    += vp8_scalable_patterns.c
 vp8_scalable_patterns.GUID   = 0D6A210B-F482-4D6F-8570-4A9C01ACC88C
 vp8_scalable_patterns.DESCRIPTION = Temporal Scalability Encoder
+# The multi-stream benchmark runs its streams on pthreads.
+ifeq ($(CONFIG_MULTITHREAD)$(CONFIG_MSVS),yes)
+UTILS-$(CONFIG_DECODERS)    += vp8_multi_stream_decoder.c
+vp8_multi_stream_decoder.GUID = 6E2B8C1F-4D3A-4B5E-9F7A-2C8D1E0B3A64
+vp8_multi_stream_decoder.DESCRIPTION = Concurrent Stream Decoding Benchmark
+endif
+UTILS-$(CONFIG_DECODERS)    += vp8_decode_benchmark.c
+vp8_decode_benchmark.SRCS   += vpx_ports/vpx_timer.h
+vp8_decode_benchmark.GUID    = 8F4A2D6B-1C3E-4A7F-B952-D06E3C1B7A45
+vp8_decode_benchmark.DESCRIPTION = Decoding Benchmark
+UTILS-$(CONFIG_POSTPROC)    += vp8_postproc_check.c
+vp8_postproc_check.GUID      = 3B9E5D27-8C41-4F0A-B6D2-7E1A9C4F5B83
+vp8_postproc_check.DESCRIPTION = Postprocessing SIMD Kernel Check
 
 # Clean up old ivfenc, ivfdec binaries.
 ifeq ($(CONFIG_MSVS),yes)
@@ -43,8 +43,14 @@ void vp8_de_alloc_frame_buffers(VP8_COMMON *oci)
 
     vp8_yv12_de_alloc_frame_buffer(&oci->temp_scale_frame);
     vp8_yv12_de_alloc_frame_buffer(&oci->post_proc_buffer);
-    if (oci->post_proc_buffer_int_used)
-        vp8_yv12_de_alloc_frame_buffer(&oci->post_proc_buffer_int);
+#if CONFIG_POSTPROC
+    if (oci->postproc_state.mfqe_buffer_used)
+        vp8_yv12_de_alloc_frame_buffer(&oci->postproc_state.mfqe_buffer);
+
+    vpx_free(oci->postproc_state.pending_rows);
+    oci->postproc_state.pending_rows = 0;
+    oci->postproc_state.pending_cols = 0;
+#endif
 
     vpx_free(oci->above_context);
     vpx_free(oci->mip);
@@ -103,7 +109,9 @@ int vp8_alloc_frame_buffers(VP8_COMMON *oci, int width, int height)
         return 1;
     }
 
-    oci->post_proc_buffer_int_used = 0;
+#if CONFIG_POSTPROC
+    oci->postproc_state.mfqe_buffer_used = 0;
+#endif
 
     oci->mb_rows = height >> 4;
     oci->mb_cols = width >> 4;
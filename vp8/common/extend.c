@@ -156,6 +156,65 @@ void vp8_copy_and_extend_frame_with_rect(YV12_BUFFER_CONFIG *src,
 }
 
 
+static void extend_plane_rows
+(
+    unsigned char *s, /* first pixel of the plane */
+    int p,            /* pitch */
+    int w,            /* width */
+    int h,            /* height */
+    int b,            /* border */
+    int y0,           /* first line to extend */
+    int y1            /* line after the last line to extend */
+)
+{
+    unsigned char *src_ptr = s + y0 * p;
+    int i;
+
+    /* copy the left and right most columns out */
+    for (i = y0; i < y1; i++)
+    {
+        vpx_memset(src_ptr - b, src_ptr[0], b);
+        vpx_memset(src_ptr + w, src_ptr[w - 1], b);
+        src_ptr += p;
+    }
+
+    /* the top and bottom borders replicate the extended first and last line */
+    if (y0 == 0)
+    {
+        src_ptr = s - b;
+
+        for (i = 1; i <= b; i++)
+            vpx_memcpy(src_ptr - i * p, src_ptr, p);
+    }
+
+    if (y1 == h)
+    {
+        src_ptr = s + (h - 1) * p - b;
+
+        for (i = 1; i <= b; i++)
+            vpx_memcpy(src_ptr + i * p, src_ptr, p);
+    }
+}
+
+
+/* Extends the borders of a single MB row of a frame. Extending every row in
+ * any order gives the same result as vp8_yv12_extend_frame_borders().
+ */
+void vp8_extend_mb_row_borders(YV12_BUFFER_CONFIG *ybf, int mb_row)
+{
+    const int y0 = mb_row * 16;
+
+    extend_plane_rows(ybf->y_buffer, ybf->y_stride, ybf->y_width,
+                      ybf->y_height, ybf->border, y0, y0 + 16);
+
+    extend_plane_rows(ybf->u_buffer, ybf->uv_stride, ybf->uv_width,
+                      ybf->uv_height, ybf->border / 2, y0 / 2, y0 / 2 + 8);
+
+    extend_plane_rows(ybf->v_buffer, ybf->uv_stride, ybf->uv_width,
+                      ybf->uv_height, ybf->border / 2, y0 / 2, y0 / 2 + 8);
+}
+
+
 /* note the extension is only for the last row, for intra prediction purpose */
 void vp8_extend_mb_row(YV12_BUFFER_CONFIG *ybf, unsigned char *YPtr, unsigned char *UPtr, unsigned char *VPtr)
 {
@@ -17,6 +17,7 @@
 #include "vpx_ports/x86.h"
 #endif
 #include "vp8/common/onyxc_int.h"
+#include "vp8/common/systemdependent.h"
 
 #if CONFIG_MULTITHREAD
 #if HAVE_UNISTD_H
@@ -30,7 +31,7 @@ typedef void (WINAPI *PGNSI)(LPSYSTEM_INFO);
 extern void vp8_arch_opencl_common_init(VP8_COMMON *ctx);
 
 #if CONFIG_MULTITHREAD
-static int get_cpu_count()
+int vp8_get_cpu_count(void)
 {
     int core_count = 16;
 
@@ -72,7 +73,7 @@ void vp8_machine_specific_config(VP8_COMMON *ctx)
 #endif
 
 #if CONFIG_MULTITHREAD
-    ctx->processor_core_count = get_cpu_count();
+    ctx->processor_core_count = vp8_get_cpu_count();
 #endif /* CONFIG_MULTITHREAD */
 
 #if ARCH_ARM
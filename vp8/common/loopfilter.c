@@ -118,10 +118,6 @@ void vp8_loop_filter_frame_init(VP8_COMMON *cm,
                                 MACROBLOCKD *mbd,
                                 int default_filt_lvl)
 {
-    int seg,  /* segment number */
-        ref,  /* index in ref_lf_deltas */
-        mode; /* index in mode_lf_deltas */
-
     loop_filter_info_n *lfi = &cm->lf_info;
 
     /* update limits if sharpness has changed */
@@ -131,6 +127,17 @@ void vp8_loop_filter_frame_init(VP8_COMMON *cm,
         cm->last_sharpness_level = cm->sharpness_level;
     }
 
+    vp8_loop_filter_lvl_init(lfi->lvl, mbd, default_filt_lvl);
+}
+
+void vp8_loop_filter_lvl_init(unsigned char lvl[4][4][4],
+                              MACROBLOCKD *mbd,
+                              int default_filt_lvl)
+{
+    int seg,  /* segment number */
+        ref,  /* index in ref_lf_deltas */
+        mode; /* index in mode_lf_deltas */
+
     for(seg = 0; seg < MAX_MB_SEGMENTS; seg++)
     {
         int lvl_seg = default_filt_lvl;
@@ -156,7 +163,7 @@ void vp8_loop_filter_frame_init(VP8_COMMON *cm,
             /* we could get rid of this if we assume that deltas are set to
              * zero when not in use; encoder always uses deltas
              */
-            vpx_memset(lfi->lvl[seg][0], lvl_seg, 4 * 4 );
+            vpx_memset(lvl[seg][0], lvl_seg, 4 * 4 );
             continue;
         }
 
@@ -174,11 +181,11 @@ void vp8_loop_filter_frame_init(VP8_COMMON *cm,
         lvl_mode = lvl_ref +  mbd->mode_lf_deltas[mode];
         lvl_mode = (lvl_mode > 0) ? (lvl_mode > 63 ? 63 : lvl_mode) : 0; /* clamp */
 
-        lfi->lvl[seg][ref][mode] = lvl_mode;
+        lvl[seg][ref][mode] = lvl_mode;
 
         mode = 1; /* all the rest of Intra modes */
         lvl_mode = (lvl_ref > 0) ? (lvl_ref > 63 ? 63 : lvl_ref)  : 0; /* clamp */
-        lfi->lvl[seg][ref][mode] = lvl_mode;
+        lvl[seg][ref][mode] = lvl_mode;
 
         /* LAST, GOLDEN, ALT */
         for(ref = 1; ref < MAX_REF_FRAMES; ref++)
@@ -194,125 +201,130 @@ void vp8_loop_filter_frame_init(VP8_COMMON *cm,
                 lvl_mode = lvl_ref + mbd->mode_lf_deltas[mode];
                 lvl_mode = (lvl_mode > 0) ? (lvl_mode > 63 ? 63 : lvl_mode) : 0; /* clamp */
 
-                lfi->lvl[seg][ref][mode] = lvl_mode;
+                lvl[seg][ref][mode] = lvl_mode;
             }
         }
     }
 }
 
-void vp8_loop_filter_frame
+void vp8_loop_filter_row
 (
     VP8_COMMON *cm,
-    MACROBLOCKD *mbd
+    YV12_BUFFER_CONFIG *post,
+    int mb_row
 )
 {
-    YV12_BUFFER_CONFIG *post = cm->frame_to_show;
     loop_filter_info_n *lfi_n = &cm->lf_info;
     loop_filter_info lfi;
 
     FRAME_TYPE frame_type = cm->frame_type;
 
-    int mb_row;
     int mb_col;
 
     int filter_level;
 
     unsigned char *y_ptr, *u_ptr, *v_ptr;
 
-    /* Point at base of Mb MODE_INFO list */
-    const MODE_INFO *mode_info_context = cm->mi;
-    
-#if CONFIG_OPENCL && ENABLE_CL_LOOPFILTER
-    if ( cl_initialized == CL_SUCCESS ){
-        vp8_loop_filter_frame_cl(cm,mbd);
-        return;
-    }
-#endif
-    
-    /* Initialize the loop filter for this frame. */
-    vp8_loop_filter_frame_init(cm, mbd, cm->filter_level);
+    /* Point at the first MB of this row in the MODE_INFO list */
+    const MODE_INFO *mode_info_context = cm->mi + mb_row * cm->mode_info_stride;
 
     /* Set up the buffer pointers */
-    y_ptr = post->y_buffer;
-    u_ptr = post->u_buffer;
-    v_ptr = post->v_buffer;
+    y_ptr = post->y_buffer + mb_row * post->y_stride * 16;
+    u_ptr = post->u_buffer + mb_row * post->uv_stride * 8;
+    v_ptr = post->v_buffer + mb_row * post->uv_stride * 8;
 
     /* vp8_filter each macro block */
-    for (mb_row = 0; mb_row < cm->mb_rows; mb_row++)
+    for (mb_col = 0; mb_col < cm->mb_cols; mb_col++)
     {
-        for (mb_col = 0; mb_col < cm->mb_cols; mb_col++)
-        {
-            int skip_lf = (mode_info_context->mbmi.mode != B_PRED &&
-                            mode_info_context->mbmi.mode != SPLITMV &&
-                            mode_info_context->mbmi.mb_skip_coeff);
+        int skip_lf = (mode_info_context->mbmi.mode != B_PRED &&
+                        mode_info_context->mbmi.mode != SPLITMV &&
+                        mode_info_context->mbmi.mb_skip_coeff);
 
-            const int mode_index = lfi_n->mode_lf_lut[mode_info_context->mbmi.mode];
-            const int seg = mode_info_context->mbmi.segment_id;
-            const int ref_frame = mode_info_context->mbmi.ref_frame;
+        const int mode_index = lfi_n->mode_lf_lut[mode_info_context->mbmi.mode];
+        const int seg = mode_info_context->mbmi.segment_id;
+        const int ref_frame = mode_info_context->mbmi.ref_frame;
 
-            filter_level = lfi_n->lvl[seg][ref_frame][mode_index];
+        filter_level = lfi_n->lvl[seg][ref_frame][mode_index];
 
-            if (filter_level)
+        if (filter_level)
+        {
+            if (cm->filter_type == NORMAL_LOOPFILTER)
             {
-                if (cm->filter_type == NORMAL_LOOPFILTER)
-                {
-                    const int hev_index = lfi_n->hev_thr_lut[frame_type][filter_level];
-                    lfi.mblim = lfi_n->mblim[filter_level];
-                    lfi.blim = lfi_n->blim[filter_level];
-                    lfi.lim = lfi_n->lim[filter_level];
-                    lfi.hev_thr = lfi_n->hev_thr[hev_index];
+                const int hev_index = lfi_n->hev_thr_lut[frame_type][filter_level];
+                lfi.mblim = lfi_n->mblim[filter_level];
+                lfi.blim = lfi_n->blim[filter_level];
+                lfi.lim = lfi_n->lim[filter_level];
+                lfi.hev_thr = lfi_n->hev_thr[hev_index];
+
+                if (mb_col > 0)
+                    vp8_loop_filter_mbv
+                    (y_ptr, u_ptr, v_ptr, post->y_stride, post->uv_stride, &lfi);
+
+                if (!skip_lf)
+                    vp8_loop_filter_bv
+                    (y_ptr, u_ptr, v_ptr, post->y_stride, post->uv_stride, &lfi);
+
+                /* don't apply across umv border */
+                if (mb_row > 0)
+                    vp8_loop_filter_mbh
+                    (y_ptr, u_ptr, v_ptr, post->y_stride, post->uv_stride, &lfi);
 
-                    if (mb_col > 0)
-                        vp8_loop_filter_mbv
-                        (y_ptr, u_ptr, v_ptr, post->y_stride, post->uv_stride, &lfi);
+                if (!skip_lf)
+                    vp8_loop_filter_bh
+                    (y_ptr, u_ptr, v_ptr, post->y_stride, post->uv_stride, &lfi);
+            }
+            else
+            {
+                if (mb_col > 0)
+                    vp8_loop_filter_simple_mbv
+                    (y_ptr, post->y_stride, lfi_n->mblim[filter_level]);
 
-                    if (!skip_lf)
-                        vp8_loop_filter_bv
-                        (y_ptr, u_ptr, v_ptr, post->y_stride, post->uv_stride, &lfi);
+                if (!skip_lf)
+                    vp8_loop_filter_simple_bv
+                    (y_ptr, post->y_stride, lfi_n->blim[filter_level]);
 
-                    /* don't apply across umv border */
-                    if (mb_row > 0)
-                        vp8_loop_filter_mbh
-                        (y_ptr, u_ptr, v_ptr, post->y_stride, post->uv_stride, &lfi);
+                /* don't apply across umv border */
+                if (mb_row > 0)
+                    vp8_loop_filter_simple_mbh
+                    (y_ptr, post->y_stride, lfi_n->mblim[filter_level]);
 
-                    if (!skip_lf)
-                        vp8_loop_filter_bh
-                        (y_ptr, u_ptr, v_ptr, post->y_stride, post->uv_stride, &lfi);
-                }
-                else
-                {
-                    if (mb_col > 0)
-                        vp8_loop_filter_simple_mbv
-                        (y_ptr, post->y_stride, lfi_n->mblim[filter_level]);
+                if (!skip_lf)
+                    vp8_loop_filter_simple_bh
+                    (y_ptr, post->y_stride, lfi_n->blim[filter_level]);
+            }
+        }
 
-                    if (!skip_lf)
-                        vp8_loop_filter_simple_bv
-                        (y_ptr, post->y_stride, lfi_n->blim[filter_level]);
+        y_ptr += 16;
+        u_ptr += 8;
+        v_ptr += 8;
 
-                    /* don't apply across umv border */
-                    if (mb_row > 0)
-                        vp8_loop_filter_simple_mbh
-                        (y_ptr, post->y_stride, lfi_n->mblim[filter_level]);
+        mode_info_context++;     /* step to next MB */
+    }
+}
 
-                    if (!skip_lf)
-                        vp8_loop_filter_simple_bh
-                        (y_ptr, post->y_stride, lfi_n->blim[filter_level]);
-                }
-            }
+void vp8_loop_filter_frame
+(
+    VP8_COMMON *cm,
+    MACROBLOCKD *mbd
+)
+{
+    YV12_BUFFER_CONFIG *post = cm->frame_to_show;
 
-            y_ptr += 16;
-            u_ptr += 8;
-            v_ptr += 8;
+    int mb_row;
 
-            mode_info_context++;     /* step to next MB */
-        }
+#if CONFIG_OPENCL && ENABLE_CL_LOOPFILTER
+    if ( cl_initialized == CL_SUCCESS ){
+        vp8_loop_filter_frame_cl(cm,mbd);
+        return;
+    }
+#endif
 
-        y_ptr += post->y_stride  * 16 - post->y_width;
-        u_ptr += post->uv_stride *  8 - post->uv_width;
-        v_ptr += post->uv_stride *  8 - post->uv_width;
+    /* Initialize the loop filter for this frame. */
+    vp8_loop_filter_frame_init(cm, mbd, cm->filter_level);
 
-        mode_info_context++;         /* Skip border mb */
-    }
+    /* vp8_filter each macro block row */
+    for (mb_row = 0; mb_row < cm->mb_rows; mb_row++)
+        vp8_loop_filter_row(cm, post, mb_row);
 }
 
 void vp8_loop_filter_frame_yonly
@@ -322,8 +334,24 @@ void vp8_loop_filter_frame_yonly
     int default_filt_lvl
 )
 {
-    YV12_BUFFER_CONFIG *post = cm->frame_to_show;
+#if 0
+    if(default_filt_lvl == 0) /* no filter applied */
+        return;
+#endif
+
+    /* Initialize the loop filter for this frame. */
+    vp8_loop_filter_frame_init( cm, mbd, default_filt_lvl);
+
+    vp8_loop_filter_yonly(cm, cm->frame_to_show, cm->lf_info.lvl);
+}
 
+void vp8_loop_filter_yonly
+(
+    VP8_COMMON *cm,
+    YV12_BUFFER_CONFIG *post,
+    unsigned char lvl[4][4][4]
+)
+{
     unsigned char *y_ptr;
     int mb_row;
     int mb_col;
@@ -337,14 +365,6 @@ void vp8_loop_filter_frame_yonly
     /* Point at base of Mb MODE_INFO list */
     const MODE_INFO *mode_info_context = cm->mi;
 
-#if 0
-    if(default_filt_lvl == 0) /* no filter applied */
-        return;
-#endif
-
-    /* Initialize the loop filter for this frame. */
-    vp8_loop_filter_frame_init( cm, mbd, default_filt_lvl);
-
     /* Set up the buffer pointers */
     y_ptr = post->y_buffer;
 
@@ -361,7 +381,7 @@ void vp8_loop_filter_frame_yonly
             const int seg = mode_info_context->mbmi.segment_id;
             const int ref_frame = mode_info_context->mbmi.ref_frame;
 
-            filter_level = lfi_n->lvl[seg][ref_frame][mode_index];
+            filter_level = lvl[seg][ref_frame][mode_index];
 
             if (filter_level)
             {
@@ -69,6 +69,7 @@ typedef void loop_filter_uvfunction
 /* assorted loopfilter functions which get used elsewhere */
 struct VP8Common;
 struct macroblockd;
+struct yv12_buffer_config;
 
 void vp8_loop_filter_init(struct VP8Common *cm);
 
@@ -78,6 +79,13 @@ void vp8_loop_filter_frame_init(struct VP8Common *cm,
 
 void vp8_loop_filter_frame(struct VP8Common *cm, struct macroblockd *mbd);
 
+/* Filters a single MB row of post. The caller is responsible for calling
+ * vp8_loop_filter_frame_init() first, and for filtering the rows in order.
+ */
+void vp8_loop_filter_row(struct VP8Common *cm,
+                         struct yv12_buffer_config *post,
+                         int mb_row);
+
 void vp8_loop_filter_partial_frame(struct VP8Common *cm,
                                    struct macroblockd *mbd,
                                    int default_filt_lvl);
@@ -86,6 +94,21 @@ void vp8_loop_filter_frame_yonly(struct VP8Common *cm,
                                  struct macroblockd *mbd,
                                  int default_filt_lvl);
 
+/* Fills lvl with the filter level of each segment, reference frame and
+ * mode, for a frame filtered at default_filt_lvl.
+ */
+void vp8_loop_filter_lvl_init(unsigned char lvl[4][4][4],
+                              struct macroblockd *mbd,
+                              int default_filt_lvl);
+
+/* Filters the Y plane of post at the levels of lvl, leaving cm untouched,
+ * so that several levels can be tried at once on different buffers. The
+ * caller is responsible for the sharpness of cm->lf_info being current.
+ */
+void vp8_loop_filter_yonly(struct VP8Common *cm,
+                           struct yv12_buffer_config *post,
+                           unsigned char lvl[4][4][4]);
+
 void vp8_loop_filter_update_sharpness(loop_filter_info_n *lfi,
                                       int sharpness_lvl);
 
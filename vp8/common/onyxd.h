@@ -22,6 +22,7 @@ extern "C"
 #include "ppflags.h"
 #include "vpx_ports/mem.h"
 #include "vpx/vpx_codec.h"
+#include "vpx/vpx_decoder.h"
 
     struct VP8D_COMP;
 
@@ -34,6 +35,11 @@ extern "C"
         int     max_threads;
         int     error_concealment;
         int     input_fragments;
+        int     frame_threading;
+        int     thread_pool;
+        vpx_get_frame_buffer_cb_fn_t     get_fb_cb;
+        vpx_release_frame_buffer_cb_fn_t release_fb_cb;
+        void   *fb_cb_priv;
     } VP8D_CONFIG;
     typedef enum
     {
@@ -17,6 +17,7 @@
 #include "vpx_scale/yv12extend.h"
 #include "vpx_scale/vpxscale.h"
 #include "systemdependent.h"
+#include "vpx_mem/vpx_mem.h"
 #include "../encoder/variance.h"
 
 #include <math.h>
@@ -29,7 +30,6 @@
     ( (0.439*(float)(t>>16)) - (0.368*(float)(t>>8&0xff)) - (0.071*(float)(t&0xff)) + 128)
 
 /* global constants */
-#define MFQE_PRECISION 4
 #if CONFIG_POSTPROC_VISUALIZER
 static const unsigned char MB_PREDICTION_MODE_colors[MB_MODE_COUNT][3] =
 {
@@ -325,26 +325,57 @@ void vp8_mbpost_proc_down_c(unsigned char *dst, int pitch, int rows, int cols, i
 }
 
 
-static void vp8_deblock_and_de_macro_block(YV12_BUFFER_CONFIG         *source,
-        YV12_BUFFER_CONFIG         *post,
-        int                         q,
-        int                         low_var_thresh,
-        int                         flag)
+/* Runs steps [row_start, row_end) of vp8_mbpost_proc_down_c(), which is
+ * resumed where the previous call stopped. Step r filters row r and writes
+ * the row filtered 8 steps earlier, which waits in pending, to row r - 8.
+ * Rows up to row_end + 6 must be ready, and the borders replicated.
+ */
+void vp8_mbpost_proc_down_band_c(unsigned char *dst, int pitch, int row_start,
+                                 int row_end, int cols, int flimit,
+                                 unsigned char *pending, const short *rv)
 {
-    double level = 6.0e-05 * q * q * q - .0067 * q * q + .306 * q + .0065;
-    int ppl = (int)(level + .5);
-    (void) low_var_thresh;
-    (void) flag;
+    int r, c, i;
+
+    for (c = 0; c < cols; c++)
+    {
+        unsigned char *s = &dst[c];
+        unsigned char *p = &pending[c];
+        int sumsq = 0;
+        int sum   = 0;
+        const short *rv2 = rv + ((c * 17) & 127);
 
-    vp8_post_proc_down_and_across(source->y_buffer, post->y_buffer, source->y_stride,  post->y_stride, source->y_height, source->y_width,  ppl);
-    vp8_mbpost_proc_across_ip(post->y_buffer, post->y_stride, post->y_height, post->y_width, q2mbl(q));
-    vp8_mbpost_proc_down(post->y_buffer, post->y_stride, post->y_height, post->y_width, q2mbl(q));
+        for (i = row_start - 8; i <= row_start + 6; i++)
+        {
+            sumsq += s[i*pitch] * s[i*pitch];
+            sum   += s[i*pitch];
+        }
 
-    vp8_post_proc_down_and_across(source->u_buffer, post->u_buffer, source->uv_stride, post->uv_stride, source->uv_height, source->uv_width, ppl);
-    vp8_post_proc_down_and_across(source->v_buffer, post->v_buffer, source->uv_stride, post->uv_stride, source->uv_height, source->uv_width, ppl);
+        s += row_start * pitch;
 
+        for (r = row_start; r < row_end; r++)
+        {
+            unsigned char out = p[(r&7)*cols];
+            unsigned char v = s[0];
+
+            sumsq += s[7*pitch] * s[ 7*pitch] - s[-8*pitch] * s[-8*pitch];
+            sum  += s[7*pitch] - s[-8*pitch];
+
+            if (sumsq * 15 - sum * sum < flimit)
+            {
+                v = (rv2[r&127] + sum + s[0]) >> 4;
+            }
+
+            p[(r&7)*cols] = v;
+
+            if (r >= 8)
+                s[-8*pitch] = out;
+
+            s += pitch;
+        }
+    }
 }
 
+
 void vp8_deblock(YV12_BUFFER_CONFIG         *source,
                  YV12_BUFFER_CONFIG         *post,
                  int                         q,
@@ -693,219 +724,243 @@ static void constrain_line (int x0, int *x1, int y0, int *y1, int width, int hei
 }
 
 
-static void multiframe_quality_enhance_block
-(
-    int blksize, /* Currently only values supported are 16, 8, 4 */
-    int qcurr,
-    int qprev,
-    unsigned char *y,
-    unsigned char *u,
-    unsigned char *v,
-    int y_stride,
-    int uv_stride,
-    unsigned char *yd,
-    unsigned char *ud,
-    unsigned char *vd,
-    int yd_stride,
-    int uvd_stride
-)
+/* Splits units into num_bands bands and returns those of band. */
+static void band_range(int band, int num_bands, int units, int *start, int *end)
 {
-    static const unsigned char VP8_ZEROS[16]=
-    {
-         0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
-    };
-    int blksizeby2 = blksize >> 1;
-    int qdiff = qcurr - qprev;
+    *start = units * band / num_bands;
+    *end = units * (band + 1) / num_bands;
+}
 
-    int i, j;
-    unsigned char *yp;
-    unsigned char *ydp;
-    unsigned char *up;
-    unsigned char *udp;
-    unsigned char *vp;
-    unsigned char *vdp;
-
-    unsigned int act, sse, sad, thr;
-    if (blksize == 16)
+static void mfqe_band(vp8_pp_pass_t *pass, int band)
+{
+    int start, end;
+
+    band_range(band, pass->num_bands, pass->oci->mb_rows, &start, &end);
+    vp8_multiframe_quality_enhance_rows(pass->oci, start, end);
+}
+
+/* Deblocks the MB rows of the band from source into post. The rows of a
+ * band depend only on source, so bands are independent.
+ */
+static void deblock_band(vp8_pp_pass_t *pass, int band)
+{
+    YV12_BUFFER_CONFIG *source = pass->source;
+    YV12_BUFFER_CONFIG *post = pass->post;
+    int start, end, y_offset, uv_offset, post_y_offset, post_uv_offset;
+
+    band_range(band, pass->num_bands, source->y_height >> 4, &start, &end);
+    y_offset = start * 16 * source->y_stride;
+    uv_offset = start * 8 * source->uv_stride;
+    post_y_offset = start * 16 * post->y_stride;
+    post_uv_offset = start * 8 * post->uv_stride;
+
+    vp8_post_proc_down_and_across(source->y_buffer + y_offset, post->y_buffer + post_y_offset, source->y_stride,  post->y_stride, (end - start) * 16, source->y_width,  pass->ppl);
+
+    if (pass->mbl)
+        vp8_mbpost_proc_across_ip(post->y_buffer + post_y_offset, post->y_stride, (end - start) * 16, post->y_width, pass->mbl);
+
+    vp8_post_proc_down_and_across(source->u_buffer + uv_offset, post->u_buffer + post_uv_offset, source->uv_stride, post->uv_stride, (end - start) * 8, source->uv_width, pass->ppl);
+    vp8_post_proc_down_and_across(source->v_buffer + uv_offset, post->v_buffer + post_uv_offset, source->uv_stride, post->uv_stride, (end - start) * 8, source->uv_width, pass->ppl);
+}
+
+/* The vertical demacroblocking filter works in place on whole columns, so
+ * its bands are strips of columns. Strips are 128 columns wide, which is
+ * the period of the dither of the C version, so with the dither of the
+ * frame each strip filters its columns as the whole frame pass does.
+ */
+static void demacroblock_down_band(vp8_pp_pass_t *pass, int band)
+{
+    YV12_BUFFER_CONFIG *post = pass->post;
+    DECLARE_ALIGNED_ARRAY(16, unsigned char, pending, 8 * 128);
+    unsigned char *y;
+    int pitch = post->y_stride;
+    int rows = post->y_height;
+    int start, end, cols, i;
+
+    band_range(band, pass->num_bands, (post->y_width + 127) >> 7, &start, &end);
+    start <<= 7;
+    end <<= 7;
+
+    if (end > post->y_width)
+        end = post->y_width;
+
+    y = post->y_buffer + start;
+    cols = end - start;
+
+    for (i = -8; i < 0; i++)
+        vpx_memcpy(y + i * pitch, y, cols);
+
+    for (i = rows; i < rows + 8; i++)
+        vpx_memcpy(y + i * pitch, y + (rows - 1) * pitch, cols);
+
+    vp8_mbpost_proc_down_band(y, pitch, 0, rows, cols, pass->mbl, pending,
+                              pass->rv);
+
+    /* the last 8 rows are still pending */
+    for (i = rows; i < rows + 8; i++)
+        vpx_memcpy(y + (i - 8) * pitch, pending + (i & 7) * cols, cols);
+}
+
+static void copy_band(vp8_pp_pass_t *pass, int band)
+{
+    YV12_BUFFER_CONFIG *source = pass->source;
+    YV12_BUFFER_CONFIG *post = pass->post;
+    int start, end, row;
+
+    band_range(band, pass->num_bands, source->y_height >> 4, &start, &end);
+
+    for (row = start * 16; row < end * 16; row++)
+        vpx_memcpy(post->y_buffer + row * post->y_stride,
+                   source->y_buffer + row * source->y_stride, source->y_width);
+
+    for (row = start * 8; row < end * 8; row++)
     {
-        act = (vp8_variance16x16(yd, yd_stride, VP8_ZEROS, 0, &sse)+128)>>8;
-        sad = (vp8_sad16x16(y, y_stride, yd, yd_stride, 0)+128)>>8;
+        vpx_memcpy(post->u_buffer + row * post->uv_stride,
+                   source->u_buffer + row * source->uv_stride, source->uv_width);
+        vpx_memcpy(post->v_buffer + row * post->uv_stride,
+                   source->v_buffer + row * source->uv_stride, source->uv_width);
     }
-    else if (blksize == 8)
+}
+
+static void add_noise_band(vp8_pp_pass_t *pass, int band)
+{
+    YV12_BUFFER_CONFIG *post = pass->post;
+    struct postproc_state *state = &pass->oci->postproc_state;
+    int start, end;
+
+    band_range(band, pass->num_bands, post->y_height >> 4, &start, &end);
+
+    vp8_plane_add_noise
+    (post->y_buffer + start * 16 * post->y_stride,
+     state->noise,
+     state->blackclamp,
+     state->whiteclamp,
+     state->bothclamp,
+     post->y_width, (end - start) * 16,
+     post->y_stride);
+}
+
+/* Runs fn over units, in bands on the runner when there is one. */
+static void run_pass(vp8_pp_pass_t *pass,
+                     void (*fn)(vp8_pp_pass_t *pass, int band), int units)
+{
+    pass->fn = fn;
+
+    if (pass->run && units > 1)
     {
-        act = (vp8_variance8x8(yd, yd_stride, VP8_ZEROS, 0, &sse)+32)>>6;
-        sad = (vp8_sad8x8(y, y_stride, yd, yd_stride, 0)+32)>>6;
+        pass->num_bands = units;
+        pass->run(pass->run_ctx, pass);
     }
     else
     {
-        act = (vp8_variance4x4(yd, yd_stride, VP8_ZEROS, 0, &sse)+8)>>4;
-        sad = (vp8_sad4x4(y, y_stride, yd, yd_stride, 0)+8)>>4;
+        pass->num_bands = 1;
+        fn(pass, 0);
     }
-    /* thr = qdiff/8 + log2(act) + log4(qprev) */
-    thr = (qdiff>>3);
-    while (act>>=1) thr++;
-    while (qprev>>=2) thr++;
-    if (sad < thr)
+}
+
+/* Deblocks and demacroblocks a frame in a single pass over its MB rows.
+ * The vertical demacroblocking filter follows 7 rows behind the deblocked
+ * rows, so that it works on them while they are still in the cache.
+ * Returns non-zero if its buffer cannot be allocated.
+ */
+static int deblock_and_de_macro_block_fused(vp8_pp_pass_t *pass)
+{
+    YV12_BUFFER_CONFIG *post = pass->post;
+    struct postproc_state *state = &pass->oci->postproc_state;
+    unsigned char *y = post->y_buffer;
+    int pitch = post->y_stride;
+    int rows = post->y_height;
+    int cols = post->y_width;
+    int band, row_start = 0, i;
+
+    if (state->pending_cols < cols)
     {
-        static const int roundoff = (1 << (MFQE_PRECISION - 1));
-        int ifactor = (sad << MFQE_PRECISION) / thr;
-        ifactor >>= (qdiff >> 5);
-        // TODO: SIMD optimize this section
-        if (ifactor)
-        {
-            int icfactor = (1 << MFQE_PRECISION) - ifactor;
-            for (yp = y, ydp = yd, i = 0; i < blksize; ++i, yp += y_stride, ydp += yd_stride)
-            {
-                for (j = 0; j < blksize; ++j)
-                    ydp[j] = (int)((yp[j] * ifactor + ydp[j] * icfactor + roundoff) >> MFQE_PRECISION);
-            }
-            for (up = u, udp = ud, i = 0; i < blksizeby2; ++i, up += uv_stride, udp += uvd_stride)
-            {
-                for (j = 0; j < blksizeby2; ++j)
-                    udp[j] = (int)((up[j] * ifactor + udp[j] * icfactor + roundoff) >> MFQE_PRECISION);
-            }
-            for (vp = v, vdp = vd, i = 0; i < blksizeby2; ++i, vp += uv_stride, vdp += uvd_stride)
-            {
-                for (j = 0; j < blksizeby2; ++j)
-                    vdp[j] = (int)((vp[j] * ifactor + vdp[j] * icfactor + roundoff) >> MFQE_PRECISION);
-            }
-        }
+        vpx_free(state->pending_rows);
+        state->pending_rows = vpx_malloc(8 * cols);
+        state->pending_cols = state->pending_rows ? cols : 0;
+
+        if (!state->pending_rows)
+            return -1;
     }
-    else
+
+    pass->num_bands = pass->source->y_height >> 4;
+
+    for (band = 0; band < pass->num_bands; band++)
     {
-        if (blksize == 16)
-        {
-            vp8_copy_mem16x16(y, y_stride, yd, yd_stride);
-            vp8_copy_mem8x8(u, uv_stride, ud, uvd_stride);
-            vp8_copy_mem8x8(v, uv_stride, vd, uvd_stride);
-        }
-        else if (blksize == 8)
+        int row_end = (band + 1) * 16 - 7;
+
+        deblock_band(pass, band);
+
+        if (band == 0)
         {
-            vp8_copy_mem8x8(y, y_stride, yd, yd_stride);
-            for (up = u, udp = ud, i = 0; i < blksizeby2; ++i, up += uv_stride, udp += uvd_stride)
-                vpx_memcpy(udp, up, blksizeby2);
-            for (vp = v, vdp = vd, i = 0; i < blksizeby2; ++i, vp += uv_stride, vdp += uvd_stride)
-                vpx_memcpy(vdp, vp, blksizeby2);
+            for (i = -8; i < 0; i++)
+                vpx_memcpy(y + i * pitch, y, cols);
         }
-        else
+
+        if (band == pass->num_bands - 1)
         {
-            for (yp = y, ydp = yd, i = 0; i < blksize; ++i, yp += y_stride, ydp += yd_stride)
-                vpx_memcpy(ydp, yp, blksize);
-            for (up = u, udp = ud, i = 0; i < blksizeby2; ++i, up += uv_stride, udp += uvd_stride)
-                vpx_memcpy(udp, up, blksizeby2);
-            for (vp = v, vdp = vd, i = 0; i < blksizeby2; ++i, vp += uv_stride, vdp += uvd_stride)
-                vpx_memcpy(vdp, vp, blksizeby2);
+            for (i = rows; i < rows + 8; i++)
+                vpx_memcpy(y + i * pitch, y + (rows - 1) * pitch, cols);
+
+            row_end = rows;
         }
+
+        vp8_mbpost_proc_down_band(y, pitch, row_start, row_end, cols,
+                                  pass->mbl, state->pending_rows, pass->rv);
+        row_start = row_end;
     }
+
+    /* the last 8 rows are still pending */
+    for (i = rows; i < rows + 8; i++)
+        vpx_memcpy(y + (i - 8) * pitch, state->pending_rows + (i & 7) * cols,
+                   cols);
+
+    return 0;
 }
 
-void vp8_multiframe_quality_enhance
-(
-    VP8_COMMON *cm
-)
+static void deblock_frame(vp8_pp_pass_t *pass, YV12_BUFFER_CONFIG *source,
+                          YV12_BUFFER_CONFIG *post, int q, int demacroblock)
 {
-    YV12_BUFFER_CONFIG *show = cm->frame_to_show;
-    YV12_BUFFER_CONFIG *dest = &cm->post_proc_buffer;
-
-    FRAME_TYPE frame_type = cm->frame_type;
-    /* Point at base of Mb MODE_INFO list has motion vectors etc */
-    const MODE_INFO *mode_info_context = cm->mi;
-    int mb_row;
-    int mb_col;
-    int qcurr = cm->base_qindex;
-    int qprev = cm->postproc_state.last_base_qindex;
-
-    unsigned char *y_ptr, *u_ptr, *v_ptr;
-    unsigned char *yd_ptr, *ud_ptr, *vd_ptr;
-
-    /* Set up the buffer pointers */
-    y_ptr = show->y_buffer;
-    u_ptr = show->u_buffer;
-    v_ptr = show->v_buffer;
-    yd_ptr = dest->y_buffer;
-    ud_ptr = dest->u_buffer;
-    vd_ptr = dest->v_buffer;
-
-    /* postprocess each macro block */
-    for (mb_row = 0; mb_row < cm->mb_rows; mb_row++)
-    {
-        for (mb_col = 0; mb_col < cm->mb_cols; mb_col++)
-        {
-            /* if motion is high there will likely be no benefit */
-            if (((frame_type == INTER_FRAME &&
-                  abs(mode_info_context->mbmi.mv.as_mv.row) <= 10 &&
-                  abs(mode_info_context->mbmi.mv.as_mv.col) <= 10) ||
-                 (frame_type == KEY_FRAME)))
-            {
-                if (mode_info_context->mbmi.mode == B_PRED || mode_info_context->mbmi.mode == SPLITMV)
-                {
-                    int i, j;
-                    for (i=0; i<2; ++i)
-                        for (j=0; j<2; ++j)
-                            multiframe_quality_enhance_block(8,
-                                                             qcurr,
-                                                             qprev,
-                                                             y_ptr + 8*(i*show->y_stride+j),
-                                                             u_ptr + 4*(i*show->uv_stride+j),
-                                                             v_ptr + 4*(i*show->uv_stride+j),
-                                                             show->y_stride,
-                                                             show->uv_stride,
-                                                             yd_ptr + 8*(i*dest->y_stride+j),
-                                                             ud_ptr + 4*(i*dest->uv_stride+j),
-                                                             vd_ptr + 4*(i*dest->uv_stride+j),
-                                                             dest->y_stride,
-                                                             dest->uv_stride);
-                }
-                else
-                {
-                    multiframe_quality_enhance_block(16,
-                                                     qcurr,
-                                                     qprev,
-                                                     y_ptr,
-                                                     u_ptr,
-                                                     v_ptr,
-                                                     show->y_stride,
-                                                     show->uv_stride,
-                                                     yd_ptr,
-                                                     ud_ptr,
-                                                     vd_ptr,
-                                                     dest->y_stride,
-                                                     dest->uv_stride);
+    double level = 6.0e-05 * q * q * q - .0067 * q * q + .306 * q + .0065;
 
-                }
-            }
-            else
-            {
-                vp8_copy_mem16x16(y_ptr, show->y_stride, yd_ptr, dest->y_stride);
-                vp8_copy_mem8x8(u_ptr, show->uv_stride, ud_ptr, dest->uv_stride);
-                vp8_copy_mem8x8(v_ptr, show->uv_stride, vd_ptr, dest->uv_stride);
-            }
-            y_ptr += 16;
-            u_ptr += 8;
-            v_ptr += 8;
-            yd_ptr += 16;
-            ud_ptr += 8;
-            vd_ptr += 8;
-            mode_info_context++;     /* step to next MB */
-        }
+    pass->source = source;
+    pass->post = post;
+    pass->ppl = (int)(level + .5);
+    pass->mbl = demacroblock ? q2mbl(q) : 0;
 
-        y_ptr += show->y_stride  * 16 - 16 * cm->mb_cols;
-        u_ptr += show->uv_stride *  8 - 8 * cm->mb_cols;
-        v_ptr += show->uv_stride *  8 - 8 * cm->mb_cols;
-        yd_ptr += dest->y_stride  * 16 - 16 * cm->mb_cols;
-        ud_ptr += dest->uv_stride *  8 - 8 * cm->mb_cols;
-        vd_ptr += dest->uv_stride *  8 - 8 * cm->mb_cols;
+    /* The dither is picked here, on the calling thread, so that the bands
+     * share it and the rand() sequence does not depend on the threads.
+     */
+    if (demacroblock)
+        pass->rv = &vp8_rv[63&rand()];
 
-        mode_info_context++;         /* Skip border mb */
-    }
+    /* Bands run in parallel cannot be fused, as the vertical filter needs
+     * the rows of the next band.
+     */
+    if (demacroblock && !pass->run &&
+        !deblock_and_de_macro_block_fused(pass))
+        return;
+
+    run_pass(pass, deblock_band, source->y_height >> 4);
+
+    if (demacroblock)
+        run_pass(pass, demacroblock_down_band, (post->y_width + 127) >> 7);
 }
 
 int vp8_post_proc_frame(VP8_COMMON *oci, YV12_BUFFER_CONFIG *dest, vp8_ppflags_t *ppflags)
+{
+    return vp8_post_proc_frame_mt(oci, dest, ppflags, NULL, NULL);
+}
+
+int vp8_post_proc_frame_mt(VP8_COMMON *oci, YV12_BUFFER_CONFIG *dest,
+                           vp8_ppflags_t *ppflags,
+                           vp8_pp_runner_fn_t run, void *run_ctx)
 {
     int q = oci->filter_level * 10 / 6;
     int flags = ppflags->post_proc_flag;
     int deblock_level = ppflags->deblocking_level;
     int noise_level = ppflags->noise_level;
+    vp8_pp_pass_t pass;
 
     if (!oci->frame_to_show)
         return -1;
@@ -925,19 +980,18 @@ int vp8_post_proc_frame(VP8_COMMON *oci, YV12_BUFFER_CONFIG *dest, vp8_ppflags_t
         return 0;
     }
 
-    /* Allocate post_proc_buffer_int if needed */
-    if ((flags & VP8D_MFQE) && !oci->post_proc_buffer_int_used)
+    /* Allocate the MFQE buffer if needed */
+    if ((flags & VP8D_MFQE) && !oci->postproc_state.mfqe_buffer_used)
     {
         if ((flags & VP8D_DEBLOCK) || (flags & VP8D_DEMACROBLOCK))
         {
-            if (vp8_yv12_alloc_frame_buffer(&oci->post_proc_buffer_int, oci->Width, oci->Height, VP8BORDERINPIXELS) >= 0)
+            if (vp8_yv12_alloc_frame_buffer(&oci->postproc_state.mfqe_buffer,
+                                            oci->post_proc_buffer.y_width,
+                                            oci->post_proc_buffer.y_height,
+                                            VP8BORDERINPIXELS) >= 0)
             {
-                oci->post_proc_buffer_int_used = 1;
+                oci->postproc_state.mfqe_buffer_used = 1;
             }
-            // insure that postproc is set to all 0's so that post proc
-            // doesn't pull random data in from edge
-            vpx_memset((&oci->post_proc_buffer_int)->buffer_alloc,126,(&oci->post_proc_buffer)->frame_size);
-
         }
     }
 
@@ -945,44 +999,59 @@ int vp8_post_proc_frame(VP8_COMMON *oci, YV12_BUFFER_CONFIG *dest, vp8_ppflags_t
     vpx_reset_mmx_state();
 #endif
 
+    vpx_memset(&pass, 0, sizeof(pass));
+    pass.oci = oci;
+    pass.run = run;
+    pass.run_ctx = run_ctx;
+
     if ((flags & VP8D_MFQE) &&
          oci->current_video_frame >= 2 &&
          oci->base_qindex - oci->postproc_state.last_base_qindex >= 10)
     {
-        vp8_multiframe_quality_enhance(oci);
+        run_pass(&pass, mfqe_band, oci->mb_rows);
         if (((flags & VP8D_DEBLOCK) || (flags & VP8D_DEMACROBLOCK)) &&
-            oci->post_proc_buffer_int_used)
+            oci->postproc_state.mfqe_buffer_used)
         {
-            vp8_yv12_copy_frame_ptr(&oci->post_proc_buffer, &oci->post_proc_buffer_int);
+            /* Deblock the enhanced frame into the MFQE buffer and swap the
+             * two, rather than copying the enhanced frame out first.
+             */
+            YV12_BUFFER_CONFIG temp = oci->post_proc_buffer;
+
+            vp8_yv12_extend_frame_borders_ptr(&oci->post_proc_buffer);
             if (flags & VP8D_DEMACROBLOCK)
             {
-                vp8_deblock_and_de_macro_block(&oci->post_proc_buffer_int, &oci->post_proc_buffer,
-                                               q + (deblock_level - 5) * 10, 1, 0);
+                deblock_frame(&pass, &oci->post_proc_buffer,
+                              &oci->postproc_state.mfqe_buffer,
+                              q + (deblock_level - 5) * 10, 1);
             }
             else if (flags & VP8D_DEBLOCK)
             {
-                vp8_deblock(&oci->post_proc_buffer_int, &oci->post_proc_buffer,
-                            q, 1, 0);
+                deblock_frame(&pass, &oci->post_proc_buffer,
+                              &oci->postproc_state.mfqe_buffer, q, 0);
             }
+            oci->post_proc_buffer = oci->postproc_state.mfqe_buffer;
+            oci->postproc_state.mfqe_buffer = temp;
         }
         /* Move partially towards the base q of the previous frame */
         oci->postproc_state.last_base_qindex = (3*oci->postproc_state.last_base_qindex + oci->base_qindex)>>2;
     }
     else if (flags & VP8D_DEMACROBLOCK)
     {
-        vp8_deblock_and_de_macro_block(oci->frame_to_show, &oci->post_proc_buffer,
-                                       q + (deblock_level - 5) * 10, 1, 0);
+        deblock_frame(&pass, oci->frame_to_show, &oci->post_proc_buffer,
+                      q + (deblock_level - 5) * 10, 1);
         oci->postproc_state.last_base_qindex = oci->base_qindex;
     }
     else if (flags & VP8D_DEBLOCK)
     {
-        vp8_deblock(oci->frame_to_show, &oci->post_proc_buffer,
-                    q, 1, 0);
+        deblock_frame(&pass, oci->frame_to_show, &oci->post_proc_buffer, q, 0);
         oci->postproc_state.last_base_qindex = oci->base_qindex;
     }
     else
     {
-        vp8_yv12_copy_frame_ptr(oci->frame_to_show, &oci->post_proc_buffer);
+        pass.source = oci->frame_to_show;
+        pass.post = &oci->post_proc_buffer;
+        run_pass(&pass, copy_band, oci->frame_to_show->y_height >> 4);
+        vp8_yv12_extend_frame_borders_ptr(&oci->post_proc_buffer);
         oci->postproc_state.last_base_qindex = oci->base_qindex;
     }
 
@@ -994,14 +1063,8 @@ int vp8_post_proc_frame(VP8_COMMON *oci, YV12_BUFFER_CONFIG *dest, vp8_ppflags_t
             fillrd(&oci->postproc_state, 63 - q, noise_level);
         }
 
-        vp8_plane_add_noise
-        (oci->post_proc_buffer.y_buffer,
-         oci->postproc_state.noise,
-         oci->postproc_state.blackclamp,
-         oci->postproc_state.whiteclamp,
-         oci->postproc_state.bothclamp,
-         oci->post_proc_buffer.y_width, oci->post_proc_buffer.y_height,
-         oci->post_proc_buffer.y_stride);
+        pass.post = &oci->post_proc_buffer;
+        run_pass(&pass, add_noise_band, oci->post_proc_buffer.y_height >> 4);
     }
 
 #if CONFIG_POSTPROC_VISUALIZER
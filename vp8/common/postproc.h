@@ -13,12 +13,17 @@
 #define POSTPROC_H
 
 #include "vpx_ports/mem.h"
+#include "vpx_scale/yv12config.h"
 struct postproc_state
 {
     int           last_q;
     int           last_noise;
     char          noise[3072];
     int           last_base_qindex;
+    YV12_BUFFER_CONFIG mfqe_buffer;     /* MFQE output before deblocking */
+    int           mfqe_buffer_used;
+    unsigned char *pending_rows;        /* 8 rows of the vertical filter */
+    int           pending_cols;
     DECLARE_ALIGNED(16, char, blackclamp[16]);
     DECLARE_ALIGNED(16, char, whiteclamp[16]);
     DECLARE_ALIGNED(16, char, bothclamp[16]);
@@ -28,6 +33,47 @@ struct postproc_state
 int vp8_post_proc_frame(struct VP8Common *oci, YV12_BUFFER_CONFIG *dest,
                         vp8_ppflags_t *flags);
 
+/* A pass of postprocessing. It is split into num_bands bands, of MB rows
+ * or of columns, that do not depend on one another, and fn(pass, band)
+ * processes a band.
+ */
+typedef struct vp8_pp_pass
+{
+    void (*fn)(struct vp8_pp_pass *pass, int band);
+    int num_bands;
+
+    struct VP8Common *oci;
+    YV12_BUFFER_CONFIG *source;
+    YV12_BUFFER_CONFIG *post;
+    int ppl;                            /* deblocking filter limit */
+    int mbl;                            /* demacroblocking limit, or 0 */
+    const short *rv;                    /* demacroblocking dither */
+
+    void (*run)(void *run_ctx, struct vp8_pp_pass *pass);
+    void *run_ctx;
+} vp8_pp_pass_t;
+
+/* Runs all the bands of pass before returning, in any order and on any
+ * threads.
+ */
+typedef void (*vp8_pp_runner_fn_t)(void *run_ctx, vp8_pp_pass_t *pass);
+
+/* Like vp8_post_proc_frame(), with the passes split into bands and run by
+ * run. The output is the same bit for bit, except for the noise, which
+ * comes from rand().
+ */
+int vp8_post_proc_frame_mt(struct VP8Common *oci, YV12_BUFFER_CONFIG *dest,
+                           vp8_ppflags_t *flags,
+                           vp8_pp_runner_fn_t run, void *run_ctx);
+
+
+/* Blends the blocks of the frame to show that did not change much into the
+ * previous postprocessed frame in post_proc_buffer. The pass can run on
+ * separate MB rows.
+ */
+void vp8_multiframe_quality_enhance(struct VP8Common *cm);
+void vp8_multiframe_quality_enhance_rows(struct VP8Common *cm,
+                                         int mb_row_start, int mb_row_end);
 
 void vp8_de_noise(YV12_BUFFER_CONFIG         *source,
                   YV12_BUFFER_CONFIG         *post,
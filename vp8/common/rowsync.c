@@ -0,0 +1,106 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#include "rowsync.h"
+
+#define MIN_SPIN_COUNT 16
+#define MAX_SPIN_COUNT 4096
+
+int vp8_row_sync_init(VP8_ROW_SYNC *sync)
+{
+    sync->waiters = 0;
+    sync->spin_count = MIN_SPIN_COUNT * 4;
+
+    if (pthread_mutex_init(&sync->mutex, NULL))
+        return -1;
+
+    if (pthread_cond_init(&sync->cond, NULL))
+    {
+        pthread_mutex_destroy(&sync->mutex);
+        return -1;
+    }
+
+    return 0;
+}
+
+void vp8_row_sync_destroy(VP8_ROW_SYNC *sync)
+{
+    pthread_cond_destroy(&sync->cond);
+    pthread_mutex_destroy(&sync->mutex);
+}
+
+void vp8_row_sync_wait(VP8_ROW_SYNC *sync, volatile const int *progress,
+                       int value)
+{
+    int spin_count, i;
+
+    if (atomic_load_acquire(progress) >= value)
+        return;
+
+    /* The spin count is shared by all waiters and updated without locking;
+     * it is only a hint.
+     */
+    spin_count = atomic_load_acquire(&sync->spin_count);
+
+    for (i = 0; i < spin_count; i++)
+    {
+        x86_pause_hint();
+
+        if (atomic_load_acquire(progress) >= value)
+        {
+            /* Waits end while spinning: aim at twice their length. */
+            spin_count += (2 * i - spin_count) / 8;
+
+            if (spin_count < MIN_SPIN_COUNT)
+                spin_count = MIN_SPIN_COUNT;
+
+            if (spin_count > MAX_SPIN_COUNT)
+                spin_count = MAX_SPIN_COUNT;
+
+            atomic_store_release(&sync->spin_count, spin_count);
+            return;
+        }
+    }
+
+    /* Waits outlast the spinning: spin less, as it only burns CPU time. */
+    if (spin_count > MIN_SPIN_COUNT)
+        atomic_store_release(&sync->spin_count, spin_count - spin_count / 8);
+
+    /* The waiter count only changes under the mutex, but is read without it
+     * by vp8_row_sync_post().
+     */
+    pthread_mutex_lock(&sync->mutex);
+    atomic_store_release(&sync->waiters, sync->waiters + 1);
+
+    /* Pairs with the barrier in vp8_row_sync_post(): either the poster
+     * sees the waiter, or the waiter sees the new value.
+     */
+    atomic_full_barrier();
+
+    while (atomic_load_acquire(progress) < value)
+        pthread_cond_wait(&sync->cond, &sync->mutex);
+
+    atomic_store_release(&sync->waiters, sync->waiters - 1);
+    pthread_mutex_unlock(&sync->mutex);
+}
+
+void vp8_row_sync_post(VP8_ROW_SYNC *sync, volatile int *progress, int value)
+{
+    atomic_store_release(progress, value);
+    atomic_full_barrier();
+
+    if (atomic_load_acquire(&sync->waiters))
+    {
+        pthread_mutex_lock(&sync->mutex);
+        pthread_cond_broadcast(&sync->cond);
+        pthread_mutex_unlock(&sync->mutex);
+    }
+}
@@ -0,0 +1,49 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#ifndef __INC_ROWSYNC_H
+#define __INC_ROWSYNC_H
+
+#include "vpx_config.h"
+#include "threading.h"
+
+#if CONFIG_OS_SUPPORT && CONFIG_MULTITHREAD
+
+/* Waiting on progress counters, such as the last MB column finished in an
+ * MB row. A waiter spins for a while, as the counter usually advances soon,
+ * and then sleeps until the counter is posted, so that threads waiting on
+ * an oversubscribed machine do not take CPU time from the ones they wait
+ * for. The spin length adapts to how long waits turned out to be.
+ *
+ * Counters only increase, except when reset while no thread waits on them.
+ * One VP8_ROW_SYNC serves any number of counters.
+ */
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    volatile int waiters;
+    volatile int spin_count;
+} VP8_ROW_SYNC;
+
+int vp8_row_sync_init(VP8_ROW_SYNC *sync);
+void vp8_row_sync_destroy(VP8_ROW_SYNC *sync);
+
+/* Returns once *progress >= value. */
+void vp8_row_sync_wait(VP8_ROW_SYNC *sync, volatile const int *progress,
+                       int value);
+
+/* Sets *progress to value, waking the threads waiting on it. */
+void vp8_row_sync_post(VP8_ROW_SYNC *sync, volatile int *progress, int value);
+
+#endif /* CONFIG_OS_SUPPORT && CONFIG_MULTITHREAD */
+
+#endif
@@ -146,6 +146,9 @@ if [ "$CONFIG_POSTPROC" = "yes" ]; then
     specialize vp8_mbpost_proc_down mmx sse2
     vp8_mbpost_proc_down_sse2=vp8_mbpost_proc_down_xmm
 
+    prototype void vp8_mbpost_proc_down_band "unsigned char *dst, int pitch, int row_start, int row_end, int cols, int flimit, unsigned char *pending, const short *rv"
+    specialize vp8_mbpost_proc_down_band sse2
+
     prototype void vp8_mbpost_proc_across_ip "unsigned char *dst, int pitch, int rows, int cols,int flimit"
     specialize vp8_mbpost_proc_across_ip sse2
     vp8_mbpost_proc_across_ip_sse2=vp8_mbpost_proc_across_ip_xmm
@@ -166,6 +169,12 @@ if [ "$CONFIG_POSTPROC" = "yes" ]; then
 
     prototype void vp8_blend_b "unsigned char *y, unsigned char *u, unsigned char *v, int y1, int u1, int v1, int alpha, int stride"
     # no asm yet
+
+    prototype void vp8_filter_by_weight16x16 "unsigned char *src, int src_stride, unsigned char *dst, int dst_stride, int src_weight"
+    specialize vp8_filter_by_weight16x16 sse2
+
+    prototype void vp8_filter_by_weight8x8 "unsigned char *src, int src_stride, unsigned char *dst, int dst_stride, int src_weight"
+    specialize vp8_filter_by_weight8x8 sse2
 fi
 
 #
@@ -19,3 +19,7 @@ void vpx_reset_mmx_state(void);
 
 struct VP8Common;
 void vp8_machine_specific_config(struct VP8Common *);
+
+#if CONFIG_MULTITHREAD
+int vp8_get_cpu_count(void);
+#endif
@@ -33,6 +33,17 @@
 #define pthread_getspecific(ts_key) TlsGetValue(ts_key)
 #define pthread_setspecific(ts_key, value) TlsSetValue(ts_key, (void *)value)
 #define pthread_self() GetCurrentThreadId()
+#define pthread_mutex_t CRITICAL_SECTION
+#define pthread_mutex_init(mutex, attr) (InitializeCriticalSection(mutex), 0)
+#define pthread_mutex_destroy(mutex) DeleteCriticalSection(mutex)
+#define pthread_mutex_lock(mutex) EnterCriticalSection(mutex)
+#define pthread_mutex_unlock(mutex) LeaveCriticalSection(mutex)
+#define pthread_cond_t CONDITION_VARIABLE
+#define pthread_cond_init(cond, attr) (InitializeConditionVariable(cond), 0)
+#define pthread_cond_destroy(cond)
+#define pthread_cond_wait(cond, mutex) SleepConditionVariableCS(cond, mutex, INFINITE)
+#define pthread_cond_broadcast(cond) WakeAllConditionVariable(cond)
+#define pthread_cond_signal(cond) WakeConditionVariable(cond)
 #else
 #ifdef __APPLE__
 #include <mach/mach_init.h>
@@ -88,6 +99,30 @@
 #define x86_pause_hint()
 #endif
 
+/* Atomic access to ints shared between threads. A load-acquire sees all the
+ * writes made before the store-release of the value it reads. A fetch-add
+ * returns the previous value and is a full barrier.
+ */
+#if defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+#define atomic_load_acquire(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define atomic_store_release(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define atomic_full_barrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define atomic_fetch_add(p, v) __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST)
+#elif defined(__GNUC__)
+#define atomic_load_acquire(p) __sync_fetch_and_add(p, 0)
+#define atomic_store_release(p, v) do { __sync_synchronize(); *(p) = (v); } while (0)
+#define atomic_full_barrier() __sync_synchronize()
+#define atomic_fetch_add(p, v) __sync_fetch_and_add(p, v)
+#elif defined(_MSC_VER)
+#define atomic_load_acquire(p) InterlockedCompareExchange((volatile LONG *)(p), 0, 0)
+#define atomic_store_release(p, v) InterlockedExchange((volatile LONG *)(p), v)
+#define atomic_full_barrier() MemoryBarrier()
+#define atomic_fetch_add(p, v) InterlockedExchangeAdd((volatile LONG *)(p), v)
+#else
+#error "No atomic operations for this compiler"
+#endif
+
 #endif /* CONFIG_OS_SUPPORT && CONFIG_MULTITHREAD */
 
 #endif
@@ -0,0 +1,265 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#include "threadpool.h"
+#include "vpx_mem/vpx_mem.h"
+
+/* The pool instance and the size it is started with. */
+static VP8_THREAD_POOL *pool_instance;
+static int pool_size;
+static pthread_mutex_t pool_mutex;
+
+void vp8_thread_pool_init(void)
+{
+    pthread_mutex_init(&pool_mutex, NULL);
+}
+
+/* Takes the newest job of the worker's own queue, or else the oldest job
+ * of the first other queue that has one.
+ */
+static VP8_POOL_JOB *take_job(VP8_THREAD_POOL *pool, int self)
+{
+    int i;
+
+    for (i = 0; i < pool->num_workers; i++)
+    {
+        VP8_POOL_QUEUE *q = &pool->queues[(self + i) % pool->num_workers];
+        VP8_POOL_JOB *job;
+
+        pthread_mutex_lock(&q->mutex);
+
+        if (i == 0)
+        {
+            job = q->newest;
+
+            if (job)
+            {
+                q->newest = job->prev;
+
+                if (q->newest)
+                    q->newest->next = NULL;
+                else
+                    q->oldest = NULL;
+            }
+        }
+        else
+        {
+            job = q->oldest;
+
+            if (job)
+            {
+                q->oldest = job->next;
+
+                if (q->oldest)
+                    q->oldest->prev = NULL;
+                else
+                    q->newest = NULL;
+            }
+        }
+
+        pthread_mutex_unlock(&q->mutex);
+
+        if (job)
+        {
+            pthread_mutex_lock(&pool->mutex);
+            pool->pending--;
+            pthread_mutex_unlock(&pool->mutex);
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+static THREAD_FUNCTION thread_pool_worker(void *p_data)
+{
+    VP8_POOL_QUEUE *own = (VP8_POOL_QUEUE *)p_data;
+    VP8_THREAD_POOL *pool = own->pool;
+    const int self = (int)(own - pool->queues);
+
+    while (1)
+    {
+        VP8_POOL_JOB *job = take_job(pool, self);
+        int quit;
+
+        if (job)
+        {
+            job->fn(job->arg1, job->arg2);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->mutex);
+
+        while (!pool->pending && !pool->quit)
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+
+        quit = pool->quit && !pool->pending;
+        pthread_mutex_unlock(&pool->mutex);
+
+        if (quit)
+            break;
+    }
+
+    return 0;
+}
+
+static void destroy_pool(VP8_THREAD_POOL *pool, int started)
+{
+    int i;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (i = 0; i < started; i++)
+        pthread_join(pool->workers[i], NULL);
+
+    for (i = 0; i < pool->num_workers; i++)
+        pthread_mutex_destroy(&pool->queues[i].mutex);
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->mutex);
+    vpx_free(pool->queues);
+    vpx_free(pool->workers);
+    vpx_free(pool);
+}
+
+static VP8_THREAD_POOL *create_pool(int num_workers)
+{
+    VP8_THREAD_POOL *pool;
+    int i;
+
+    pool = vpx_calloc(1, sizeof(*pool));
+
+    if (!pool)
+        return NULL;
+
+    pool->workers = vpx_calloc(num_workers, sizeof(*pool->workers));
+    pool->queues = vpx_calloc(num_workers, sizeof(*pool->queues));
+
+    if (!pool->workers || !pool->queues ||
+        pthread_mutex_init(&pool->mutex, NULL))
+    {
+        vpx_free(pool->queues);
+        vpx_free(pool->workers);
+        vpx_free(pool);
+        return NULL;
+    }
+
+    if (pthread_cond_init(&pool->cond, NULL))
+    {
+        pthread_mutex_destroy(&pool->mutex);
+        vpx_free(pool->queues);
+        vpx_free(pool->workers);
+        vpx_free(pool);
+        return NULL;
+    }
+
+    /* Queue mutexes are created up front, so that destroy_pool() can
+     * tear down a pool whose workers failed to start.
+     */
+    for (i = 0; i < num_workers; i++)
+    {
+        pthread_mutex_init(&pool->queues[i].mutex, NULL);
+        pool->queues[i].pool = pool;
+    }
+
+    pool->num_workers = num_workers;
+
+    for (i = 0; i < num_workers; i++)
+    {
+        if (pthread_create(&pool->workers[i], 0, thread_pool_worker,
+                           &pool->queues[i]))
+        {
+            destroy_pool(pool, i);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+int vp8_thread_pool_set_size(int num_workers)
+{
+    int res = 0;
+
+    pthread_mutex_lock(&pool_mutex);
+
+    if (pool_instance && pool_instance->num_workers != num_workers)
+        res = -1;
+    else
+        pool_size = num_workers;
+
+    pthread_mutex_unlock(&pool_mutex);
+    return res;
+}
+
+VP8_THREAD_POOL *vp8_thread_pool_acquire(int default_workers)
+{
+    VP8_THREAD_POOL *pool;
+
+    pthread_mutex_lock(&pool_mutex);
+
+    if (!pool_instance)
+        pool_instance = create_pool(pool_size > 0 ? pool_size
+                                                  : default_workers);
+
+    pool = pool_instance;
+
+    if (pool)
+        pool->users++;
+
+    pthread_mutex_unlock(&pool_mutex);
+    return pool;
+}
+
+void vp8_thread_pool_release(VP8_THREAD_POOL *pool)
+{
+    int last;
+
+    pthread_mutex_lock(&pool_mutex);
+
+    last = (--pool->users == 0);
+
+    if (last)
+        pool_instance = NULL;
+
+    pthread_mutex_unlock(&pool_mutex);
+
+    if (last)
+        destroy_pool(pool, pool->num_workers);
+}
+
+void vp8_thread_pool_submit(VP8_THREAD_POOL *pool, VP8_POOL_JOB *job)
+{
+    unsigned int next = (unsigned int)atomic_fetch_add(&pool->next_queue, 1);
+    VP8_POOL_QUEUE *q = &pool->queues[next % pool->num_workers];
+
+    pthread_mutex_lock(&q->mutex);
+
+    job->prev = q->newest;
+    job->next = NULL;
+
+    if (q->newest)
+        q->newest->next = job;
+    else
+        q->oldest = job;
+
+    q->newest = job;
+
+    pthread_mutex_unlock(&q->mutex);
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->pending++;
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#ifndef __INC_THREADPOOL_H
+#define __INC_THREADPOOL_H
+
+#include "vpx_config.h"
+#include "threading.h"
+
+#if CONFIG_OS_SUPPORT && CONFIG_MULTITHREAD
+
+/* A process-wide pool of worker threads, shared by the codec instances that
+ * opt into it, so that many instances do not each keep their own idle
+ * threads. Each worker has a queue of jobs; jobs are submitted to the
+ * queues in turn, a worker runs the newest job of its own queue and, when
+ * that is empty, steals the oldest job of another queue.
+ *
+ * Jobs run in no particular order and may start late, so a job must not
+ * wait on a job submitted after it. Waiting on the thread that submitted
+ * it is fine.
+ */
+typedef void (*vp8_pool_job_fn_t)(void *arg1, void *arg2);
+
+/* A job is owned by the code submitting it, and must stay valid until it
+ * has run.
+ */
+typedef struct VP8_POOL_JOB
+{
+    vp8_pool_job_fn_t fn;
+    void *arg1;
+    void *arg2;
+    struct VP8_POOL_JOB *prev;          /* queue links */
+    struct VP8_POOL_JOB *next;
+} VP8_POOL_JOB;
+
+typedef struct
+{
+    struct VP8_THREAD_POOL *pool;
+    pthread_mutex_t mutex;
+    VP8_POOL_JOB *oldest;
+    VP8_POOL_JOB *newest;
+} VP8_POOL_QUEUE;
+
+typedef struct VP8_THREAD_POOL
+{
+    int num_workers;
+    pthread_t *workers;
+    VP8_POOL_QUEUE *queues;             /* one per worker */
+    int next_queue;
+
+    /* Idle workers sleep until jobs are queued. */
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int pending;                        /* jobs queued, not yet taken */
+    int quit;
+
+    int users;
+} VP8_THREAD_POOL;
+
+/* Sets up the state shared by the pool users. Called once, before the other
+ * functions, by vp8dx_initialize().
+ */
+void vp8_thread_pool_init(void);
+
+/* Sets the number of workers of the pool. Returns non-zero if the pool is
+ * already running with another size.
+ */
+int vp8_thread_pool_set_size(int num_workers);
+
+/* Returns the pool, starting it on first use with the size set, or with
+ * default_workers if none was set. Returns NULL if the pool cannot be
+ * started. Each call is paired with a vp8_thread_pool_release(), and the
+ * pool stops when its last user releases it.
+ */
+VP8_THREAD_POOL *vp8_thread_pool_acquire(int default_workers);
+void vp8_thread_pool_release(VP8_THREAD_POOL *pool);
+
+/* Queues job, which runs job->fn(job->arg1, job->arg2). */
+void vp8_thread_pool_submit(VP8_THREAD_POOL *pool, VP8_POOL_JOB *job);
+
+#endif /* CONFIG_OS_SUPPORT && CONFIG_MULTITHREAD */
+
+#endif
@@ -0,0 +1,167 @@
+;
+;  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+;
+;  Use of this source code is governed by a BSD-style license
+;  that can be found in the LICENSE file in the root of the source
+;  tree. An additional intellectual property rights grant can be found
+;  in the file PATENTS.  All contributing project authors may
+;  be found in the AUTHORS file in the root of the source tree.
+;
+
+
+%include "vpx_ports/x86_abi_support.asm"
+
+;void vp8_filter_by_weight16x16_sse2
+;(
+;    unsigned char *src,
+;    int            src_stride,
+;    unsigned char *dst,
+;    int            dst_stride,
+;    int            src_weight
+;)
+global sym(vp8_filter_by_weight16x16_sse2)
+sym(vp8_filter_by_weight16x16_sse2):
+    push        rbp
+    mov         rbp, rsp
+    SHADOW_ARGS_TO_STACK 5
+    SAVE_XMM 7
+    GET_GOT     rbx
+    push        rsi
+    push        rdi
+    ; end prolog
+
+        movd        xmm0,       dword ptr arg(4)    ; src_weight
+        pshuflw     xmm0,       xmm0,       0x0     ; replicate to all low words
+        punpcklqdq  xmm0,       xmm0                ; replicate to all hi words
+
+        movdqa      xmm1,       [GLOBAL(tMFQE)]
+        psubw       xmm1,       xmm0                ; dst_weight
+
+        mov         rax,        arg(0)              ; src
+        movsxd      rsi,        dword ptr arg(1)    ; src_stride
+        mov         rdx,        arg(2)              ; dst
+        movsxd      rdi,        dword ptr arg(3)    ; dst_stride
+
+        mov         rcx,        16                  ; loop count
+        pxor        xmm6,       xmm6
+
+.combine:
+        movdqu      xmm2,       [rax]
+        movdqu      xmm4,       [rdx]
+        add         rax,        rsi
+
+        ; src * src_weight
+        movdqa      xmm3,       xmm2
+        punpcklbw   xmm2,       xmm6
+        punpckhbw   xmm3,       xmm6
+        pmullw      xmm2,       xmm0
+        pmullw      xmm3,       xmm0
+
+        ; dst * dst_weight
+        movdqa      xmm5,       xmm4
+        punpcklbw   xmm4,       xmm6
+        punpckhbw   xmm5,       xmm6
+        pmullw      xmm4,       xmm1
+        pmullw      xmm5,       xmm1
+
+        ; sum, round and shift
+        paddw       xmm2,       xmm4
+        paddw       xmm3,       xmm5
+        paddw       xmm2,       [GLOBAL(tMFQE_round)]
+        paddw       xmm3,       [GLOBAL(tMFQE_round)]
+        psrlw       xmm2,       4
+        psrlw       xmm3,       4
+
+        packuswb    xmm2,       xmm3
+        movdqu      [rdx],      xmm2
+
+        add         rdx,        rdi
+
+        dec         rcx
+        jnz         .combine
+
+    ; begin epilog
+    pop         rdi
+    pop         rsi
+    RESTORE_GOT
+    RESTORE_XMM
+    UNSHADOW_ARGS
+    pop         rbp
+
+    ret
+
+;void vp8_filter_by_weight8x8_sse2
+;(
+;    unsigned char *src,
+;    int            src_stride,
+;    unsigned char *dst,
+;    int            dst_stride,
+;    int            src_weight
+;)
+global sym(vp8_filter_by_weight8x8_sse2)
+sym(vp8_filter_by_weight8x8_sse2):
+    push        rbp
+    mov         rbp, rsp
+    SHADOW_ARGS_TO_STACK 5
+    GET_GOT     rbx
+    push        rsi
+    push        rdi
+    ; end prolog
+
+        movd        xmm0,       dword ptr arg(4)    ; src_weight
+        pshuflw     xmm0,       xmm0,       0x0     ; replicate to all low words
+        punpcklqdq  xmm0,       xmm0                ; replicate to all hi words
+
+        movdqa      xmm1,       [GLOBAL(tMFQE)]
+        psubw       xmm1,       xmm0                ; dst_weight
+
+        mov         rax,        arg(0)              ; src
+        movsxd      rsi,        dword ptr arg(1)    ; src_stride
+        mov         rdx,        arg(2)              ; dst
+        movsxd      rdi,        dword ptr arg(3)    ; dst_stride
+
+        mov         rcx,        8                   ; loop count
+        pxor        xmm4,       xmm4
+
+.combine:
+        movq        xmm2,       [rax]
+        movq        xmm3,       [rdx]
+        add         rax,        rsi
+
+        ; src * src_weight
+        punpcklbw   xmm2,       xmm4
+        pmullw      xmm2,       xmm0
+
+        ; dst * dst_weight
+        punpcklbw   xmm3,       xmm4
+        pmullw      xmm3,       xmm1
+
+        ; sum, round and shift
+        paddw       xmm2,       xmm3
+        paddw       xmm2,       [GLOBAL(tMFQE_round)]
+        psrlw       xmm2,       4
+
+        packuswb    xmm2,       xmm4
+        movq        [rdx],      xmm2
+
+        add         rdx,        rdi
+
+        dec         rcx
+        jnz         .combine
+
+    ; begin epilog
+    pop         rdi
+    pop         rsi
+    RESTORE_GOT
+    UNSHADOW_ARGS
+    pop         rbp
+
+    ret
+
+SECTION_RODATA
+align 16
+tMFQE: ; 1 << MFQE_PRECISION
+    times 8 dw 0x10
+align 16
+tMFQE_round: ; 1 << (MFQE_PRECISION - 1)
+    times 8 dw 0x08
@@ -495,6 +495,200 @@ sym(vp8_mbpost_proc_down_xmm):
 %undef flimit4
 
 
+;void vp8_mbpost_proc_down_band_sse2(unsigned char *dst, int pitch,
+;                                    int row_start, int row_end, int cols,
+;                                    int flimit, unsigned char *pending,
+;                                    const short *rv)
+global sym(vp8_mbpost_proc_down_band_sse2)
+sym(vp8_mbpost_proc_down_band_sse2):
+    push        rbp
+    mov         rbp, rsp
+    SHADOW_ARGS_TO_STACK 8
+    SAVE_XMM 7
+    push        rsi
+    push        rdi
+    ; end prolog
+
+    ALIGN_STACK 16, rax
+    sub         rsp, 32
+
+    ; create flimit4 at [rsp]
+    mov         eax, dword ptr arg(5) ;flimit
+    mov         [rsp], eax
+    mov         [rsp+4], eax
+    mov         [rsp+8], eax
+    mov         [rsp+12], eax
+%define flimit4 [rsp]
+    ; the offset of the current 8 columns at [rsp+16]
+%define col [rsp+16]
+
+    xor         rax, rax
+    mov         col, rax
+
+    ;for(c=0; c<cols; c+=8)
+.loop_col:
+            movsxd      rax,        dword ptr arg(1) ;pitch
+            movsxd      rdx,        dword ptr arg(2) ;row_start
+
+            ; rsi = s[-pitch*8] of the first step
+            lea         rcx,        [rdx - 8]
+            imul        rcx,        rax
+            mov         rsi,        arg(0) ;dst
+            add         rsi,        col
+            add         rsi,        rcx
+
+            pxor        xmm0,       xmm0
+            pxor        xmm5,       xmm5
+            pxor        xmm6,       xmm6
+            pxor        xmm7,       xmm7
+            mov         rdi,        rsi
+
+            mov         rcx,        15
+
+.loop_initvar:
+            movq        xmm1,       QWORD PTR [rdi];
+            punpcklbw   xmm1,       xmm0        ;
+
+            paddw       xmm5,       xmm1        ;
+            pmullw      xmm1,       xmm1        ;
+
+            movdqa      xmm2,       xmm1        ;
+            punpcklwd   xmm1,       xmm0        ;
+
+            punpckhwd   xmm2,       xmm0        ;
+            paddd       xmm6,       xmm1        ;
+
+            paddd       xmm7,       xmm2        ;
+            lea         rdi,        [rdi+rax]   ;
+
+            dec         rcx
+            jne         .loop_initvar
+
+.loop_row:
+            cmp         edx,        dword ptr arg(3) ;row_end
+            jge         .next_col
+
+            movq        xmm1,       QWORD PTR [rsi]     ; [s-pitch*8]
+            movq        xmm2,       QWORD PTR [rdi]     ; [s+pitch*7]
+
+            punpcklbw   xmm1,       xmm0
+            punpcklbw   xmm2,       xmm0
+
+            paddw       xmm5,       xmm2
+            psubw       xmm5,       xmm1
+
+            pmullw      xmm2,       xmm2
+            movdqa      xmm4,       xmm2
+
+            punpcklwd   xmm2,       xmm0
+            punpckhwd   xmm4,       xmm0
+
+            paddd       xmm6,       xmm2
+            paddd       xmm7,       xmm4
+
+            pmullw      xmm1,       xmm1
+            movdqa      xmm2,       xmm1
+
+            punpcklwd   xmm1,       xmm0
+            psubd       xmm6,       xmm1
+
+            punpckhwd   xmm2,       xmm0
+            psubd       xmm7,       xmm2
+
+
+            movdqa      xmm3,       xmm6
+            pslld       xmm3,       4
+
+            psubd       xmm3,       xmm6
+            movdqa      xmm1,       xmm5
+
+            movdqa      xmm4,       xmm5
+            pmullw      xmm1,       xmm1
+
+            pmulhw      xmm4,       xmm4
+            movdqa      xmm2,       xmm1
+
+            punpcklwd   xmm1,       xmm4
+            punpckhwd   xmm2,       xmm4
+
+            movdqa      xmm4,       xmm7
+            pslld       xmm4,       4
+
+            psubd       xmm4,       xmm7
+
+            psubd       xmm3,       xmm1
+            psubd       xmm4,       xmm2
+
+            psubd       xmm3,       flimit4
+            psubd       xmm4,       flimit4
+
+            psrad       xmm3,       31
+            psrad       xmm4,       31
+
+            packssdw    xmm3,       xmm4
+            packsswb    xmm3,       xmm0
+
+            movq        xmm1,       QWORD PTR [rsi+rax*8]   ; s[0]
+
+            movq        xmm2,       xmm1
+            punpcklbw   xmm1,       xmm0
+
+            paddw       xmm1,       xmm5
+
+            mov         rcx,        rdx
+            and         rcx,        127
+            shl         rcx,        1
+            add         rcx,        arg(7) ;rv
+            movdqu      xmm4,       [rcx] ;rv[r&127]
+
+            paddw       xmm1,       xmm4
+            psraw       xmm1,       4
+
+            packuswb    xmm1,       xmm0
+            pand        xmm1,       xmm3
+
+            pandn       xmm3,       xmm2
+            por         xmm1,       xmm3
+
+            ; the new row replaces the one pending since 8 steps ago
+            mov         rcx,        rdx
+            and         rcx,        7
+            imul        ecx,        dword ptr arg(4) ;cols
+            add         rcx,        col
+            add         rcx,        arg(6) ;pending
+            movq        xmm2,       QWORD PTR [rcx]
+            movq        QWORD PTR [rcx], xmm1
+
+            cmp         rdx,        8
+            jl          .skip_write
+            movq        QWORD PTR [rsi], xmm2   ; s[-pitch*8]
+.skip_write:
+            lea         rsi,        [rsi+rax]
+            lea         rdi,        [rdi+rax]
+            add         rdx,        1
+            jmp         .loop_row
+
+.next_col:
+        mov         rcx,        col
+        add         rcx,        8
+        mov         col,        rcx
+        cmp         ecx,        dword ptr arg(4) ;cols
+        jl          .loop_col
+
+    add         rsp, 32
+    pop         rsp
+
+    ; begin epilog
+    pop rdi
+    pop rsi
+    RESTORE_XMM
+    UNSHADOW_ARGS
+    pop         rbp
+    ret
+%undef flimit4
+%undef col
+
+
 ;void vp8_mbpost_proc_across_ip_xmm(unsigned char *src,
 ;                                int pitch, int rows, int cols,int flimit)
 global sym(vp8_mbpost_proc_across_ip_xmm)
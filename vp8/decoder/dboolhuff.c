@@ -50,3 +50,16 @@ void vp8dx_bool_decoder_fill(BOOL_DECODER *br)
     br->value = value;
     br->count = count;
 }
+
+
+void vp8dx_bool_decoder_extend(BOOL_DECODER *br,
+                               const unsigned char *source_end)
+{
+    /* Zeros were shifted in for the bytes past the end, which the bytes
+     * that follow are ORed into by the next refill.
+     */
+    if (br->count >= VP8_LOTS_OF_BITS)
+        br->count -= VP8_LOTS_OF_BITS;
+
+    br->user_buffer_end = source_end;
+}
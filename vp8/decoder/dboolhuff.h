@@ -13,6 +13,7 @@
 #define DBOOLHUFF_H
 #include <stddef.h>
 #include <limits.h>
+#include <string.h>
 #include "vpx_config.h"
 #include "vpx_ports/mem.h"
 #include "vpx/vpx_integer.h"
@@ -42,6 +43,51 @@ int vp8dx_start_decode(BOOL_DECODER *br,
 
 void vp8dx_bool_decoder_fill(BOOL_DECODER *br);
 
+/*Makes the bytes of a buffer that continues the decoder's buffer up to
+   source_end available to it, as if they had been there from the start. The
+   decoder must not have read past the end of its buffer.*/
+void vp8dx_bool_decoder_extend(BOOL_DECODER *br,
+                               const unsigned char *source_end);
+
+/*Where a whole VP8_BD_VALUE can be byte swapped cheaply, the window is
+   refilled with a single big-endian load while that many bytes remain. The
+   load may also bring in the top bits of the byte after the last whole one;
+   those are the stream's own bits, which the next refill ORs in again at the
+   same position, so the decoded values do not change.*/
+#if ARCH_X86_64 && defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 3))
+# define VP8_BD_BSWAP(x) __builtin_bswap64(x)
+#elif ARCH_X86_64 && defined(_MSC_VER)
+# include <stdlib.h>
+# define VP8_BD_BSWAP(x) _byteswap_uint64(x)
+#endif
+
+#ifdef VP8_BD_BSWAP
+# define VP8_BD_LOAD_BE(_value,_bufptr) \
+    do \
+    { \
+        memcpy(&(_value), (_bufptr), sizeof(VP8_BD_VALUE)); \
+        (_value) = VP8_BD_BSWAP(_value); \
+    } \
+    while(0)
+#endif
+
+#ifdef VP8_BD_LOAD_BE
+# define VP8_BD_FILL_WORD(_count,_value,_bufptr,_shift,_x,_bits_left) \
+    if((_x) < 0 && (_bits_left) >= VP8_BD_VALUE_SIZE) \
+    { \
+        VP8_BD_VALUE big; \
+        int bytes = ((_shift) >> 3) + 1; \
+        VP8_BD_LOAD_BE(big, _bufptr); \
+        (_value) |= big >> (VP8_BD_VALUE_SIZE - CHAR_BIT - (_shift)); \
+        (_bufptr) += bytes; \
+        (_count) += bytes * CHAR_BIT; \
+        break; \
+    }
+#else
+# define VP8_BD_FILL_WORD(_count,_value,_bufptr,_shift,_x,_bits_left)
+#endif
+
 /*The refill loop is used in several places, so define it in a macro to make
    sure they're all consistent.
   An inline function would be cleaner, but has a significant penalty, because
@@ -57,6 +103,7 @@ void vp8dx_bool_decoder_fill(BOOL_DECODER *br);
         \
         x = shift + CHAR_BIT - bits_left; \
         loop_end = 0; \
+        VP8_BD_FILL_WORD(_count,_value,_bufptr,shift,x,bits_left); \
         if(x >= 0) \
         { \
             (_count) += VP8_LOTS_OF_BITS; \
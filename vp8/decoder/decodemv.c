@@ -173,7 +173,7 @@ static const unsigned char mbsplit_fill_offset[4][16] = {
 
 
 
-static void mb_mode_mv_init(VP8D_COMP *pbi)
+void vp8_mb_mode_mv_init(VP8D_COMP *pbi)
 {
     vp8_reader *const bc = & pbi->bc;
     MV_CONTEXT *const mvc = pbi->common.fc.mvc;
@@ -624,8 +624,6 @@ void vp8_decode_mode_mvs(VP8D_COMP *pbi)
     MODE_INFO *mi = pbi->common.mi;
     int mb_row = -1;
 
-    mb_mode_mv_init(pbi);
-
     while (++mb_row < pbi->common.mb_rows)
     {
         int mb_col = -1;
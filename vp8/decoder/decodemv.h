@@ -11,4 +11,5 @@
 
 #include "onyxd_int.h"
 
+void vp8_mb_mode_mv_init(VP8D_COMP *);
 void vp8_decode_mode_mvs(VP8D_COMP *);
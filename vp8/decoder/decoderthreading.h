@@ -21,6 +21,29 @@ extern void vp8_decoder_remove_threads(VP8D_COMP *pbi);
 extern void vp8_decoder_create_threads(VP8D_COMP *pbi);
 extern void vp8mt_alloc_temp_buffers(VP8D_COMP *pbi, int width, int prev_mb_rows);
 extern void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows);
+#if CONFIG_POSTPROC
+extern void vp8mt_run_post_proc_pass(void *ctx, vp8_pp_pass_t *pass);
+#endif
+#if CONFIG_ERROR_CONCEALMENT
+extern void vp8mt_estimate_missing_mvs(VP8D_COMP *pbi);
+#endif
+
+extern void vp8ft_create_threads(VP8D_COMP *pbi, VP8D_CONFIG *oxcf);
+extern void vp8ft_remove_threads(VP8D_COMP *pbi);
+extern int vp8ft_receive_compressed_data(VP8D_COMP *pbi, unsigned long size,
+                                         const unsigned char *source,
+                                         int64_t time_stamp);
+extern int vp8ft_get_raw_frame(VP8D_COMP *pbi, YV12_BUFFER_CONFIG *sd,
+                               int64_t *time_stamp, int64_t *time_end_stamp,
+                               void **user_priv);
+extern int vp8ft_get_reference(VP8D_COMP *pbi, VP8_REFFRAME ref_frame_flag,
+                               YV12_BUFFER_CONFIG *sd);
+extern int vp8ft_set_reference(VP8D_COMP *pbi, VP8_REFFRAME ref_frame_flag,
+                               YV12_BUFFER_CONFIG *sd);
+extern void vp8ft_frame_setup_done(VP8D_COMP *pbi);
+extern void vp8ft_modes_done(VP8D_COMP *pbi);
+extern void vp8ft_wait_ref_rows(VP8D_COMP *pbi, int mb_row);
+extern void vp8ft_row_done(VP8D_COMP *pbi, int mb_row);
 #endif
 
 #endif
@@ -24,6 +24,7 @@
 #include "vp8/common/setupintrarecon.h"
 
 #include "decodemv.h"
+#include "reduced.h"
 #include "vp8/common/extend.h"
 #if CONFIG_ERROR_CONCEALMENT
 #include "error_concealment.h"
@@ -109,31 +110,67 @@ void mb_init_dequantizer(VP8D_COMP *pbi, MACROBLOCKD *xd)
 }
 
 
-static void decode_macroblock(VP8D_COMP *pbi, MACROBLOCKD *xd,
-                              unsigned int mb_idx)
+/* Decodes the tokens of the MB. When its token partition is still arriving,
+ * partial is set, and if the tokens of the MB have not all arrived, 0 is
+ * returned with the MB and the decoder left as they were.
+ */
+static int decode_mb_tokens(VP8D_COMP *pbi, MACROBLOCKD *xd, int partial)
 {
-    MB_PREDICTION_MODE mode;
-    int i;
-    int corruption_detected = 0;
-
     if (xd->mode_info_context->mbmi.mb_skip_coeff)
     {
         vp8_reset_mb_tokens_context(xd);
     }
     else if (!vp8dx_bool_error(xd->current_bc))
     {
+        BOOL_DECODER *const bc = xd->current_bc;
+        BOOL_DECODER saved_bc;
+        ENTROPY_CONTEXT_PLANES saved_above, saved_left;
         int eobtotal;
+
+        if (partial)
+        {
+            saved_bc = *bc;
+            saved_above = *xd->above_context;
+            saved_left = *xd->left_context;
+        }
+
         eobtotal = vp8_decode_mb_tokens(pbi, xd);
 
+        if (partial && vp8dx_bool_error(bc))
+        {
+            *bc = saved_bc;
+            *xd->above_context = saved_above;
+            *xd->left_context = saved_left;
+            vpx_memset(xd->qcoeff, 0, sizeof(xd->qcoeff));
+            return 0;
+        }
+
         /* Special case:  Force the loopfilter to skip when eobtotal is zero */
         xd->mode_info_context->mbmi.mb_skip_coeff = (eobtotal==0);
     }
 
+    return 1;
+}
+
+static void decode_macroblock(VP8D_COMP *pbi, MACROBLOCKD *xd,
+                              unsigned int mb_idx)
+{
+    MB_PREDICTION_MODE mode;
+    int i;
+    int corruption_detected = 0;
+
     mode = xd->mode_info_context->mbmi.mode;
 
     if (xd->segmentation_enabled)
         mb_init_dequantizer(pbi, xd);
 
+    if (pbi->rr_frame)
+    {
+        vp8dx_decode_reduced_mb(pbi, xd, mb_idx / pbi->common.mb_cols,
+                                mb_idx % pbi->common.mb_cols);
+        return;
+    }
+
 #if PROFILE_OUTPUT
      if (xd->frame_type == KEY_FRAME)
          printf("Intra-Coded MB\n");
@@ -330,22 +367,37 @@ FILE *vpxlog = 0;
 
 
 
-static void
-decode_mb_row(VP8D_COMP *pbi, VP8_COMMON *pc, int mb_row, MACROBLOCKD *xd)
+/* Decodes the MB row from MB pbi->next_mb_col on. With partial set, the
+ * token partition of the row is still arriving, and the row stops at the
+ * first MB whose tokens have not all arrived. Returns non-zero once the row
+ * is complete.
+ */
+static int
+decode_mb_row(VP8D_COMP *pbi, VP8_COMMON *pc, int mb_row, MACROBLOCKD *xd,
+              int partial)
 {
     int recon_yoffset, recon_uvoffset;
-    int mb_col;
+    int mb_col = pbi->next_mb_col;
     int ref_fb_idx = pc->lst_fb_idx;
     int dst_fb_idx = pc->new_fb_idx;
     int recon_y_stride = pc->yv12_fb[ref_fb_idx].y_stride;
     int recon_uv_stride = pc->yv12_fb[ref_fb_idx].uv_stride;
+    int64_t *stat_time = NULL;
+    int64_t stat_mark = 0;
 
-    vpx_memset(&pc->left_context, 0, sizeof(pc->left_context));
-    recon_yoffset = mb_row * recon_y_stride * 16;
-    recon_uvoffset = mb_row * recon_uv_stride * 8;
+    if (pbi->stats_enabled)
+    {
+        stat_time = pbi->stats_frame.time;
+        stat_mark = vpx_nsec_timestamp();
+    }
+
+    if (mb_col == 0)
+        vpx_memset(&pc->left_context, 0, sizeof(pc->left_context));
+    recon_yoffset = mb_row * recon_y_stride * 16 + mb_col * 16;
+    recon_uvoffset = mb_row * recon_uv_stride * 8 + mb_col * 8;
     /* reset above block coeffs */
 
-    xd->above_context = pc->above_context;
+    xd->above_context = pc->above_context + mb_col;
     xd->up_available = (mb_row != 0);
 
     xd->mb_to_top_edge = -((mb_row * 16)) << 3;
@@ -353,7 +405,7 @@ decode_mb_row(VP8D_COMP *pbi, VP8_COMMON *pc, int mb_row, MACROBLOCKD *xd)
 
 
 
-	for (mb_col = 0; mb_col < pc->mb_cols; mb_col++)
+	for (; mb_col < pc->mb_cols; mb_col++)
     {
         /* Distance of Mb to the various image edges.
          * These are specified to 8th pel as they are always compared to values
@@ -412,8 +464,23 @@ decode_mb_row(VP8D_COMP *pbi, VP8_COMMON *pc, int mb_row, MACROBLOCKD *xd)
             xd->corrupted |= pc->yv12_fb[ref_fb_idx].corrupted;
         }
 
+        if (!decode_mb_tokens(pbi, xd, partial))
+        {
+            if (stat_time)
+                vp8d_stat_lap(stat_time, STAT_TOKENS, &stat_mark);
+
+            pbi->next_mb_col = mb_col;
+            return 0;
+        }
+
+        if (stat_time)
+            vp8d_stat_lap(stat_time, STAT_TOKENS, &stat_mark);
+
         decode_macroblock(pbi, xd, mb_row * pc->mb_cols  + mb_col);
 
+        if (stat_time)
+            vp8d_stat_lap(stat_time, STAT_RECON, &stat_mark);
+
         /* check if the boolean decoder has suffered an error */
         xd->corrupted |= vp8dx_bool_error(xd->current_bc);
 
@@ -427,12 +494,21 @@ decode_mb_row(VP8D_COMP *pbi, VP8_COMMON *pc, int mb_row, MACROBLOCKD *xd)
     }
 
     /* adjust to the next row of mbs */
-    vp8_extend_mb_row(
-        &pc->yv12_fb[dst_fb_idx],
-        xd->dst.y_buffer + 16, xd->dst.u_buffer + 8, xd->dst.v_buffer + 8
-    );
+    if (!pbi->rr_frame)
+    {
+        vp8_extend_mb_row(
+            &pc->yv12_fb[dst_fb_idx],
+            xd->dst.y_buffer + 16, xd->dst.u_buffer + 8, xd->dst.v_buffer + 8
+        );
+
+        if (stat_time)
+            vp8d_stat_lap(stat_time, STAT_EXTEND, &stat_mark);
+    }
 
     ++xd->mode_info_context;      /* skip prediction column */
+
+    pbi->next_mb_col = 0;
+    return 1;
 }
 
 
@@ -461,8 +537,8 @@ static unsigned int read_available_partition_size(
 {
     VP8_COMMON* pc = &pbi->common;
     const unsigned char *partition_size_ptr = token_part_sizes + i * 3;
-    unsigned int partition_size;
     ptrdiff_t bytes_left = fragment_end - fragment_start;
+    unsigned int partition_size = (unsigned int)bytes_left;
     /* Calculate the length of this partition. The last partition
      * size is implicit. If the partition size can't be read, then
      * either use the remaining data in the buffer (for EC mode)
@@ -472,14 +548,10 @@ static unsigned int read_available_partition_size(
     {
         if (read_is_valid(partition_size_ptr, 3, first_fragment_end))
             partition_size = read_partition_size(partition_size_ptr);
-        else if (pbi->ec_active)
-            partition_size = bytes_left;
-        else
+        else if (!pbi->ec_active)
             vpx_internal_error(&pc->error, VPX_CODEC_CORRUPT_FRAME,
                                "Truncated partition size data");
     }
-    else
-        partition_size = bytes_left;
 
     /* Validate the calculated partition length. If the buffer
      * described by the partition can't be fully read, then restrict
@@ -498,95 +570,168 @@ static unsigned int read_available_partition_size(
 }
 
 
-static void setup_token_decoder(VP8D_COMP *pbi,
-                                const unsigned char* token_part_sizes)
+/* Finds the token partitions in the fragments received so far, and starts
+ * or extends the bool decoders of those that have data. Only the last
+ * fragment with data can still grow, and a partition that ends past it is
+ * left incomplete. With final set, no more data is expected, and the
+ * partitions are checked as when the whole frame is received at once.
+ */
+static void unpack_fragments(VP8D_COMP *pbi, int final)
 {
-    vp8_reader *bool_decoder = &pbi->bc2;
-    unsigned int partition_idx;
-    int fragment_idx;
-    int num_token_partitions;
+    const int num_token_partitions = 1 << pbi->common.multi_token_partition;
+    vp8_reader *bool_decoder = num_token_partitions > 1 ? pbi->mbc
+                                                        : &pbi->bc2;
     const unsigned char *first_fragment_end = pbi->fragments[0] +
-                                          pbi->fragment_sizes[0];
+                                              pbi->fragment_sizes[0];
+    const unsigned char *partitions[MAX_PARTITIONS] = {0};
+    unsigned int partition_sizes[MAX_PARTITIONS] = {0};
+    int partition_idx = 1;
+    int complete = 0;
+    int last_fragment = 0;
+    int fragment_idx;
 
-    TOKEN_PARTITION multi_token_partition =
-            (TOKEN_PARTITION)vp8_read_literal(&pbi->bc, 2);
-    if (!vp8dx_bool_error(&pbi->bc))
-        pbi->common.multi_token_partition = multi_token_partition;
-    num_token_partitions = 1 << pbi->common.multi_token_partition;
-    if (num_token_partitions > 1)
-    {
-        CHECK_MEM_ERROR(pbi->mbc, vpx_malloc(num_token_partitions *
-                                             sizeof(vp8_reader)));
-        bool_decoder = pbi->mbc;
-    }
+    for (fragment_idx = 0; fragment_idx < (int)pbi->num_fragments;
+         ++fragment_idx)
+        if (pbi->fragment_sizes[fragment_idx])
+            last_fragment = fragment_idx;
 
-    /* Check for partitions within the fragments and unpack the fragments
-     * so that each fragment pointer points to its corresponding partition. */
-    for (fragment_idx = 0; fragment_idx < pbi->num_fragments; ++fragment_idx)
+    /* Check for partitions within the fragments. Each fragment after the
+     * first holds the partition of its index, and any that follow it.
+     */
+    for (fragment_idx = 0; fragment_idx < (int)pbi->num_fragments;
+         ++fragment_idx)
     {
-        unsigned int fragment_size = pbi->fragment_sizes[fragment_idx];
-        const unsigned char *fragment_end = pbi->fragments[fragment_idx] +
-                                            fragment_size;
+        const unsigned char *ptr = pbi->fragments[fragment_idx];
+        const unsigned char *fragment_end = ptr +
+                                            pbi->fragment_sizes[fragment_idx];
+        const int growing = !final && fragment_idx == last_fragment;
+
         /* Special case for handling the first partition since we have already
          * read its size. */
         if (fragment_idx == 0)
         {
-            /* Size of first partition + token partition sizes element */
-            ptrdiff_t ext_first_part_size = token_part_sizes -
-                pbi->fragments[0] + 3 * (num_token_partitions - 1);
-            fragment_size -= ext_first_part_size;
-            if (fragment_size > 0)
+            /* Skip the first partition and the token partition sizes */
+            ptr = pbi->token_part_sizes + 3 * (num_token_partitions - 1);
+            if (ptr > fragment_end)
+                ptr = fragment_end;
+        }
+        else if (fragment_idx < partition_idx)
+            continue;   /* its partition is held by an earlier fragment */
+        else
+        {
+            /* The partitions before this one are missing */
+            partition_idx = fragment_idx;
+            if (ptr == fragment_end)
             {
-                pbi->fragment_sizes[0] = ext_first_part_size;
-                /* The fragment contains an additional partition. Move to
-                 * next. */
-                fragment_idx++;
-                pbi->fragments[fragment_idx] = pbi->fragments[0] +
-                  pbi->fragment_sizes[0];
+                partitions[partition_idx] = ptr;
+                complete = partition_idx++;
             }
         }
+
         /* Split the chunk into partitions read from the bitstream */
-        while (fragment_size > 0)
+        while (ptr < fragment_end && partition_idx <= num_token_partitions)
         {
-            ptrdiff_t partition_size = read_available_partition_size(
+            const unsigned char *partition_size_ptr =
+                pbi->token_part_sizes + 3 * (partition_idx - 1);
+            unsigned int partition_size;
+            int partial = 0;
+
+            if (growing)
+            {
+                partial = partition_idx == num_token_partitions ||
+                          (read_is_valid(partition_size_ptr, 3,
+                                         first_fragment_end) &&
+                           !read_is_valid(ptr,
+                                          read_partition_size(
+                                              partition_size_ptr),
+                                          fragment_end));
+            }
+
+            if (partial)
+                partition_size = fragment_end - ptr;
+            else
+            {
+                partition_size = read_available_partition_size(
                                                  pbi,
-                                                 token_part_sizes,
-                                                 pbi->fragments[fragment_idx],
+                                                 pbi->token_part_sizes,
+                                                 ptr,
                                                  first_fragment_end,
                                                  fragment_end,
-                                                 fragment_idx - 1,
+                                                 partition_idx - 1,
                                                  num_token_partitions);
-            pbi->fragment_sizes[fragment_idx] = partition_size;
-            fragment_size -= partition_size;
-            assert(fragment_idx <= num_token_partitions);
-            if (fragment_size > 0)
-            {
-                /* The fragment contains an additional partition.
-                 * Move to next. */
-                fragment_idx++;
-                pbi->fragments[fragment_idx] =
-                    pbi->fragments[fragment_idx - 1] + partition_size;
+                complete = partition_idx;
             }
+
+            partitions[partition_idx] = ptr;
+            partition_sizes[partition_idx] = partition_size;
+            ptr += partition_size;
+            partition_idx++;
         }
     }
 
-    pbi->num_fragments = num_token_partitions + 1;
+    if (final)
+    {
+        partition_idx = num_token_partitions + 1;
+        complete = num_token_partitions;
 
-    for (partition_idx = 1; partition_idx < pbi->num_fragments; ++partition_idx)
+        if (pbi->stats_enabled)
+            for (fragment_idx = 1; fragment_idx < partition_idx; ++fragment_idx)
+                pbi->stats_frame.partition_bytes[fragment_idx] =
+                    partition_sizes[fragment_idx];
+    }
+
+    for (fragment_idx = 1; fragment_idx < partition_idx; ++fragment_idx)
     {
-        if (vp8dx_start_decode(bool_decoder,
-                               pbi->fragments[partition_idx],
-                               pbi->fragment_sizes[partition_idx]))
+        vp8_reader *bc = bool_decoder + fragment_idx - 1;
+        const unsigned char *partition_end = partitions[fragment_idx] +
+                                             partition_sizes[fragment_idx];
+
+        if (fragment_idx <= pbi->token_decoders_started)
+        {
+            if (bc->user_buffer_end != partition_end)
+                vp8dx_bool_decoder_extend(bc, partition_end);
+            continue;
+        }
+
+        if (vp8dx_start_decode(bc, partitions[fragment_idx],
+                               partition_sizes[fragment_idx]))
             vpx_internal_error(&pbi->common.error, VPX_CODEC_MEM_ERROR,
                                "Failed to allocate bool decoder %d",
-                               partition_idx);
+                               fragment_idx);
+
+        pbi->token_decoders_started = fragment_idx;
+    }
 
-        bool_decoder++;
+    pbi->token_partitions_complete = complete;
+}
+
+static void setup_token_decoder(VP8D_COMP *pbi,
+                                const unsigned char* token_part_sizes)
+{
+    int num_token_partitions;
+
+    TOKEN_PARTITION multi_token_partition =
+            (TOKEN_PARTITION)vp8_read_literal(&pbi->bc, 2);
+    if (!vp8dx_bool_error(&pbi->bc))
+        pbi->common.multi_token_partition = multi_token_partition;
+    num_token_partitions = 1 << pbi->common.multi_token_partition;
+    if (num_token_partitions > 1)
+    {
+        CHECK_MEM_ERROR(pbi->mbc, vpx_malloc(num_token_partitions *
+                                             sizeof(vp8_reader)));
     }
 
+    pbi->token_part_sizes = token_part_sizes;
+    pbi->token_decoders_started = 0;
+    pbi->token_partitions_complete = 0;
+
 #if CONFIG_MULTITHREAD
-    /* Clamp number of decoder threads */
-    if (pbi->decoding_thread_count > num_token_partitions - 1)
+    /* Clamp number of decoder threads. A single partition is parsed on the
+     * main thread and reconstructed on all the others.
+     */
+    pbi->decoding_thread_count = pbi->allocated_decoding_thread_count;
+    if (num_token_partitions > 1 &&
+        pbi->decoding_thread_count > num_token_partitions - 1)
         pbi->decoding_thread_count = num_token_partitions - 1;
 #endif
 }
@@ -687,7 +832,24 @@ static void init_frame(VP8D_COMP *pbi)
 }
 
 
-int vp8_decode_frame(VP8D_COMP *pbi)
+/* Returns non-zero if the MB rows of the frame are decoded by the row
+ * threads.
+ */
+static int decode_rows_mt(VP8D_COMP *pbi)
+{
+#if CONFIG_MULTITHREAD
+    return pbi->b_multithreaded_rd && !pbi->rr_frame &&
+           (pbi->common.multi_token_partition != ONE_PARTITION ||
+            pbi->mt_pipeline);
+#else
+    return 0;
+#endif
+}
+
+/* Decodes the frame header and the first partition, and sets up the
+ * decoding of the MB rows.
+ */
+static int start_frame(VP8D_COMP *pbi)
 {
     vp8_reader *const bc = & pbi->bc;
     VP8_COMMON *const pc = & pbi->common;
@@ -695,12 +857,18 @@ int vp8_decode_frame(VP8D_COMP *pbi)
     const unsigned char *data = pbi->fragments[0];
     const unsigned char *data_end =  data + pbi->fragment_sizes[0];
     ptrdiff_t first_partition_length_in_bytes;
+    int64_t stat_mark = 0;
 
-    int mb_row;
     int i, j, k, l;
     const int *const mb_feature_data_bits = vp8_mb_feature_data_bits;
-    int corrupt_tokens = 0;
-    int prev_independent_partitions = pbi->independent_partitions;
+
+    if (pbi->stats_enabled)
+    {
+        vpx_memset(&pbi->stats_frame, 0, sizeof(pbi->stats_frame));
+        stat_mark = vpx_nsec_timestamp();
+    }
+
+    pbi->saved_independent_partitions = pbi->independent_partitions;
 
     /* start with no corruption of current frame */
     xd->corrupted = 0;
@@ -772,6 +940,19 @@ int vp8_decode_frame(VP8D_COMP *pbi)
             {
                 int prev_mb_rows = pc->mb_rows;
 
+#if CONFIG_MULTITHREAD
+                /* Frame contexts share buffers allocated by the decoder
+                 * instance, which resizes them before submitting the frame.
+                 */
+                if (pbi->ft)
+                {
+                    pc->Width = Width;
+                    pc->Height = Height;
+                    vpx_internal_error(&pc->error, VPX_CODEC_CORRUPT_FRAME,
+                                       "Unexpected frame size change");
+                }
+#endif
+
                 if (pc->Width <= 0)
                 {
                     pc->Width = Width;
@@ -790,6 +971,10 @@ int vp8_decode_frame(VP8D_COMP *pbi)
                     vpx_internal_error(&pc->error, VPX_CODEC_MEM_ERROR,
                                        "Failed to allocate frame buffers");
 
+                /* The application's buffers are for the previous size. */
+                if (pbi->get_fb_cb)
+                    vp8dx_release_external_fbs(pbi, 1);
+
 #if CONFIG_ERROR_CONCEALMENT
                 pbi->overlaps = NULL;
                 if (pbi->ec_enabled)
@@ -815,6 +1000,20 @@ int vp8_decode_frame(VP8D_COMP *pbi)
         return -1;
     }
 
+    if (pbi->get_fb_cb && vp8dx_get_external_fb(pbi, pc->new_fb_idx))
+        vpx_internal_error(&pc->error, VPX_CODEC_MEM_ERROR,
+                           "Failed to get frame buffer");
+
+    /* The scale of reduced resolution decoding changes on key frames, which
+     * reference no frame of the previous scale. Key frames are decoded at
+     * full resolution and downscaled, so that each GOP starts without
+     * error.
+     */
+    if (pc->frame_type == KEY_FRAME && vp8dx_setup_reduced_frames(pbi))
+        vpx_internal_error(&pc->error, VPX_CODEC_MEM_ERROR,
+                           "Failed to allocate reduced resolution frames");
+    pbi->rr_frame = pbi->rr_scale && pc->frame_type != KEY_FRAME;
+
     init_frame(pbi);
 
     if (vp8dx_start_decode(bc, data, data_end - data))
@@ -879,6 +1078,11 @@ int vp8_decode_frame(VP8D_COMP *pbi)
     pc->filter_level = vp8_read_literal(bc, 6);
     pc->sharpness_level = vp8_read_literal(bc, 3);
 
+    /* The application seeks, and accepts that the references drift from
+     * the encoder's until the next key frame. */
+    if (pbi->skip_loop_filter)
+        pc->filter_level = 0;
+
     /* Read in loop filter deltas applied at the MB level based on mode or ref frame. */
     xd->mode_ref_lf_delta_update = 0;
     xd->mode_ref_lf_delta_enabled = (unsigned char)vp8_read_bit(bc);
@@ -1057,9 +1261,26 @@ int vp8_decode_frame(VP8D_COMP *pbi)
     vpx_memcpy(&xd->pre, &pc->yv12_fb[pc->lst_fb_idx], sizeof(YV12_BUFFER_CONFIG));
     vpx_memcpy(&xd->dst, &pc->yv12_fb[pc->new_fb_idx], sizeof(YV12_BUFFER_CONFIG));
 
+#if CONFIG_MULTITHREAD
+    /* With a single token partition, this thread parses the tokens ahead of
+     * the decoding threads that reconstruct the rows.
+     */
+    pbi->mt_pipeline = pbi->b_multithreaded_rd && !pbi->rr_frame &&
+                       pc->multi_token_partition == ONE_PARTITION &&
+                       pbi->decoding_thread_count > 0 && !pbi->ec_enabled;
+#if CONFIG_OPENCL
+    if (cl_initialized == CL_SUCCESS)
+        pbi->mt_pipeline = 0;
+#endif
+#endif
+
     /* set up frame new frame for intra coded blocks */
+    if (pbi->rr_frame)
+        vp8_setup_intra_recon(&pbi->rr_fb[pc->new_fb_idx]);
 #if CONFIG_MULTITHREAD
-    if (!(pbi->b_multithreaded_rd) || pc->multi_token_partition == ONE_PARTITION || !(pc->filter_level))
+    else if (!(pbi->b_multithreaded_rd) || (pc->multi_token_partition == ONE_PARTITION && !pbi->mt_pipeline) || !(pc->filter_level))
+#else
+    else
 #endif
         vp8_setup_intra_recon(&pc->yv12_fb[pc->new_fb_idx]);
 
@@ -1074,18 +1295,46 @@ int vp8_decode_frame(VP8D_COMP *pbi)
     pc->mb_no_coeff_skip = (int)vp8_read_bit(bc);
 
 
+    vp8_mb_mode_mv_init(pbi);
+
+#if CONFIG_MULTITHREAD
+    /* Everything the next frame inherits from this one is known now. */
+    if (pbi->ft)
+        vp8ft_frame_setup_done(pbi);
+#endif
+
     vp8_decode_mode_mvs(pbi);
 
+#if CONFIG_MULTITHREAD
+    if (pbi->ft)
+        vp8ft_modes_done(pbi);
+#endif
+
 #if CONFIG_ERROR_CONCEALMENT
     if (pbi->ec_active &&
             pbi->mvs_corrupt_from_mb < (unsigned int)pc->mb_cols * pc->mb_rows)
     {
         /* Motion vectors are missing in this frame. We will try to estimate
          * them and then continue decoding the frame as usual */
-        vp8_estimate_missing_mvs(pbi);
+#if CONFIG_MULTITHREAD
+        if (pbi->b_multithreaded_rd)
+            vp8mt_estimate_missing_mvs(pbi);
+        else
+#endif
+            vp8_estimate_missing_mvs(pbi);
     }
 #endif
 
+    /* A frame that updates no reference is only displayed. When seeking, its
+     * modes are still parsed, as later frames inherit its segment map, but
+     * its residual is not decoded and no MB is reconstructed.
+     */
+    pbi->frame_skipped = pbi->skip_nonref_frames &&
+                         pc->frame_type != KEY_FRAME &&
+                         !pc->refresh_last_frame &&
+                         !pc->refresh_golden_frame &&
+                         !pc->refresh_alt_ref_frame;
+
     vpx_memset(pc->above_context, 0, sizeof(ENTROPY_CONTEXT_PLANES) * pc->mb_cols);
 
 #if PROFILE_OUTPUT
@@ -1095,38 +1344,178 @@ int vp8_decode_frame(VP8D_COMP *pbi)
         printf("Inter-Frame\n");
 #endif
 
-#if CONFIG_MULTITHREAD
-    if (pbi->b_multithreaded_rd && pc->multi_token_partition != ONE_PARTITION)
+    pbi->frame_corrupt_residual = 0;
+
+    /* The rows of a frame to show are put as they become final, unless
+     * the frame is reconstructed at a reduced resolution.
+     */
+    pbi->put_rows_active = pbi->put_rows && pc->show_frame &&
+                           !pbi->frame_skipped && !pbi->rr_frame &&
+                           !pbi->rr_scale;
+    pbi->mb_rows_put = 0;
+
+    if (!pbi->frame_skipped && !decode_rows_mt(pbi))
     {
-        int i;
-        pbi->frame_corrupt_residual = 0;
-        vp8mt_decode_mb_rows(pbi, xd);
-        vp8_yv12_extend_frame_borders_ptr(&pc->yv12_fb[pc->new_fb_idx]);    /*cm->frame_to_show);*/
-        for (i = 0; i < pbi->decoding_thread_count; ++i)
-            corrupt_tokens |= pbi->mb_row_di[i].mbd.corrupted;
-    }
-    else
+        /* Loop filter each MB row while it is still in the cache, rather
+         * than in a separate pass over the whole frame once decoding is
+         * done. Filtering row N-1 modifies the bottom pixels of that row,
+         * which row N uses for intra prediction, so the filter runs one
+         * row behind the reconstruction.
+         */
+        pbi->lf_rows_in_decode = (pc->filter_level != 0 && !pbi->rr_frame &&
+                                  !pbi->frame_passes);
+
+        /* Likewise extend the borders of each MB row once it is final,
+         * rather than in a pass over the frame. Row N-2 is final once row
+         * N-1 is filtered, and by then row N-1, whose intra prediction uses
+         * the left edge of row N-2, is decoded.
+         */
+        pbi->ext_rows_in_decode = !pbi->rr_frame && !pbi->frame_passes;
+#if CONFIG_OPENCL
+        if (cl_initialized == CL_SUCCESS)
+        {
+            pbi->lf_rows_in_decode = 0;
+            pbi->ext_rows_in_decode = 0;
+        }
 #endif
+
+        if (pbi->lf_rows_in_decode)
+            vp8_loop_filter_frame_init(pc, xd, pc->filter_level);
+
+        pbi->next_mb_row = 0;
+        pbi->next_mb_col = 0;
+    }
+
+    if (pbi->stats_enabled)
+    {
+        vp8d_stat_lap(pbi->stats_frame.time, STAT_MODES, &stat_mark);
+        pbi->stats_frame.partition_bytes[0] = first_partition_length_in_bytes;
+    }
+
+    return 0;
+}
+
+/* Decodes the MB rows of the frame on this thread, up to the first MB whose
+ * tokens have not arrived yet.
+ */
+static void decode_mb_rows(VP8D_COMP *pbi)
+{
+    VP8_COMMON *const pc = & pbi->common;
+    MACROBLOCKD *const xd  = & pbi->mb;
+    const int num_part = 1 << pc->multi_token_partition;
+    YV12_BUFFER_CONFIG *dst_fb = &pc->yv12_fb[pc->new_fb_idx];
+    int64_t *const stat_time = pbi->stats_frame.time;
+    int64_t stat_mark = 0;
+    int mb_row;
+
+    if (pbi->next_mb_row == pc->mb_rows)
+        return;
+
+    /* Decode the individual macro blocks */
+    for (mb_row = pbi->next_mb_row; mb_row < pc->mb_rows; mb_row++)
     {
-        int ibc = 0;
-        int num_part = 1 << pc->multi_token_partition;
-        pbi->frame_corrupt_residual = 0;
+        /* Row N is coded in token partition N % num_part */
+        const int partition = mb_row % num_part;
+
+        if (partition >= pbi->token_decoders_started)
+            break;
 
-        /* Decode the individual macro blocks */
-        for (mb_row = 0; mb_row < pc->mb_rows; mb_row++)
+        if (num_part > 1)
+            xd->current_bc = & pbi->mbc[partition];
+
+#if CONFIG_MULTITHREAD
+        if (pbi->ft)
         {
+            if (pbi->stats_enabled)
+                stat_mark = vpx_nsec_timestamp();
 
-            if (num_part > 1)
-            {
-                xd->current_bc = & pbi->mbc[ibc];
-                ibc++;
+            vp8ft_wait_ref_rows(pbi, mb_row);
 
-                if (ibc == num_part)
-                    ibc = 0;
-            }
+            if (pbi->stats_enabled)
+                vp8d_stat_lap(stat_time, STAT_THREAD_WAIT, &stat_mark);
+        }
+#endif
+
+        if (!decode_mb_row(pbi, pc, mb_row, xd,
+                           partition >= pbi->token_partitions_complete))
+            break;
+
+        if (pbi->stats_enabled)
+            stat_mark = vpx_nsec_timestamp();
+
+        if (pbi->lf_rows_in_decode && mb_row > 0)
+        {
+            vp8_loop_filter_row(pc, dst_fb, mb_row - 1);
 
-            decode_mb_row(pbi, pc, mb_row, xd);
+            if (pbi->stats_enabled)
+                vp8d_stat_lap(stat_time, STAT_LOOP_FILTER, &stat_mark);
         }
+
+        if (pbi->ext_rows_in_decode && mb_row > 1)
+        {
+            vp8_extend_mb_row_borders(dst_fb, mb_row - 2);
+
+            if (pbi->stats_enabled)
+                vp8d_stat_lap(stat_time, STAT_EXTEND, &stat_mark);
+
+            vp8dx_put_rows(pbi, mb_row - 1);
+        }
+
+#if CONFIG_MULTITHREAD
+        if (pbi->ft && mb_row > 1)
+            vp8ft_row_done(pbi, mb_row - 2);
+#endif
+    }
+
+    pbi->next_mb_row = mb_row;
+
+    if (mb_row < pc->mb_rows)
+        return;
+
+    if (pbi->stats_enabled)
+        stat_mark = vpx_nsec_timestamp();
+
+    if (pbi->lf_rows_in_decode)
+    {
+        vp8_loop_filter_row(pc, dst_fb, pc->mb_rows - 1);
+
+        if (pbi->stats_enabled)
+            vp8d_stat_lap(stat_time, STAT_LOOP_FILTER, &stat_mark);
+    }
+
+    if (pbi->ext_rows_in_decode)
+    {
+        for (mb_row = pc->mb_rows > 1 ? pc->mb_rows - 2 : 0;
+             mb_row < pc->mb_rows; mb_row++)
+            vp8_extend_mb_row_borders(dst_fb, mb_row);
+
+        if (pbi->stats_enabled)
+            vp8d_stat_lap(stat_time, STAT_EXTEND, &stat_mark);
+    }
+}
+
+/* Decodes the MB rows left and completes the frame. */
+static int finish_frame(VP8D_COMP *pbi)
+{
+    vp8_reader *const bc = & pbi->bc;
+    VP8_COMMON *const pc = & pbi->common;
+    MACROBLOCKD *const xd  = & pbi->mb;
+    int corrupt_tokens = 0;
+
+    if (pbi->frame_skipped)
+        ;
+#if CONFIG_MULTITHREAD
+    else if (decode_rows_mt(pbi))
+    {
+        int i;
+        vp8mt_decode_mb_rows(pbi, xd);
+        for (i = 0; i < pbi->decoding_thread_count; ++i)
+            corrupt_tokens |= pbi->mb_row_di[i].mbd.corrupted;
+    }
+#endif
+    else
+    {
+        decode_mb_rows(pbi);
         corrupt_tokens |= xd->corrupted;
     }
 
@@ -1164,7 +1553,7 @@ int vp8_decode_frame(VP8D_COMP *pbi)
     if (pc->refresh_entropy_probs == 0)
     {
         vpx_memcpy(&pc->fc, &pc->lfc, sizeof(pc->fc));
-        pbi->independent_partitions = prev_independent_partitions;
+        pbi->independent_partitions = pbi->saved_independent_partitions;
     }
 
 #ifdef PACKET_TESTING
@@ -1179,3 +1568,54 @@ int vp8_decode_frame(VP8D_COMP *pbi)
 
     return 0;
 }
+
+int vp8_first_partition_received(VP8D_COMP *pbi)
+{
+    const unsigned char *data = pbi->fragments[0];
+    unsigned int first_partition_length;
+
+    /* Once a fragment follows it, the first fragment is complete */
+    if (pbi->num_fragments > 1)
+        return 1;
+
+    if (pbi->fragment_sizes[0] < 3)
+        return 0;
+
+    first_partition_length = (data[0] | (data[1] << 8) | (data[2] << 16)) >> 5;
+    return pbi->fragment_sizes[0] >=
+           ((data[0] & 1) ? 3 : 10) + first_partition_length;
+}
+
+int vp8_decode_frame(VP8D_COMP *pbi)
+{
+    if (pbi->frag_state != FRAG_DECODING)
+    {
+        int retcode = start_frame(pbi);
+
+        if (retcode)
+            return retcode;
+    }
+
+    unpack_fragments(pbi, 1);
+    return finish_frame(pbi);
+}
+
+int vp8_decode_frame_partial(VP8D_COMP *pbi)
+{
+    if (pbi->frag_state != FRAG_DECODING)
+    {
+        int retcode = start_frame(pbi);
+
+        if (retcode)
+            return retcode;
+
+        pbi->frag_state = FRAG_DECODING;
+    }
+
+    unpack_fragments(pbi, 0);
+
+    if (!pbi->frame_skipped && !decode_rows_mt(pbi))
+        decode_mb_rows(pbi);
+
+    return 0;
+}
@@ -39,32 +39,22 @@ DECLARE_ALIGNED(16, static const unsigned char, coef_bands_x[16]) =
 
 #define CAT1_MIN_VAL    5
 #define CAT2_MIN_VAL    7
-#define CAT3_MIN_VAL   11
-#define CAT4_MIN_VAL   19
-#define CAT5_MIN_VAL   35
-#define CAT6_MIN_VAL   67
 
 #define CAT1_PROB0    159
 #define CAT2_PROB0    145
 #define CAT2_PROB1    165
 
-#define CAT3_PROB0 140
-#define CAT3_PROB1 148
-#define CAT3_PROB2 173
-
-#define CAT4_PROB0 135
-#define CAT4_PROB1 140
-#define CAT4_PROB2 155
-#define CAT4_PROB3 176
-
-#define CAT5_PROB0 130
-#define CAT5_PROB1 134
-#define CAT5_PROB2 141
-#define CAT5_PROB3 157
-#define CAT5_PROB4 180
-
+/* Extra bits of DCT_VAL_CATEGORY3..6, most significant first. Category n
+ * starts at 3 + (8 << (n - 3)).
+ */
+static const unsigned char cat3_prob[4] = { 173, 148, 140, 0 };
+static const unsigned char cat4_prob[5] = { 176, 155, 140, 135, 0 };
+static const unsigned char cat5_prob[6] = { 180, 157, 141, 134, 130, 0 };
 static const unsigned char cat6_prob[12] =
-{ 129, 130, 133, 140, 153, 177, 196, 230, 243, 254, 254, 0 };
+{ 254, 254, 243, 230, 196, 177, 153, 140, 133, 130, 129, 0 };
+
+static const unsigned char *const cat3456_prob[4] =
+{ cat3_prob, cat4_prob, cat5_prob, cat6_prob };
 
 
 void vp8_reset_mb_tokens_context(MACROBLOCKD *x)
@@ -164,6 +154,23 @@ DECLARE_ALIGNED(16, extern const unsigned char, vp8_norm[256]);
     goto BLOCK_FINISHED;
 
 
+#define DECODE_BOOL(probability, bit) \
+    split = 1 +  (((range-1) * (probability)) >> 8); \
+    bigsplit = (VP8_BD_VALUE)split << (VP8_BD_VALUE_SIZE - 8); \
+    FILL \
+    if(value >= bigsplit) \
+    { \
+        range = range-split; \
+        value = value-bigsplit; \
+        bit = 1; \
+    } \
+    else \
+    { \
+        range = split; \
+        bit = 0; \
+    } \
+    NORMALIZE
+
 #define DECODE_EXTRABIT_AND_ADJUST_VAL(prob, bits_count)\
     split = 1 +  (((range-1) * prob) >> 8); \
     bigsplit = (VP8_BD_VALUE)split << (VP8_BD_VALUE_SIZE - 8); \
@@ -210,7 +217,9 @@ int vp8_decode_mb_tokens(VP8D_COMP *dx, MACROBLOCKD *x)
 
     const vp8_prob *coef_probs;
     int stop;
-    int val, bits_count;
+    int val;
+    int cat, bit;
+    const unsigned char *cat_prob;
     int c;
     int v;
     const vp8_prob *Prob;
@@ -266,47 +275,23 @@ CHECK_0_:
                               LOW_VAL_CONTEXT_NODE_0_);
     DECODE_AND_BRANCH_IF_ZERO(Prob[HIGH_LOW_CONTEXT_NODE],
                               HIGH_LOW_CONTEXT_NODE_0_);
-    DECODE_AND_BRANCH_IF_ZERO(Prob[CAT_THREEFOUR_CONTEXT_NODE],
-                              CAT_THREEFOUR_CONTEXT_NODE_0_);
-    DECODE_AND_BRANCH_IF_ZERO(Prob[CAT_FIVE_CONTEXT_NODE],
-                              CAT_FIVE_CONTEXT_NODE_0_);
 
-    val = CAT6_MIN_VAL;
-    bits_count = 10;
+    /* DCT_VAL_CATEGORY3..6: the last two tree levels give the category,
+     * whose extra bits are read from its table.
+     */
+    DECODE_BOOL(Prob[CAT_THREEFOUR_CONTEXT_NODE], cat);
+    DECODE_BOOL(Prob[CAT_THREE_CONTEXT_NODE + cat], bit);
+    cat = 2 * cat + bit;
+
+    val = 0;
 
-    do
+    for (cat_prob = cat3456_prob[cat]; *cat_prob; cat_prob++)
     {
-        DECODE_EXTRABIT_AND_ADJUST_VAL(cat6_prob[bits_count], bits_count);
-        bits_count -- ;
+        DECODE_BOOL(*cat_prob, bit);
+        val += val + bit;
     }
-    while (bits_count >= 0);
-
-    DECODE_SIGN_WRITE_COEFF_AND_CHECK_EXIT(val);
-
-CAT_FIVE_CONTEXT_NODE_0_:
-    val = CAT5_MIN_VAL;
-    DECODE_EXTRABIT_AND_ADJUST_VAL(CAT5_PROB4, 4);
-    DECODE_EXTRABIT_AND_ADJUST_VAL(CAT5_PROB3, 3);
-    DECODE_EXTRABIT_AND_ADJUST_VAL(CAT5_PROB2, 2);
-    DECODE_EXTRABIT_AND_ADJUST_VAL(CAT5_PROB1, 1);
-    DECODE_EXTRABIT_AND_ADJUST_VAL(CAT5_PROB0, 0);
-    DECODE_SIGN_WRITE_COEFF_AND_CHECK_EXIT(val);
-
-CAT_THREEFOUR_CONTEXT_NODE_0_:
-    DECODE_AND_BRANCH_IF_ZERO(Prob[CAT_THREE_CONTEXT_NODE],
-                              CAT_THREE_CONTEXT_NODE_0_);
-    val = CAT4_MIN_VAL;
-    DECODE_EXTRABIT_AND_ADJUST_VAL(CAT4_PROB3, 3);
-    DECODE_EXTRABIT_AND_ADJUST_VAL(CAT4_PROB2, 2);
-    DECODE_EXTRABIT_AND_ADJUST_VAL(CAT4_PROB1, 1);
-    DECODE_EXTRABIT_AND_ADJUST_VAL(CAT4_PROB0, 0);
-    DECODE_SIGN_WRITE_COEFF_AND_CHECK_EXIT(val);
 
-CAT_THREE_CONTEXT_NODE_0_:
-    val = CAT3_MIN_VAL;
-    DECODE_EXTRABIT_AND_ADJUST_VAL(CAT3_PROB2, 2);
-    DECODE_EXTRABIT_AND_ADJUST_VAL(CAT3_PROB1, 1);
-    DECODE_EXTRABIT_AND_ADJUST_VAL(CAT3_PROB0, 0);
+    val += 3 + (8 << cat);
     DECODE_SIGN_WRITE_COEFF_AND_CHECK_EXIT(val);
 
 HIGH_LOW_CONTEXT_NODE_0_:
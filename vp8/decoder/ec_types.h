@@ -29,6 +29,7 @@ typedef struct
 {
     /* TODO(holmer): This array should be exchanged for a linked list */
     OVERLAP_NODE overlaps[MAX_OVERLAPS];
+    int count;                  /* of the overlaps in use */
 } B_OVERLAP;
 
 /* Structure used to hold all the overlaps of a macroblock. The overlaps of a
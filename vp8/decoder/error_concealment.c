@@ -67,23 +67,19 @@ void vp8_de_alloc_overlap_lists(VP8D_COMP *pbi)
 }
 
 /* Inserts a new overlap area value to the list of overlaps of a block */
-static void assign_overlap(OVERLAP_NODE* overlaps,
+static void assign_overlap(B_OVERLAP *b_overlap,
                            union b_mode_info *bmi,
                            int overlap)
 {
-    int i;
     if (overlap <= 0)
         return;
-    /* Find and assign to the next empty overlap node in the list of overlaps.
-     * Empty is defined as bmi == NULL */
-    for (i = 0; i < MAX_OVERLAPS; i++)
+    /* Assign to the next empty overlap node in the list of overlaps */
+    if (b_overlap->count < MAX_OVERLAPS)
     {
-        if (overlaps[i].bmi == NULL)
-        {
-            overlaps[i].bmi = bmi;
-            overlaps[i].overlap = overlap;
-            break;
-        }
+        OVERLAP_NODE *node = &b_overlap->overlaps[b_overlap->count++];
+
+        node->bmi = bmi;
+        node->overlap = overlap;
     }
 }
 
@@ -163,15 +159,20 @@ static void calculate_overlaps_mb(B_OVERLAP *b_overlaps, union b_mode_info *bmi,
                                                       4) << 3),
                                                   (((first_blk_col + col) *
                                                       4) << 3));
-            assign_overlap(b_ol_ul[row * 4 + col].overlaps, bmi, overlap);
+            assign_overlap(&b_ol_ul[row * 4 + col], bmi, overlap);
         }
     }
 }
 
+/* Adds the overlaps of the block at (b_row, b_col) of the previous frame
+ * to the MBs it overlaps once motion compensated in reverse, if they are in
+ * the MB rows [mb_row_start, mb_row_end).
+ */
 void vp8_calculate_overlaps(MB_OVERLAP *overlap_ul,
                             int mb_rows, int mb_cols,
                             union b_mode_info *bmi,
-                            int b_row, int b_col)
+                            int b_row, int b_col,
+                            int mb_row_start, int mb_row_end)
 {
     MB_OVERLAP *mb_overlap;
     int row, col, rel_row, rel_col;
@@ -209,7 +210,10 @@ void vp8_calculate_overlaps(MB_OVERLAP *overlap_ul,
     overlap_mb_row = FLOOR((overlap_b_row << 3) / 4, 3) >> 3;
     overlap_mb_col = FLOOR((overlap_b_col << 3) / 4, 3) >> 3;
 
-    end_row = MIN(mb_rows - overlap_mb_row, 2);
+    if (overlap_mb_row + 1 < mb_row_start || overlap_mb_row >= mb_row_end)
+        return;
+
+    end_row = MIN(mb_row_end - overlap_mb_row, 2);
     end_col = MIN(mb_cols - overlap_mb_col, 2);
 
     /* Don't calculate overlap for MBs we don't overlap */
@@ -225,7 +229,7 @@ void vp8_calculate_overlaps(MB_OVERLAP *overlap_ul,
     {
         for (rel_col = 0; rel_col < end_col; ++rel_col)
         {
-            if (overlap_mb_row + rel_row < 0 ||
+            if (overlap_mb_row + rel_row < mb_row_start ||
                 overlap_mb_col + rel_col < 0)
                 continue;
             mb_overlap = overlap_ul + (overlap_mb_row + rel_row) * mb_cols +
@@ -245,18 +249,17 @@ void vp8_calculate_overlaps(MB_OVERLAP *overlap_ul,
  * Filters out all overlapping blocks which do not refer to the correct
  * reference frame type.
  */
-static void estimate_mv(const OVERLAP_NODE *overlaps, union b_mode_info *bmi)
+static void estimate_mv(const B_OVERLAP *b_overlap, union b_mode_info *bmi)
 {
+    const OVERLAP_NODE *overlaps = b_overlap->overlaps;
     int i;
     int overlap_sum = 0;
     int row_acc = 0;
     int col_acc = 0;
 
     bmi->mv.as_int = 0;
-    for (i=0; i < MAX_OVERLAPS; ++i)
+    for (i=0; i < b_overlap->count; ++i)
     {
-        if (overlaps[i].bmi == NULL)
-            break;
         col_acc += overlaps[i].overlap * overlaps[i].bmi->mv.as_mv.col;
         row_acc += overlaps[i].overlap * overlaps[i].bmi->mv.as_mv.row;
         overlap_sum += overlaps[i].overlap;
@@ -302,7 +305,7 @@ static void estimate_mb_mvs(const B_OVERLAP *block_overlaps,
             int this_b_to_right_edge = mb_to_right_edge - ((col*4)<<3);
             /* Estimate vectors for all blocks which are overlapped by this */
             /* type. Interpolate/extrapolate the rest of the block's MVs */
-            estimate_mv(block_overlaps[i].overlaps, &(bmi[i]));
+            estimate_mv(&block_overlaps[i], &(bmi[i]));
             mi->mbmi.need_to_clamp_mvs |= vp8_check_mv_bounds(
                                                          &bmi[i].mv,
                                                          this_b_to_left_edge,
@@ -326,7 +329,8 @@ static void estimate_mb_mvs(const B_OVERLAP *block_overlaps,
 
 static void calc_prev_mb_overlaps(MB_OVERLAP *overlaps, MODE_INFO *prev_mi,
                                     int mb_row, int mb_col,
-                                    int mb_rows, int mb_cols)
+                                    int mb_rows, int mb_cols,
+                                    int mb_row_start, int mb_row_end)
 {
     int sub_row;
     int sub_col;
@@ -338,20 +342,32 @@ static void calc_prev_mb_overlaps(MB_OVERLAP *overlaps, MODE_INFO *prev_mi,
                                 overlaps, mb_rows, mb_cols,
                                 &(prev_mi->bmi[sub_row * 4 + sub_col]),
                                 4 * mb_row + sub_row,
-                                4 * mb_col + sub_col);
+                                4 * mb_col + sub_col,
+                                mb_row_start, mb_row_end);
         }
     }
 }
 
-/* Estimate all missing motion vectors. This function does the same as the one
- * above, but has different input arguments. */
+/* Estimate the missing motion vectors of the MB rows [mb_row_start,
+ * mb_row_end). Only the overlap lists of these rows are used, and they are
+ * reset first, so rows can be estimated independently of one another. */
 static void estimate_missing_mvs(MB_OVERLAP *overlaps,
                                  MODE_INFO *mi, MODE_INFO *prev_mi,
                                  int mb_rows, int mb_cols,
-                                 unsigned int first_corrupt)
+                                 unsigned int first_corrupt,
+                                 int mb_row_start, int mb_row_end)
 {
     int mb_row, mb_col;
-    vpx_memset(overlaps, 0, sizeof(MB_OVERLAP) * mb_rows * mb_cols);
+    int i;
+
+    for (i = mb_row_start * mb_cols; i < mb_row_end * mb_cols; i++)
+    {
+        int b;
+
+        for (b = 0; b < 16; b++)
+            overlaps[i].overlaps[b].count = 0;
+    }
+
     /* First calculate the overlaps for all blocks */
     for (mb_row = 0; mb_row < mb_rows; ++mb_row)
     {
@@ -364,20 +380,24 @@ static void estimate_missing_mvs(MB_OVERLAP *overlaps,
             {
                 calc_prev_mb_overlaps(overlaps, prev_mi,
                                       mb_row, mb_col,
-                                      mb_rows, mb_cols);
+                                      mb_rows, mb_cols,
+                                      mb_row_start, mb_row_end);
             }
             ++prev_mi;
         }
         ++prev_mi;
     }
 
+    if (first_corrupt < (unsigned int)(mb_row_start * mb_cols))
+        first_corrupt = mb_row_start * mb_cols;
+
     mb_row = first_corrupt / mb_cols;
     mb_col = first_corrupt - mb_row * mb_cols;
     mi += mb_row*(mb_cols + 1) + mb_col;
     /* Go through all macroblocks in the current image with missing MVs
      * and calculate new MVs using the overlaps.
      */
-    for (; mb_row < mb_rows; ++mb_row)
+    for (; mb_row < mb_row_end; ++mb_row)
     {
         int mb_to_top_edge = -((mb_row * 16)) << 3;
         int mb_to_bottom_edge = ((mb_rows - 1 - mb_row) * 16) << 3;
@@ -405,13 +425,23 @@ static void estimate_missing_mvs(MB_OVERLAP *overlaps,
     }
 }
 
-void vp8_estimate_missing_mvs(VP8D_COMP *pbi)
+void vp8_estimate_missing_mvs_rows(VP8D_COMP *pbi,
+                                   int mb_row_start, int mb_row_end)
 {
     VP8_COMMON * const pc = &pbi->common;
     estimate_missing_mvs(pbi->overlaps,
                          pc->mi, pc->prev_mi,
                          pc->mb_rows, pc->mb_cols,
-                         pbi->mvs_corrupt_from_mb);
+                         pbi->mvs_corrupt_from_mb,
+                         mb_row_start, mb_row_end);
+}
+
+void vp8_estimate_missing_mvs(VP8D_COMP *pbi)
+{
+    VP8_COMMON * const pc = &pbi->common;
+    vp8_estimate_missing_mvs_rows(pbi,
+                                  pbi->mvs_corrupt_from_mb / pc->mb_cols,
+                                  pc->mb_rows);
 }
 
 static void assign_neighbor(EC_BLOCK *neighbor, MODE_INFO *mi, int block_idx)
@@ -24,6 +24,11 @@ void vp8_de_alloc_overlap_lists(VP8D_COMP *pbi);
 /* Estimate all missing motion vectors. */
 void vp8_estimate_missing_mvs(VP8D_COMP *pbi);
 
+/* Estimate the missing motion vectors of the MB rows [mb_row_start,
+ * mb_row_end), independently of the other rows. */
+void vp8_estimate_missing_mvs_rows(VP8D_COMP *pbi,
+                                   int mb_row_start, int mb_row_end);
+
 /* Functions for spatial MV interpolation */
 
 /* Interpolates all motion vectors for a macroblock mb at position
@@ -0,0 +1,996 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/* Frame threading: consecutive frames are decoded concurrently, each one by
+ * its own frame context (a VP8D_COMP without a decoder instance around it)
+ * running the serial decoder on a thread of its own.
+ *
+ * A frame depends on its predecessor in three ways:
+ *  - the entropy contexts, segmentation and loop filter deltas it carries
+ *    over, which are final once the predecessor parsed its header
+ *    (FT_SETUP_DONE),
+ *  - the segment map, which persists when not updated and is final once the
+ *    predecessor parsed its modes (FT_MODES_DONE),
+ *  - the reference buffers, which are waited on row by row: a frame
+ *    publishes its MB rows as they become final, and each MB row of a later
+ *    frame waits until the rows its motion vectors reach are published.
+ *
+ * The decoder instance owns the frame buffers of all frame contexts as one
+ * shared pool, keeps the reference buffer indices and reference counts, and
+ * returns the decoded frames in decode order. Output is delayed by up to
+ * frame_threads - 1 frames; a decode call without data flushes the frames
+ * still in flight.
+ */
+#include "vpx_config.h"
+#include "onyxd_int.h"
+#include "vpx_mem/vpx_mem.h"
+#include "vp8/common/threading.h"
+#include "vp8/common/alloccommon.h"
+#include "vp8/common/systemdependent.h"
+#include "vpx_scale/yv12extend.h"
+#include "vpx_scale/vpxscale.h"
+#include "decoderthreading.h"
+#include <limits.h>
+
+#if CONFIG_OPENCL
+#include "vp8/common/opencl/vp8_opencl.h"
+#endif
+
+
+static void wait_stage(FT_CONTEXT *ft, int stage)
+{
+    vp8_row_sync_wait(&ft->master->ft_sync, &ft->stage, stage);
+}
+
+static void post_stage(FT_CONTEXT *ft, int stage)
+{
+    vp8_row_sync_post(&ft->master->ft_sync, &ft->stage, stage);
+}
+
+static void wait_rows(VP8D_COMP *pbi, FT_FRAME_BUFFER *fb, int rows)
+{
+    vp8_row_sync_wait(&pbi->ft_sync, &fb->rows_done, rows);
+}
+
+static void post_rows(VP8D_COMP *pbi, FT_FRAME_BUFFER *fb, int rows)
+{
+    vp8_row_sync_post(&pbi->ft_sync, &fb->rows_done, rows);
+}
+
+static int get_free_fb(VP8D_COMP *pbi)
+{
+    const int num_fb = pbi->frame_threads * NUM_YV12_BUFFERS;
+    int i;
+
+    for (i = 0; i < num_fb; i++)
+        if (pbi->ft_fb[i].ref_cnt == 0)
+            break;
+
+    if (i == num_fb)
+        vpx_internal_error(&pbi->common.error, VPX_CODEC_ERROR,
+                           "No free frame buffer");
+
+    pbi->ft_fb[i].ref_cnt = 1;
+    return i;
+}
+
+static void ref_cnt_fb(FT_FRAME_BUFFER *fb, int *idx, int new_idx)
+{
+    if (fb[*idx].ref_cnt > 0)
+        fb[*idx].ref_cnt--;
+
+    *idx = new_idx;
+
+    fb[new_idx].ref_cnt++;
+}
+
+
+/* Frame context side */
+
+void vp8ft_frame_setup_done(VP8D_COMP *pbi)
+{
+    pbi->ft->setup_reached = 1;
+    post_stage(pbi->ft, FT_SETUP_DONE);
+}
+
+void vp8ft_modes_done(VP8D_COMP *pbi)
+{
+    FT_CONTEXT *const ft = pbi->ft;
+    VP8_COMMON *const pc = &pbi->common;
+    MACROBLOCKD *const xd = &pbi->mb;
+
+    /* Segment ids that this frame did not code, or reset on a key frame,
+     * persist from the previous frame.
+     */
+    if (ft->prev && (xd->update_mb_segmentation_map
+                     ? !xd->segmentation_enabled
+                     : pc->frame_type != KEY_FRAME))
+    {
+        const MODE_INFO *src = ft->prev->pbi->common.mi;
+        MODE_INFO *dst = pc->mi;
+        int mb_row, mb_col;
+
+        wait_stage(ft->prev, FT_MODES_DONE);
+
+        for (mb_row = 0; mb_row < pc->mb_rows; mb_row++)
+        {
+            for (mb_col = 0; mb_col < pc->mb_cols; mb_col++)
+                dst[mb_col].mbmi.segment_id = src[mb_col].mbmi.segment_id;
+
+            src += pc->mode_info_stride;
+            dst += pc->mode_info_stride;
+        }
+    }
+
+    post_stage(ft, FT_MODES_DONE);
+}
+
+void vp8ft_wait_ref_rows(VP8D_COMP *pbi, int mb_row)
+{
+    FT_CONTEXT *const ft = pbi->ft;
+    VP8_COMMON *const pc = &pbi->common;
+    const MODE_INFO *mi = pc->mi + mb_row * pc->mode_info_stride;
+    int max_mv_row[NUM_YV12_BUFFERS];
+    int mb_col, i;
+
+    for (i = 0; i < NUM_YV12_BUFFERS; i++)
+        max_mv_row[i] = INT_MIN;
+
+    for (mb_col = 0; mb_col < pc->mb_cols; mb_col++, mi++)
+    {
+        const MB_MODE_INFO *mbmi = &mi->mbmi;
+        int fb, mv_row;
+
+        if (mbmi->ref_frame == INTRA_FRAME)
+            continue;
+
+        if (mbmi->ref_frame == LAST_FRAME)
+            fb = pc->lst_fb_idx;
+        else if (mbmi->ref_frame == GOLDEN_FRAME)
+            fb = pc->gld_fb_idx;
+        else
+            fb = pc->alt_fb_idx;
+
+        mv_row = mbmi->mv.as_mv.row;
+
+        if (mbmi->mode == SPLITMV)
+        {
+            for (i = 0; i < 16; i++)
+                if (mi->bmi[i].mv.as_mv.row > mv_row)
+                    mv_row = mi->bmi[i].mv.as_mv.row;
+        }
+
+        if (mv_row > max_mv_row[fb])
+            max_mv_row[fb] = mv_row;
+    }
+
+    for (i = 0; i < NUM_YV12_BUFFERS; i++)
+    {
+        int last_line, rows;
+
+        if (max_mv_row[i] == INT_MIN)
+            continue;
+
+        ft->ref_used |= 1 << i;
+
+        /* Last luma line read, with room for the six-tap filter taps and
+         * for the rounding of the chroma motion vectors. Prediction
+         * reaching into the bottom border needs the whole frame.
+         */
+        last_line = mb_row * 16 + 15 + (max_mv_row[i] >> 3) + 8;
+        rows = (last_line >> 4) + 1;
+
+        if (rows < 1)
+            rows = 1;
+
+        if (rows > pc->mb_rows)
+            rows = pc->mb_rows;
+
+        wait_rows(ft->master, &ft->master->ft_fb[ft->fb_idx[i]], rows);
+    }
+}
+
+void vp8ft_row_done(VP8D_COMP *pbi, int mb_row)
+{
+    FT_CONTEXT *const ft = pbi->ft;
+    VP8_COMMON *const pc = &pbi->common;
+    FT_FRAME_BUFFER *const fb = &ft->master->ft_fb[ft->fb_idx[pc->new_fb_idx]];
+
+    /* The last row is published by decode_frame() once the frame's
+     * corruption state is known, together with the bottom border.
+     */
+    if (mb_row < pc->mb_rows - 1)
+        post_rows(ft->master, fb, mb_row + 1);
+}
+
+static void decode_frame(FT_CONTEXT *ft)
+{
+    VP8D_COMP *const pbi = ft->pbi;
+    VP8_COMMON *const pc = &pbi->common;
+    FT_FRAME_BUFFER *const fb = &ft->master->ft_fb[ft->fb_idx[pc->new_fb_idx]];
+    int i;
+
+    pbi->fragments[0] = ft->data;
+    pbi->fragment_sizes[0] = ft->data_sz;
+    pbi->num_fragments = 1;
+    pbi->common.error.error_code = VPX_CODEC_OK;
+
+    ft->setup_reached = 0;
+    ft->ref_used = 0;
+    ft->corrupt_last = 0;
+    ft->show = 0;
+
+    if (setjmp(pc->error.jmp))
+    {
+        pc->error.setjmp = 0;
+        ft->retcode = -1;
+        ft->corrupt_last = 1;
+
+        /* Let later frames using this one carry on. */
+        fb->fb.corrupted = 1;
+        post_rows(ft->master, fb, pc->mb_rows);
+        vp8_clear_system_state();
+        return;
+    }
+
+    pc->error.setjmp = 1;
+
+    ft->retcode = vp8_decode_frame(pbi);
+
+    if (ft->retcode < 0)
+    {
+        pc->error.error_code = VPX_CODEC_ERROR;
+        pc->error.setjmp = 0;
+        fb->fb.corrupted = 1;
+        post_rows(ft->master, fb, pc->mb_rows);
+        return;
+    }
+
+    /* propagate errors from reference frames */
+    for (i = 0; i < NUM_YV12_BUFFERS; i++)
+    {
+        if (ft->ref_used & (1 << i))
+        {
+            FT_FRAME_BUFFER *ref = &ft->master->ft_fb[ft->fb_idx[i]];
+
+            wait_rows(ft->master, ref, pc->mb_rows);
+            pc->yv12_fb[pc->new_fb_idx].corrupted |= ref->fb.corrupted;
+        }
+    }
+
+    fb->fb.corrupted = pc->yv12_fb[pc->new_fb_idx].corrupted;
+    post_rows(ft->master, fb, pc->mb_rows);
+
+    vp8_clear_system_state();
+
+    ft->show = pc->show_frame;
+    pc->error.setjmp = 0;
+}
+
+static THREAD_FUNCTION thread_frame_proc(void *p_data)
+{
+    FT_CONTEXT *ft = (FT_CONTEXT *)p_data;
+
+    while (1)
+    {
+        if (sem_wait(&ft->h_event_start) == 0)
+        {
+            if (ft->quit)
+                break;
+
+            decode_frame(ft);
+
+            post_stage(ft, FT_FRAME_DONE);
+            sem_post(&ft->h_event_done);
+        }
+    }
+
+    return 0 ;
+}
+
+
+/* Decoder instance side */
+
+/* Carries the state a frame inherits from the previous one. */
+static void copy_frame_state(VP8D_COMP *dst, VP8D_COMP *src)
+{
+    VP8_COMMON *const dc = &dst->common;
+    VP8_COMMON *const sc = &src->common;
+    MACROBLOCKD *const dxd = &dst->mb;
+    MACROBLOCKD *const sxd = &src->mb;
+
+    if (sc->refresh_entropy_probs)
+        vpx_memcpy(&dc->fc, &sc->fc, sizeof(dc->fc));
+    else
+        vpx_memcpy(&dc->fc, &sc->lfc, sizeof(dc->fc));
+
+    dc->clr_type = sc->clr_type;
+    dc->clamp_type = sc->clamp_type;
+    dc->horiz_scale = sc->horiz_scale;
+    dc->vert_scale = sc->vert_scale;
+    dc->multi_token_partition = sc->multi_token_partition;
+    dc->ref_frame_sign_bias[GOLDEN_FRAME] = sc->ref_frame_sign_bias[GOLDEN_FRAME];
+    dc->ref_frame_sign_bias[ALTREF_FRAME] = sc->ref_frame_sign_bias[ALTREF_FRAME];
+
+    dc->y1dc_delta_q = sc->y1dc_delta_q;
+    dc->y2dc_delta_q = sc->y2dc_delta_q;
+    dc->y2ac_delta_q = sc->y2ac_delta_q;
+    dc->uvdc_delta_q = sc->uvdc_delta_q;
+    dc->uvac_delta_q = sc->uvac_delta_q;
+    vpx_memcpy(dc->Y1dequant, sc->Y1dequant, sizeof(dc->Y1dequant));
+    vpx_memcpy(dc->Y2dequant, sc->Y2dequant, sizeof(dc->Y2dequant));
+    vpx_memcpy(dc->UVdequant, sc->UVdequant, sizeof(dc->UVdequant));
+
+    dxd->update_mb_segmentation_map = sxd->update_mb_segmentation_map;
+    dxd->mb_segement_abs_delta = sxd->mb_segement_abs_delta;
+    vpx_memcpy(dxd->segment_feature_data, sxd->segment_feature_data,
+               sizeof(dxd->segment_feature_data));
+    vpx_memcpy(dxd->mb_segment_tree_probs, sxd->mb_segment_tree_probs,
+               sizeof(dxd->mb_segment_tree_probs));
+    vpx_memcpy(dxd->ref_lf_deltas, sxd->ref_lf_deltas,
+               sizeof(dxd->ref_lf_deltas));
+    vpx_memcpy(dxd->mode_lf_deltas, sxd->mode_lf_deltas,
+               sizeof(dxd->mode_lf_deltas));
+}
+
+/* Applies the reference buffer updates of a frame, like
+ * swap_frame_buffers() does for the serial decoder.
+ */
+static int swap_frame_buffers(VP8D_COMP *pbi, FT_CONTEXT *ft)
+{
+    VP8_COMMON *const pc = &ft->pbi->common;
+    FT_FRAME_BUFFER *const fb = pbi->ft_fb;
+    const int new_idx = ft->fb_idx[pc->new_fb_idx];
+    int err = 0;
+
+    if (!ft->setup_reached)
+    {
+        /* The frame failed before its header was parsed. We do not know
+         * if it was supposed to update any of the reference buffers, but
+         * we act conservative and mark only the last buffer as corrupted.
+         */
+        if (ft->corrupt_last)
+            fb[pbi->ft_lst_idx].fb.corrupted = 1;
+
+        return 0;
+    }
+
+    if (pc->copy_buffer_to_arf)
+    {
+        if (pc->copy_buffer_to_arf == 1)
+            ref_cnt_fb(fb, &pbi->ft_alt_idx, pbi->ft_lst_idx);
+        else if (pc->copy_buffer_to_arf == 2)
+            ref_cnt_fb(fb, &pbi->ft_alt_idx, pbi->ft_gld_idx);
+        else
+            err = -1;
+    }
+
+    if (pc->copy_buffer_to_gf)
+    {
+        if (pc->copy_buffer_to_gf == 1)
+            ref_cnt_fb(fb, &pbi->ft_gld_idx, pbi->ft_lst_idx);
+        else if (pc->copy_buffer_to_gf == 2)
+            ref_cnt_fb(fb, &pbi->ft_gld_idx, pbi->ft_alt_idx);
+        else
+            err = -1;
+    }
+
+    if (pc->refresh_golden_frame)
+        ref_cnt_fb(fb, &pbi->ft_gld_idx, new_idx);
+
+    if (pc->refresh_alt_ref_frame)
+        ref_cnt_fb(fb, &pbi->ft_alt_idx, new_idx);
+
+    if (pc->refresh_last_frame)
+        ref_cnt_fb(fb, &pbi->ft_lst_idx, new_idx);
+
+    if (pc->show_frame)
+        pbi->common.current_video_frame++;
+
+    return err;
+}
+
+/* Waits for the last submitted frame to parse its header and applies its
+ * buffer updates, so that ft_lst_idx and friends are current.
+ */
+static void sync_references(VP8D_COMP *pbi)
+{
+    FT_CONTEXT *ft = pbi->ft_swap_ctx;
+
+    if (!ft)
+        return;
+
+    wait_stage(ft, FT_SETUP_DONE);
+    pbi->ft_swap_ctx = NULL;
+
+    if (swap_frame_buffers(pbi, ft))
+        vpx_internal_error(&pbi->common.error, VPX_CODEC_ERROR,
+                           "Invalid reference buffer update");
+}
+
+#if CONFIG_POSTPROC
+static void swap_postproc_state(VP8_COMMON *a, VP8_COMMON *b)
+{
+    YV12_BUFFER_CONFIG temp_fb;
+    struct postproc_state temp_state;
+
+    temp_fb = a->post_proc_buffer;
+    a->post_proc_buffer = b->post_proc_buffer;
+    b->post_proc_buffer = temp_fb;
+
+    temp_state = a->postproc_state;
+    a->postproc_state = b->postproc_state;
+    b->postproc_state = temp_state;
+}
+#endif
+
+/* Queues a decoded frame for output. Postprocessing runs here, in decode
+ * order and with the decoder instance's postprocessing state, so that it
+ * matches the serial decoder.
+ */
+static void output_frame(VP8D_COMP *pbi, FT_CONTEXT *ft, int new_idx)
+{
+    VP8D_COMP *const ctx = ft->pbi;
+    VP8_COMMON *const pc = &ctx->common;
+    FT_OUTPUT *out = &pbi->ft_out[pbi->ft_num_out];
+    int64_t time_end_stamp;
+    int ret;
+
+    pc->frame_to_show = &pc->yv12_fb[pc->new_fb_idx];
+    pc->current_video_frame++;
+    ctx->ready_for_new_data = 0;
+    ctx->last_time_stamp = ft->time_stamp;
+
+#if CONFIG_POSTPROC
+    swap_postproc_state(&pbi->common, pc);
+#endif
+    ret = vp8dx_get_raw_frame(ctx, &out->sd, &out->time_stamp,
+                              &time_end_stamp, &ft->ppflags);
+#if CONFIG_POSTPROC
+    swap_postproc_state(&pbi->common, pc);
+
+    /* The next frame postprocesses into the same buffer. */
+    if (!ret && ft->ppflags.post_proc_flag)
+    {
+        YV12_BUFFER_CONFIG *src = &pbi->common.post_proc_buffer;
+
+        if (!out->pp_buffer.buffer_alloc &&
+            vp8_yv12_alloc_frame_buffer(&out->pp_buffer, src->y_width,
+                                        src->y_height, VP8BORDERINPIXELS) < 0)
+            vpx_internal_error(&pbi->common.error, VPX_CODEC_MEM_ERROR,
+                               "Failed to allocate postproc buffer");
+
+        vp8_yv12_copy_frame_ptr(src, &out->pp_buffer);
+        out->pp_buffer.clrtype = out->sd.clrtype;
+        out->pp_buffer.y_width = out->sd.y_width;
+        out->pp_buffer.y_height = out->sd.y_height;
+        out->pp_buffer.uv_height = out->sd.uv_height;
+        out->sd = out->pp_buffer;
+        out->pp_buffer.y_width = src->y_width;
+        out->pp_buffer.y_height = src->y_height;
+        out->pp_buffer.uv_height = src->uv_height;
+    }
+#endif
+
+    /* The new buffer stays referenced until the next decode call. */
+    if (ret)
+        pbi->ft_fb[new_idx].ref_cnt--;
+    else
+    {
+        out->fb_idx = new_idx;
+        out->user_priv = ft->user_priv;
+        pbi->ft_num_out++;
+    }
+}
+
+/* Waits for the oldest frame in flight and queues it for output. */
+static void collect_frame(VP8D_COMP *pbi)
+{
+    VP8_COMMON *const cm = &pbi->common;
+    FT_CONTEXT *ft = &pbi->ft_ctx[pbi->ft_completed % pbi->frame_threads];
+    VP8_COMMON *const pc = &ft->pbi->common;
+    const int new_idx = ft->fb_idx[pc->new_fb_idx];
+    int i;
+
+    sem_wait(&ft->h_event_done);
+    pbi->ft_completed++;
+
+    for (i = 0; i < NUM_YV12_BUFFERS; i++)
+        if (i != pc->new_fb_idx && pbi->ft_fb[ft->fb_idx[i]].ref_cnt > 0)
+            pbi->ft_fb[ft->fb_idx[i]].ref_cnt--;
+
+    /* Frame level information reported for the last decoded frame. */
+    cm->refresh_golden_frame = pc->refresh_golden_frame;
+    cm->refresh_alt_ref_frame = pc->refresh_alt_ref_frame;
+    cm->refresh_last_frame = pc->refresh_last_frame;
+    cm->show_frame = ft->show;
+    cm->frame_to_show = &pbi->ft_fb[new_idx].fb;
+    pbi->ft_ref_frame_used =
+        ((ft->ref_used & (1 << pc->alt_fb_idx)) ? VP8_ALT_FLAG : 0) |
+        ((ft->ref_used & (1 << pc->gld_fb_idx)) ? VP8_GOLD_FLAG : 0) |
+        ((ft->ref_used & (1 << pc->lst_fb_idx)) ? VP8_LAST_FLAG : 0);
+
+    if (ft->retcode < 0)
+    {
+        pbi->ft_fb[new_idx].ref_cnt--;
+
+        if (!cm->error.error_code)
+        {
+            cm->error.error_code = pc->error.error_code;
+            cm->error.has_detail = pc->error.has_detail;
+            vpx_memcpy(cm->error.detail, pc->error.detail,
+                       sizeof(cm->error.detail));
+        }
+    }
+    else if (ft->show)
+        output_frame(pbi, ft, new_idx);
+    else
+        pbi->ft_fb[new_idx].ref_cnt--;
+
+    /* Frames are accounted in decode order, postprocessing included. */
+    if (pbi->stats_enabled && ft->retcode >= 0)
+        vp8dx_stats_frame_done(pbi, &ft->pbi->stats_frame);
+}
+
+static void collect_all_frames(VP8D_COMP *pbi)
+{
+    sync_references(pbi);
+
+    while (pbi->ft_completed != pbi->ft_submitted)
+        collect_frame(pbi);
+}
+
+static void release_output(VP8D_COMP *pbi)
+{
+    int i;
+
+    for (i = 0; i < pbi->ft_num_out; i++)
+        pbi->ft_fb[pbi->ft_out[i].fb_idx].ref_cnt--;
+
+    pbi->ft_num_out = 0;
+    pbi->ft_out_read = 0;
+}
+
+static void copy_data(unsigned char **buf, unsigned int *alloc_sz,
+                      unsigned int *sz, const unsigned char *source,
+                      unsigned long size, struct vpx_internal_error_info *error)
+{
+    if (size > *alloc_sz)
+    {
+        vpx_free(*buf);
+        *buf = vpx_malloc(size);
+        *alloc_sz = *buf ? size : 0;
+
+        if (!*buf)
+            vpx_internal_error(error, VPX_CODEC_MEM_ERROR,
+                               "Failed to allocate frame data");
+    }
+
+    vpx_memcpy(*buf, source, size);
+    *sz = size;
+}
+
+/* (Re)allocates the frame buffers of every frame context. The decoder must
+ * be idle.
+ */
+static void alloc_frame_buffers(VP8D_COMP *pbi, int width, int height)
+{
+    VP8_COMMON *const cm = &pbi->common;
+    int i, j;
+
+    for (i = 0; i < pbi->frame_threads; i++)
+    {
+        VP8_COMMON *const pc = &pbi->ft_ctx[i].pbi->common;
+        FT_FRAME_BUFFER *fb = &pbi->ft_fb[i * NUM_YV12_BUFFERS];
+
+        /* yv12_fb[] holds whatever buffers the last frame used. */
+        for (j = 0; j < NUM_YV12_BUFFERS; j++)
+            pc->yv12_fb[j] = fb[j].fb;
+
+        if (vp8_alloc_frame_buffers(pc, width, height))
+        {
+            vpx_memset(fb, 0, sizeof(*fb) * NUM_YV12_BUFFERS);
+            vpx_internal_error(&pbi->common.error, VPX_CODEC_MEM_ERROR,
+                               "Failed to allocate frame buffers");
+        }
+
+        pc->Width = width;
+        pc->Height = height;
+
+        for (j = 0; j < NUM_YV12_BUFFERS; j++)
+        {
+            fb[j].fb = pc->yv12_fb[j];
+            fb[j].ref_cnt = 0;
+            fb[j].rows_done = pc->mb_rows;
+        }
+    }
+
+    for (i = 0; i < pbi->frame_threads; i++)
+        vp8_yv12_de_alloc_frame_buffer(&pbi->ft_out[i].pp_buffer);
+
+    /* The decoder instance keeps the postprocessing state. */
+#if CONFIG_POSTPROC
+    if (cm->postproc_state.mfqe_buffer_used)
+    {
+        vp8_yv12_de_alloc_frame_buffer(&cm->postproc_state.mfqe_buffer);
+        cm->postproc_state.mfqe_buffer_used = 0;
+    }
+#endif
+
+    if (vp8_yv12_alloc_frame_buffer(&cm->post_proc_buffer,
+                                    pbi->ft_ctx[0].pbi->common.mb_cols * 16,
+                                    pbi->ft_ctx[0].pbi->common.mb_rows * 16,
+                                    VP8BORDERINPIXELS) < 0)
+        vpx_internal_error(&cm->error, VPX_CODEC_MEM_ERROR,
+                           "Failed to allocate frame buffers");
+
+    cm->Width = width;
+    cm->Height = height;
+    cm->mb_rows = pbi->ft_ctx[0].pbi->common.mb_rows;
+    cm->mb_cols = pbi->ft_ctx[0].pbi->common.mb_cols;
+
+    pbi->ft_lst_idx = 0;
+    pbi->ft_gld_idx = 1;
+    pbi->ft_alt_idx = 2;
+    pbi->ft_fb[0].ref_cnt = 1;
+    pbi->ft_fb[1].ref_cnt = 1;
+    pbi->ft_fb[2].ref_cnt = 1;
+}
+
+static void submit_frame(VP8D_COMP *pbi, const unsigned char *source,
+                         unsigned long size, int64_t time_stamp,
+                         void *user_priv)
+{
+    const int frame_threads = pbi->frame_threads;
+    FT_CONTEXT *ft = &pbi->ft_ctx[pbi->ft_submitted % frame_threads];
+    FT_CONTEXT *prev = NULL;
+    VP8D_COMP *ctx = ft->pbi;
+    VP8_COMMON *const pc = &ctx->common;
+    int i;
+
+    if (pbi->ft_submitted)
+        prev = &pbi->ft_ctx[(pbi->ft_submitted - 1) % frame_threads];
+
+    /* The frame following the context's last frame may still have to
+     * inherit that frame's segment map.
+     */
+    if (pbi->ft_submitted + 1 >= (unsigned int)frame_threads)
+        wait_stage(&pbi->ft_ctx[(pbi->ft_submitted + 1) % frame_threads],
+                   FT_MODES_DONE);
+
+    sync_references(pbi);
+
+    if (prev)
+        copy_frame_state(ctx, prev->pbi);
+
+    ft->fb_idx[pc->new_fb_idx] = get_free_fb(pbi);
+    ft->fb_idx[pc->lst_fb_idx] = pbi->ft_lst_idx;
+    ft->fb_idx[pc->gld_fb_idx] = pbi->ft_gld_idx;
+    ft->fb_idx[pc->alt_fb_idx] = pbi->ft_alt_idx;
+
+    for (i = 0; i < NUM_YV12_BUFFERS; i++)
+    {
+        FT_FRAME_BUFFER *fb = &pbi->ft_fb[ft->fb_idx[i]];
+
+        if (i != pc->new_fb_idx)
+            fb->ref_cnt++;
+
+        pc->yv12_fb[i] = fb->fb;
+    }
+
+    pbi->ft_fb[ft->fb_idx[pc->new_fb_idx]].rows_done = 0;
+
+    copy_data(&ft->data, &ft->data_alloc_sz, &ft->data_sz, source, size,
+              &pbi->common.error);
+
+    ctx->decoded_key_frame = pbi->decoded_key_frame;
+    pc->Width = pbi->common.Width;
+    pc->Height = pbi->common.Height;
+    pc->current_video_frame = pbi->common.current_video_frame;
+
+    ft->prev = prev;
+    ft->time_stamp = time_stamp;
+    ft->user_priv = user_priv;
+    ft->ppflags = pbi->ft_ppflags;
+    ctx->stats_enabled = pbi->stats_enabled;
+    ft->retcode = 0;
+    ft->stage = FT_DECODING;
+
+    if (size >= 3 && !(source[0] & 1))
+        pbi->decoded_key_frame = 1;
+
+    pbi->ft_swap_ctx = ft;
+    pbi->ft_submitted++;
+
+    sem_post(&ft->h_event_start);
+}
+
+int vp8ft_receive_compressed_data(VP8D_COMP *pbi, unsigned long size,
+                                  const unsigned char *source,
+                                  int64_t time_stamp)
+{
+    VP8_COMMON *const cm = &pbi->common;
+    int width = 0, height = 0;
+
+    cm->error.error_code = VPX_CODEC_OK;
+
+    if (setjmp(cm->error.jmp))
+    {
+        cm->error.setjmp = 0;
+        return -1;
+    }
+
+    cm->error.setjmp = 1;
+
+    release_output(pbi);
+
+    if (pbi->ft_pending_sz)
+    {
+        const unsigned int pending_sz = pbi->ft_pending_sz;
+
+        pbi->ft_pending_sz = 0;
+        alloc_frame_buffers(pbi, cm->Width, cm->Height);
+        submit_frame(pbi, pbi->ft_pending, pending_sz,
+                     pbi->ft_pending_time_stamp, pbi->ft_pending_user_priv);
+    }
+
+    /* A call without data flushes the decoder. */
+    if (size == 0)
+    {
+        collect_all_frames(pbi);
+        cm->error.setjmp = 0;
+        return cm->error.error_code ? -1 : 0;
+    }
+
+    /* Key frames changing the frame size need the contexts idle. */
+    if (size >= 10 && !(source[0] & 1) && source[3] == 0x9d &&
+        source[4] == 0x01 && source[5] == 0x2a)
+    {
+        width = (source[6] | (source[7] << 8)) & 0x3fff;
+        height = (source[8] | (source[9] << 8)) & 0x3fff;
+    }
+
+    if (width && height && (width != cm->Width || height != cm->Height))
+    {
+        collect_all_frames(pbi);
+        cm->Width = width;
+        cm->Height = height;
+
+        if (pbi->ft_num_out)
+        {
+            /* The frames just collected live in the buffers being
+             * resized. Keep the key frame until the next call.
+             */
+            copy_data(&pbi->ft_pending, &pbi->ft_pending_alloc_sz,
+                      &pbi->ft_pending_sz, source, size, &cm->error);
+            pbi->ft_pending_time_stamp = time_stamp;
+            pbi->ft_pending_user_priv = pbi->ft_user_priv;
+            cm->error.setjmp = 0;
+            return cm->error.error_code ? -1 : 0;
+        }
+
+        alloc_frame_buffers(pbi, width, height);
+    }
+
+    if (!cm->Width || !cm->Height)
+    {
+        vpx_internal_error(&cm->error, VPX_CODEC_ERROR,
+                           "A stream must start with a key frame");
+    }
+
+    /* Collect the frames that are done, and wait for the oldest one when
+     * every context is busy.
+     */
+    while (pbi->ft_completed != pbi->ft_submitted &&
+           pbi->ft_ctx[pbi->ft_completed % pbi->frame_threads].stage ==
+           FT_FRAME_DONE)
+        collect_frame(pbi);
+
+    if (pbi->ft_submitted - pbi->ft_completed == (unsigned int)pbi->frame_threads)
+        collect_frame(pbi);
+
+    submit_frame(pbi, source, size, time_stamp, pbi->ft_user_priv);
+
+    cm->error.setjmp = 0;
+    return cm->error.error_code ? -1 : 0;
+}
+
+int vp8ft_get_raw_frame(VP8D_COMP *pbi, YV12_BUFFER_CONFIG *sd,
+                        int64_t *time_stamp, int64_t *time_end_stamp,
+                        void **user_priv)
+{
+    FT_OUTPUT *out;
+
+    if (pbi->ft_out_read == pbi->ft_num_out)
+        return -1;
+
+    out = &pbi->ft_out[pbi->ft_out_read++];
+    *sd = out->sd;
+    *time_stamp = out->time_stamp;
+    *time_end_stamp = 0;
+    *user_priv = out->user_priv;
+
+    return 0;
+}
+
+static int *ref_fb_idx(VP8D_COMP *pbi, VP8_REFFRAME ref_frame_flag)
+{
+    if (ref_frame_flag == VP8_LAST_FLAG)
+        return &pbi->ft_lst_idx;
+    else if (ref_frame_flag == VP8_GOLD_FLAG)
+        return &pbi->ft_gld_idx;
+    else if (ref_frame_flag == VP8_ALT_FLAG)
+        return &pbi->ft_alt_idx;
+
+    vpx_internal_error(&pbi->common.error, VPX_CODEC_ERROR,
+                       "Invalid reference frame");
+    return NULL;
+}
+
+static int check_dimensions(const YV12_BUFFER_CONFIG *a,
+                            const YV12_BUFFER_CONFIG *b)
+{
+    return a->y_height == b->y_height && a->y_width == b->y_width &&
+           a->uv_height == b->uv_height && a->uv_width == b->uv_width;
+}
+
+int vp8ft_get_reference(VP8D_COMP *pbi, VP8_REFFRAME ref_frame_flag,
+                        YV12_BUFFER_CONFIG *sd)
+{
+    VP8_COMMON *const cm = &pbi->common;
+    FT_FRAME_BUFFER *fb;
+
+    if (setjmp(cm->error.jmp))
+    {
+        cm->error.setjmp = 0;
+        return cm->error.error_code;
+    }
+
+    cm->error.setjmp = 1;
+
+    if (!pbi->ft_submitted)
+        vpx_internal_error(&cm->error, VPX_CODEC_ERROR,
+                           "No reference frame decoded yet");
+
+    sync_references(pbi);
+    fb = &pbi->ft_fb[*ref_fb_idx(pbi, ref_frame_flag)];
+
+    if (!check_dimensions(&fb->fb, sd))
+        vpx_internal_error(&cm->error, VPX_CODEC_ERROR,
+                           "Incorrect buffer dimensions");
+
+    wait_rows(pbi, fb, cm->mb_rows);
+    vp8_yv12_copy_frame_ptr(&fb->fb, sd);
+
+    cm->error.setjmp = 0;
+    return cm->error.error_code;
+}
+
+int vp8ft_set_reference(VP8D_COMP *pbi, VP8_REFFRAME ref_frame_flag,
+                        YV12_BUFFER_CONFIG *sd)
+{
+    VP8_COMMON *const cm = &pbi->common;
+    int *ref_idx;
+    int free_fb;
+
+    if (setjmp(cm->error.jmp))
+    {
+        cm->error.setjmp = 0;
+        return cm->error.error_code;
+    }
+
+    cm->error.setjmp = 1;
+
+    if (!pbi->ft_submitted)
+        vpx_internal_error(&cm->error, VPX_CODEC_ERROR,
+                           "No reference frame decoded yet");
+
+    sync_references(pbi);
+    ref_idx = ref_fb_idx(pbi, ref_frame_flag);
+
+    if (!check_dimensions(&pbi->ft_fb[*ref_idx].fb, sd))
+        vpx_internal_error(&cm->error, VPX_CODEC_ERROR,
+                           "Incorrect buffer dimensions");
+
+    /* Frames in flight keep the buffer they reference; later frames use a
+     * copy of the new image.
+     */
+    free_fb = get_free_fb(pbi);
+    pbi->ft_fb[free_fb].ref_cnt--;
+    ref_cnt_fb(pbi->ft_fb, ref_idx, free_fb);
+    vp8_yv12_copy_frame_ptr(sd, &pbi->ft_fb[free_fb].fb);
+    pbi->ft_fb[free_fb].fb.corrupted = 0;
+    pbi->ft_fb[free_fb].rows_done = INT_MAX;
+
+    cm->error.setjmp = 0;
+    return cm->error.error_code;
+}
+
+void vp8ft_create_threads(VP8D_COMP *pbi, VP8D_CONFIG *oxcf)
+{
+    VP8D_CONFIG ctx_oxcf = *oxcf;
+    int i;
+
+    pbi->frame_threads = 0;
+
+    ctx_oxcf.max_threads = 1;
+    ctx_oxcf.frame_threading = 0;
+
+    if (vp8_row_sync_init(&pbi->ft_sync))
+        vpx_internal_error(&pbi->common.error, VPX_CODEC_MEM_ERROR,
+                           "Failed to initialize frame synchronization");
+
+    CHECK_MEM_ERROR(pbi->ft_ctx, vpx_calloc(oxcf->max_threads, sizeof(FT_CONTEXT)));
+    CHECK_MEM_ERROR(pbi->ft_fb, vpx_calloc(oxcf->max_threads * NUM_YV12_BUFFERS, sizeof(FT_FRAME_BUFFER)));
+    CHECK_MEM_ERROR(pbi->ft_out, vpx_calloc(oxcf->max_threads, sizeof(FT_OUTPUT)));
+
+    for (i = 0; i < oxcf->max_threads; i++)
+    {
+        FT_CONTEXT *ft = &pbi->ft_ctx[i];
+
+        CHECK_MEM_ERROR(ft->pbi, vp8dx_create_decompressor(&ctx_oxcf));
+        ft->pbi->ft = ft;
+        ft->master = pbi;
+        ft->stage = FT_FRAME_DONE;
+
+        sem_init(&ft->h_event_start, 0, 0);
+        sem_init(&ft->h_event_done, 0, 0);
+        pthread_create(&ft->h_thread, 0, thread_frame_proc, ft);
+
+        pbi->frame_threads++;
+    }
+}
+
+void vp8ft_remove_threads(VP8D_COMP *pbi)
+{
+    int i, j;
+
+    if (!pbi->ft_ctx)
+        return;
+
+    /* finish the frames in flight, ignoring their results */
+    while (pbi->ft_completed != pbi->ft_submitted)
+    {
+        FT_CONTEXT *ft = &pbi->ft_ctx[pbi->ft_completed++ % pbi->frame_threads];
+
+        sem_wait(&ft->h_event_done);
+    }
+
+    for (i = 0; i < pbi->frame_threads; i++)
+    {
+        FT_CONTEXT *ft = &pbi->ft_ctx[i];
+
+        ft->quit = 1;
+        sem_post(&ft->h_event_start);
+        pthread_join(ft->h_thread, NULL);
+        sem_destroy(&ft->h_event_start);
+        sem_destroy(&ft->h_event_done);
+
+        /* hand the context its own buffers back to free them */
+        for (j = 0; j < NUM_YV12_BUFFERS; j++)
+            ft->pbi->common.yv12_fb[j] =
+                pbi->ft_fb[i * NUM_YV12_BUFFERS + j].fb;
+
+        vp8dx_remove_decompressor(ft->pbi);
+        vpx_free(ft->data);
+    }
+
+    for (i = 0; i < pbi->frame_threads; i++)
+        vp8_yv12_de_alloc_frame_buffer(&pbi->ft_out[i].pp_buffer);
+
+    vpx_free(pbi->ft_pending);
+    vpx_free(pbi->ft_out);
+    vpx_free(pbi->ft_fb);
+    vpx_free(pbi->ft_ctx);
+    pbi->ft_ctx = NULL;
+    vp8_row_sync_destroy(&pbi->ft_sync);
+    pbi->frame_threads = 0;
+}
@@ -30,6 +30,7 @@
 #include "vp8/common/systemdependent.h"
 #include "vpx_ports/vpx_timer.h"
 #include "detokenize.h"
+#include "reduced.h"
 #if CONFIG_ERROR_CONCEALMENT
 #include "error_concealment.h"
 #endif
@@ -46,17 +47,9 @@ static cl_command_queue cl_commands = NULL;
 
 extern void vp8_init_loop_filter(VP8_COMMON *cm);
 extern void vp8cx_init_de_quantizer(VP8D_COMP *pbi);
-static int get_free_fb (VP8_COMMON *cm);
+static int get_free_fb (VP8D_COMP *pbi);
 static void ref_cnt_fb (int *buf, int *idx, int new_idx);
 
-#define PROFILE_OUTPUT 0
-#if PROFILE_OUTPUT
-struct vpx_usec_timer frame_timer;
-struct vpx_usec_timer loop_filter_timer;
-unsigned int total_mb = 0;
-unsigned int total_loop_filter = 0;
-#endif
-
 void vp8dx_initialize()
 {
     static int init_done = 0;
@@ -65,6 +58,9 @@ void vp8dx_initialize()
     {
         vp8_initialize_common();
         vp8_scale_machine_specific_config();
+#if CONFIG_MULTITHREAD
+        vp8_thread_pool_init();
+#endif
         init_done = 1;
     }
 }
@@ -96,7 +92,21 @@ struct VP8D_COMP * vp8dx_create_decompressor(VP8D_CONFIG *oxcf)
 
 #if CONFIG_MULTITHREAD
     pbi->max_threads = oxcf->max_threads;
-    vp8_decoder_create_threads(pbi);
+    pbi->use_thread_pool = oxcf->thread_pool;
+
+    /* Frame threading decodes whole frames from the input as it arrives.
+     * Error concealment and input fragments use the row threads.
+     */
+    if (oxcf->frame_threading && oxcf->max_threads > 1 &&
+        !oxcf->error_concealment && !oxcf->input_fragments &&
+        !oxcf->get_fb_cb
+#if CONFIG_OPENCL
+        && cl_initialized != CL_SUCCESS
+#endif
+        )
+        vp8ft_create_threads(pbi, oxcf);
+    else
+        vp8_decoder_create_threads(pbi);
 #endif
 
     /* vp8cx_init_de_quantizer() is first called here. Add check in frame_init_dequantizer() to avoid
@@ -123,6 +133,20 @@ struct VP8D_COMP * vp8dx_create_decompressor(VP8D_CONFIG *oxcf)
     pbi->input_fragments = oxcf->input_fragments;
     pbi->num_fragments = 0;
 
+    /* Frames are decoded into the application's buffers when it supplies
+     * them, except with OpenCL, which mirrors the internal buffers.
+     */
+    if (oxcf->get_fb_cb && oxcf->release_fb_cb
+#if CONFIG_OPENCL
+        && cl_initialized != CL_SUCCESS
+#endif
+        )
+    {
+        pbi->get_fb_cb = oxcf->get_fb_cb;
+        pbi->release_fb_cb = oxcf->release_fb_cb;
+        pbi->fb_cb_priv = oxcf->fb_cb_priv;
+    }
+
     /* Independent partitions is activated when a frame updates the
      * token probability table to have equal probabilities over the
      * PREV_COEF context.
@@ -148,10 +172,14 @@ void vp8dx_remove_decompressor(VP8D_COMP *pbi)
     if (pbi->b_multithreaded_rd)
         vp8mt_de_alloc_temp_buffers(pbi, pbi->common.mb_rows);
     vp8_decoder_remove_threads(pbi);
+    vp8ft_remove_threads(pbi);
 #endif
 #if CONFIG_ERROR_CONCEALMENT
     vp8_de_alloc_overlap_lists(pbi);
 #endif
+    if (pbi->get_fb_cb)
+        vp8dx_release_external_fbs(pbi, 1);
+    vp8dx_free_reduced_frames(pbi);
     vp8_remove_common(&pbi->common);
     vpx_free(pbi->mbc);
     vpx_free(pbi);
@@ -163,6 +191,21 @@ vpx_codec_err_t vp8dx_get_reference(VP8D_COMP *pbi, VP8_REFFRAME ref_frame_flag,
     VP8_COMMON *cm = &pbi->common;
     int ref_fb_idx;
 
+#if CONFIG_MULTITHREAD
+    if (pbi->frame_threads)
+        return vp8ft_get_reference(pbi, ref_frame_flag, sd);
+#endif
+
+    /* At reduced resolution, the full size reference frames are not kept
+     * up to date.
+     */
+    if (pbi->rr_scale)
+    {
+        vpx_internal_error(&pbi->common.error, VPX_CODEC_INCAPABLE,
+            "Not supported at reduced resolution");
+        return pbi->common.error.error_code;
+    }
+
     if (ref_frame_flag == VP8_LAST_FLAG)
         ref_fb_idx = cm->lst_fb_idx;
     else if (ref_frame_flag == VP8_GOLD_FLAG)
@@ -195,6 +238,21 @@ vpx_codec_err_t vp8dx_set_reference(VP8D_COMP *pbi, VP8_REFFRAME ref_frame_flag,
     int *ref_fb_ptr = NULL;
     int free_fb;
 
+#if CONFIG_MULTITHREAD
+    if (pbi->frame_threads)
+        return vp8ft_set_reference(pbi, ref_frame_flag, sd);
+#endif
+
+    /* At reduced resolution, frames are predicted from the reduced
+     * reference frames, not these.
+     */
+    if (pbi->rr_scale)
+    {
+        vpx_internal_error(&pbi->common.error, VPX_CODEC_INCAPABLE,
+            "Not supported at reduced resolution");
+        return pbi->common.error.error_code;
+    }
+
     if (ref_frame_flag == VP8_LAST_FLAG)
         ref_fb_ptr = &cm->lst_fb_idx;
     else if (ref_frame_flag == VP8_GOLD_FLAG)
@@ -216,11 +274,17 @@ vpx_codec_err_t vp8dx_set_reference(VP8D_COMP *pbi, VP8_REFFRAME ref_frame_flag,
     }
     else{
         /* Find an empty frame buffer. */
-        free_fb = get_free_fb(cm);
+        free_fb = get_free_fb(pbi);
         /* Decrease fb_idx_ref_cnt since it will be increased again in
          * ref_cnt_fb() below. */
         cm->fb_idx_ref_cnt[free_fb]--;
 
+        if (pbi->get_fb_cb && vp8dx_get_external_fb(pbi, free_fb))
+        {
+            pbi->common.error.error_code = VPX_CODEC_MEM_ERROR;
+            return pbi->common.error.error_code;
+        }
+
         /* Manage the reference counters and copy image. */
         ref_cnt_fb (cm->fb_idx_ref_cnt, ref_fb_ptr, free_fb);
         vp8_yv12_copy_frame_ptr(sd, &cm->yv12_fb[*ref_fb_ptr]);
@@ -235,9 +299,14 @@ extern void vp8_push_neon(int64_t *store);
 extern void vp8_pop_neon(int64_t *store);
 #endif
 
-static int get_free_fb (VP8_COMMON *cm)
+static int get_free_fb (VP8D_COMP *pbi)
 {
+    VP8_COMMON *cm = &pbi->common;
     int i;
+
+    if (pbi->get_fb_cb)
+        vp8dx_release_external_fbs(pbi, 0);
+
     for (i = 0; i < NUM_YV12_BUFFERS; i++)
         if (cm->fb_idx_ref_cnt[i] == 0)
             break;
@@ -247,6 +316,70 @@ static int get_free_fb (VP8_COMMON *cm)
     return i;
 }
 
+static void release_external_fb (VP8D_COMP *pbi, int idx)
+{
+    YV12_BUFFER_CONFIG *ybf = &pbi->common.yv12_fb[idx];
+
+    pbi->release_fb_cb(pbi->fb_cb_priv, &pbi->ext_fb[idx]);
+    vpx_memset(&pbi->ext_fb[idx], 0, sizeof(pbi->ext_fb[idx]));
+
+    /* Forget the planes, unless the frame buffers were reallocated since. */
+    if (!ybf->buffer_alloc)
+        vp8_yv12_de_alloc_frame_buffer(ybf);
+}
+
+/* Backs frame buffer idx with a buffer from the application, in place of
+ * its own allocation.
+ */
+int vp8dx_get_external_fb(VP8D_COMP *pbi, int idx)
+{
+    VP8_COMMON *cm = &pbi->common;
+    vpx_codec_frame_buffer_t *fb = &pbi->ext_fb[idx];
+    /* our internal buffers are always multiples of 16 */
+    const int width = (cm->Width + 15) & ~15;
+    const int height = (cm->Height + 15) & ~15;
+    const int frame_size = vp8_yv12_frame_buffer_size(width, height,
+                                                      VP8BORDERINPIXELS);
+    /* Room to align the planes as in the internal buffers. */
+    const size_t min_size = frame_size + 31;
+    unsigned char *buffer;
+
+    if (fb->data)
+        release_external_fb(pbi, idx);
+
+    if (frame_size < 0)
+        return -1;
+
+    if (pbi->get_fb_cb(pbi->fb_cb_priv, min_size, fb) < 0 || !fb->data)
+    {
+        vpx_memset(fb, 0, sizeof(*fb));
+        return -1;
+    }
+
+    if (fb->size < min_size)
+    {
+        release_external_fb(pbi, idx);
+        return -1;
+    }
+
+    buffer = (unsigned char *)(((uintptr_t)fb->data + 31) & ~(uintptr_t)31);
+
+    return vp8_yv12_wrap_frame_buffer(&cm->yv12_fb[idx], width, height,
+                                      VP8BORDERINPIXELS, buffer);
+}
+
+/* Gives the application back the buffers of the frame buffers that are no
+ * longer referenced, or all of them.
+ */
+void vp8dx_release_external_fbs(VP8D_COMP *pbi, int all)
+{
+    int i;
+
+    for (i = 0; i < NUM_YV12_BUFFERS; i++)
+        if (pbi->ext_fb[i].data && (all || !pbi->common.fb_idx_ref_cnt[i]))
+            release_external_fb(pbi, i);
+}
+
 static void ref_cnt_fb (int *buf, int *idx, int new_idx)
 {
     if (buf[*idx] > 0)
@@ -315,6 +448,125 @@ static int swap_frame_buffers (VP8_COMMON *cm)
     return err;
 }
 
+void vp8dx_put_rows(VP8D_COMP *pbi, int mb_row_end)
+{
+    VP8_COMMON *cm = &pbi->common;
+    YV12_BUFFER_CONFIG sd;
+    int row_end;
+
+    if (!pbi->put_rows_active || mb_row_end <= pbi->mb_rows_put)
+        return;
+
+    /* As output by vp8dx_get_raw_frame() */
+    sd = cm->yv12_fb[cm->new_fb_idx];
+    sd.clrtype = cm->clr_type;
+    sd.y_width = cm->Width;
+    sd.y_height = cm->Height;
+    sd.uv_height = cm->Height / 2;
+
+    row_end = mb_row_end < cm->mb_rows ? mb_row_end * 16 : cm->Height;
+    pbi->put_rows(pbi->put_rows_priv, &sd, pbi->mb_rows_put * 16, row_end);
+    pbi->mb_rows_put = mb_row_end;
+}
+
+void vp8dx_stats_frame_done(VP8D_COMP *pbi, const VP8D_STATS *frame)
+{
+    VP8D_STATS *total = &pbi->stats_total;
+    int i;
+
+    if (frame != &pbi->stats_frame)
+        pbi->stats_frame = *frame;
+
+    pbi->stats_frame.frames = 1;
+    total->frames++;
+
+    for (i = 0; i < STAT_TIMES; i++)
+        total->time[i] += frame->time[i];
+
+    for (i = 0; i < MAX_PARTITIONS; i++)
+        total->partition_bytes[i] += frame->partition_bytes[i];
+}
+
+/* Decodes the frame of the fragments received so far, as far as they
+ * allow. Errors are reported once the whole frame has been received, as
+ * when the frame is decoded at once.
+ */
+static void decode_fragments(VP8D_COMP *pbi)
+{
+#if HAVE_NEON
+    int64_t dx_store_reg[8];
+#endif
+    VP8_COMMON *cm = &pbi->common;
+
+#if CONFIG_OPENCL
+    /* The OpenCL decoder is set up for whole frames. */
+    if (cl_initialized == CL_SUCCESS)
+        return;
+#endif
+
+    if (pbi->frag_state == FRAG_NONE && !vp8_first_partition_received(pbi))
+        return;
+
+#if HAVE_NEON
+#if CONFIG_RUNTIME_CPU_DETECT
+    if (cm->cpu_caps & HAS_NEON)
+#endif
+    {
+        vp8_push_neon(dx_store_reg);
+    }
+#endif
+
+    if (pbi->frag_state == FRAG_NONE)
+        cm->new_fb_idx = get_free_fb (pbi);
+
+    if (setjmp(cm->error.jmp))
+    {
+#if HAVE_NEON
+#if CONFIG_RUNTIME_CPU_DETECT
+        if (cm->cpu_caps & HAS_NEON)
+#endif
+        {
+            vp8_pop_neon(dx_store_reg);
+        }
+#endif
+        cm->error.setjmp = 0;
+
+        /* As when the whole frame fails, mark only the last buffer as
+         * corrupted.
+         */
+        cm->yv12_fb[cm->lst_fb_idx].corrupted = 1;
+
+        if (cm->fb_idx_ref_cnt[cm->new_fb_idx] > 0)
+            cm->fb_idx_ref_cnt[cm->new_fb_idx]--;
+        pbi->frag_error = cm->error.error_code;
+        pbi->frag_state = FRAG_FAILED;
+        return;
+    }
+
+    cm->error.setjmp = 1;
+
+    if (vp8_decode_frame_partial(pbi) < 0)
+    {
+        if (cm->fb_idx_ref_cnt[cm->new_fb_idx] > 0)
+            cm->fb_idx_ref_cnt[cm->new_fb_idx]--;
+        pbi->frag_error = VPX_CODEC_ERROR;
+        pbi->frag_state = FRAG_FAILED;
+    }
+
+    cm->error.setjmp = 0;
+
+#if HAVE_NEON
+#if CONFIG_RUNTIME_CPU_DETECT
+    if (cm->cpu_caps & HAS_NEON)
+#endif
+    {
+        vp8_pop_neon(dx_store_reg);
+    }
+#endif
+
+    vp8_clear_system_state();
+}
+
 int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsigned char *source, int64_t time_stamp)
 {
 #if HAVE_NEON
@@ -322,6 +574,7 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
 #endif
     VP8_COMMON *cm = &pbi->common;
     int retcode = 0;
+    int64_t stat_mark = 0;
 
     /*if(pbi->ready_for_new_data == 0)
         return -1;*/
@@ -331,7 +584,14 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
         return -1;
     }
 
+#if CONFIG_MULTITHREAD
+    if (pbi->frame_threads)
+        return vp8ft_receive_compressed_data(pbi, size, source, time_stamp);
+#endif
+
     pbi->common.error.error_code = VPX_CODEC_OK;
+    if (pbi->frag_state == FRAG_NONE)
+        pbi->frame_skipped = 0;
 
     if (pbi->num_fragments == 0)
     {
@@ -341,23 +601,70 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
     }
     if (pbi->input_fragments && !(source == NULL && size == 0))
     {
-        /* Store a pointer to this fragment and return. We haven't
-         * received the complete frame yet, so we will wait with decoding.
+        /* Store a pointer to this fragment, and decode the frame as far as
+         * the fragments received so far allow. While the frame is decoded,
+         * a fragment that continues the last one in memory extends it, and
+         * any other goes to the entry of the first partition not found yet.
+         */
+        unsigned int last = pbi->num_fragments;
+        int extend;
+
+        /* The rest of a failed frame is dropped. Its error is reported once
+         * the frame is complete.
          */
-        assert(pbi->num_fragments < MAX_PARTITIONS);
-        pbi->fragments[pbi->num_fragments] = source;
-        pbi->fragment_sizes[pbi->num_fragments] = size;
-        pbi->num_fragments++;
-        if (pbi->num_fragments > (1 << EIGHT_PARTITION) + 1)
+        if (pbi->frag_state == FRAG_FAILED)
+            return 0;
+
+        while (last > 0 && !pbi->fragment_sizes[last - 1])
+            last--;
+
+        extend = size && last > 0 &&
+                 pbi->fragments[last - 1] + pbi->fragment_sizes[last - 1]
+                 == source &&
+                 (pbi->frag_state == FRAG_DECODING ||
+                  (pbi->frag_state == FRAG_NONE && pbi->num_fragments == 1 &&
+                   !vp8_first_partition_received(pbi)));
+
+        if (extend)
+            pbi->fragment_sizes[last - 1] += size;
+        else
         {
-            pbi->common.error.error_code = VPX_CODEC_UNSUP_BITSTREAM;
-            pbi->common.error.setjmp = 0;
-            pbi->num_fragments = 0;
-            return -1;
+            if (size && pbi->frag_state == FRAG_DECODING &&
+                pbi->num_fragments < (unsigned int)pbi->token_decoders_started + 1)
+                pbi->num_fragments = pbi->token_decoders_started + 1;
+
+            /* More fragments than partitions: drop the rest of the frame,
+             * and report the error again once it is complete.
+             */
+            if (pbi->num_fragments >= MAX_PARTITIONS)
+            {
+                if (pbi->frag_state == FRAG_DECODING &&
+                    cm->fb_idx_ref_cnt[cm->new_fb_idx] > 0)
+                    cm->fb_idx_ref_cnt[cm->new_fb_idx]--;
+                pbi->frag_error = VPX_CODEC_UNSUP_BITSTREAM;
+                pbi->frag_state = FRAG_FAILED;
+                pbi->common.error.error_code = VPX_CODEC_UNSUP_BITSTREAM;
+                pbi->common.error.setjmp = 0;
+                return -1;
+            }
+
+            pbi->fragments[pbi->num_fragments] = source;
+            pbi->fragment_sizes[pbi->num_fragments] = size;
+            pbi->num_fragments++;
         }
+
+        decode_fragments(pbi);
         return 0;
     }
 
+    if (pbi->frag_state == FRAG_FAILED)
+    {
+        pbi->common.error.error_code = pbi->frag_error;
+        pbi->frag_state = FRAG_NONE;
+        pbi->num_fragments = 0;
+        return -1;
+    }
+
     if (!pbi->input_fragments)
     {
         pbi->fragments[0] = source;
@@ -385,10 +692,23 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
              * corrupt, otherwise we will make multiple buffers corrupt.
              */
             const int prev_idx = cm->lst_fb_idx;
+            const int free_fb = get_free_fb(pbi);
+
+            if (pbi->get_fb_cb && vp8dx_get_external_fb(pbi, free_fb))
+            {
+                cm->fb_idx_ref_cnt[free_fb]--;
+                pbi->common.error.error_code = VPX_CODEC_MEM_ERROR;
+                pbi->num_fragments = 0;
+                return -1;
+            }
+
             cm->fb_idx_ref_cnt[prev_idx]--;
-            cm->lst_fb_idx = get_free_fb(cm);
+            cm->lst_fb_idx = free_fb;
             vp8_yv12_copy_frame_ptr(&cm->yv12_fb[prev_idx],
                                     &cm->yv12_fb[cm->lst_fb_idx]);
+            if (pbi->rr_scale)
+                vp8_yv12_copy_frame_ptr(&pbi->rr_fb[prev_idx],
+                                        &pbi->rr_fb[cm->lst_fb_idx]);
         }
         /* This is used to signal that we are missing frames.
          * We do not know if the missing frame(s) was supposed to update
@@ -415,7 +735,8 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
     }
 #endif
 
-    cm->new_fb_idx = get_free_fb (cm);
+    if (pbi->frag_state == FRAG_NONE)
+        cm->new_fb_idx = get_free_fb (pbi);
 
     if (setjmp(pbi->common.error.jmp))
     {
@@ -430,6 +751,7 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
         pbi->common.error.setjmp = 0;
 
         pbi->num_fragments = 0;
+        pbi->frag_state = FRAG_NONE;
 
        /* We do not know if the missing frame(s) was supposed to update
         * any of the reference buffers, but we act conservative and
@@ -502,21 +824,10 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
 #endif
 #endif
 
-#if PROFILE_OUTPUT
-    printf("Frame size = %d * %d\n", cm->Height, cm->Width);
-    printf("Macroblocks = %d * %d\n", cm->mb_rows, cm->mb_cols);
-
-    vpx_usec_timer_start(&frame_timer);
-#endif
-
     pbi->common.error.setjmp = 1;
 
     retcode = vp8_decode_frame(pbi);
-
-#if PROFILE_OUTPUT
-    vpx_usec_timer_mark(&frame_timer);
-    total_mb += vpx_usec_timer_elapsed(&frame_timer);
-#endif
+    pbi->frag_state = FRAG_NONE;
 
     if (retcode < 0)
     {
@@ -537,7 +848,7 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
     }
 
 #if CONFIG_MULTITHREAD
-    if (pbi->b_multithreaded_rd && cm->multi_token_partition != ONE_PARTITION)
+    if (pbi->b_multithreaded_rd && !pbi->rr_frame && (cm->multi_token_partition != ONE_PARTITION || pbi->mt_pipeline))
     {
         if (swap_frame_buffers (cm))
         {
@@ -573,38 +884,30 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
             return -1;
         }
 
-        if(cm->filter_level)
-        {
+        if (pbi->stats_enabled)
+            stat_mark = vpx_nsec_timestamp();
 
-#if PROFILE_OUTPUT
-            struct vpx_usec_timer lpftimer;
-            vpx_usec_timer_start(&lpftimer);
-#endif
-           
+        if(cm->filter_level && !pbi->lf_rows_in_decode && !pbi->frame_skipped &&
+           !pbi->rr_frame)
+        {
             /* Apply the loop filter if appropriate. */
             vp8_loop_filter_frame(cm, &pbi->mb);
 
-#if PROFILE_OUTPUT
-            vpx_usec_timer_mark(&lpftimer);
-            pbi->time_loop_filtering += vpx_usec_timer_elapsed(&lpftimer);
-
-            printf("Loop Filter\n");
-            total_loop_filter += vpx_usec_timer_elapsed(&lpftimer);
-#if 0
-            if (pbi->common.filter_type == NORMAL_LOOPFILTER){
-                printf("Normal LF Time (us): %d\n", vpx_usec_timer_elapsed(&lpftimer));
-            } else {
-                printf("Simple LF Time (us): %d\n", vpx_usec_timer_elapsed(&lpftimer));
-            }
-#endif
-#endif
+            if (pbi->stats_enabled)
+                vp8d_stat_lap(pbi->stats_frame.time, STAT_LOOP_FILTER,
+                              &stat_mark);
         }
-#if PROFILE_OUTPUT
-        else {
-            printf("No Loop Filter\n");
+
+        if (!pbi->frame_skipped)
+        {
+            if (pbi->rr_frame)
+                vp8_yv12_extend_frame_borders(&pbi->rr_fb[cm->new_fb_idx]);
+            else if (!pbi->ext_rows_in_decode)
+                vp8_yv12_extend_frame_borders_ptr(cm->frame_to_show);
+
+            if (pbi->stats_enabled)
+                vp8d_stat_lap(pbi->stats_frame.time, STAT_EXTEND, &stat_mark);
         }
-#endif
-        vp8_yv12_extend_frame_borders_ptr(cm->frame_to_show);
     }
 
 #if CONFIG_OPENCL && ENABLE_CL_SUBPIXEL
@@ -617,6 +920,12 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
     }
 #endif
 
+    /* The rows that were not final while they were decoded are now */
+    vp8dx_put_rows(pbi, cm->mb_rows);
+
+    if (pbi->rr_scale && !pbi->rr_frame)
+        vp8dx_reduce_frame(pbi);
+
     vp8_clear_system_state();
 
 #if CONFIG_ERROR_CONCEALMENT
@@ -694,13 +1003,8 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
 #endif
     pbi->common.error.setjmp = 0;
 
-
-#if PROFILE_OUTPUT
-    //Dump the total MB/Loop Filter processing times.
-    //This is cumulative between frames, so only use the last output value.
-    printf("MB Time (us): %d, LF Time (us): %d\n", total_mb, total_loop_filter);
-#endif
-
+    if (pbi->stats_enabled)
+        vp8dx_stats_frame_done(pbi, &pbi->stats_frame);
 
     return retcode;
 }
@@ -708,6 +1012,12 @@ int vp8dx_get_raw_frame(VP8D_COMP *pbi, YV12_BUFFER_CONFIG *sd, int64_t *time_st
 {
     int ret = -1;
 
+#if CONFIG_MULTITHREAD
+    if (pbi->frame_threads)
+        return vp8ft_get_raw_frame(pbi, sd, time_stamp, time_end_stamp,
+                                   &pbi->ft_out_user_priv);
+#endif
+
     if (pbi->ready_for_new_data == 1)
         return ret;
 
@@ -720,8 +1030,46 @@ int vp8dx_get_raw_frame(VP8D_COMP *pbi, YV12_BUFFER_CONFIG *sd, int64_t *time_st
     *time_end_stamp = 0;
 
     sd->clrtype = pbi->common.clr_type;
+
+    /* Reduced resolution frames are not postprocessed. */
+    if (pbi->rr_scale)
+    {
+        const int scale = pbi->rr_scale;
+
+        *sd = pbi->rr_fb[pbi->common.frame_to_show - pbi->common.yv12_fb];
+        sd->clrtype = pbi->common.clr_type;
+        sd->y_width = (pbi->common.Width + (1 << scale) - 1) >> scale;
+        sd->y_height = (pbi->common.Height + (1 << scale) - 1) >> scale;
+        sd->uv_width = (sd->y_width + 1) >> 1;
+        sd->uv_height = (sd->y_height + 1) >> 1;
+        vp8_clear_system_state();
+        return 0;
+    }
+
 #if CONFIG_POSTPROC
-    ret = vp8_post_proc_frame(&pbi->common, sd, flags);
+    {
+        int64_t stat_mark = 0;
+
+        if (pbi->stats_enabled)
+            stat_mark = vpx_nsec_timestamp();
+
+#if CONFIG_MULTITHREAD
+        if (pbi->b_multithreaded_rd)
+            ret = vp8_post_proc_frame_mt(&pbi->common, sd, flags,
+                                         vp8mt_run_post_proc_pass, pbi);
+        else
+#endif
+            ret = vp8_post_proc_frame(&pbi->common, sd, flags);
+
+        /* The frame's statistics are out, so the totals take the time too */
+        if (pbi->stats_enabled)
+        {
+            int64_t start = stat_mark;
+
+            vp8d_stat_lap(pbi->stats_frame.time, STAT_POSTPROC, &stat_mark);
+            pbi->stats_total.time[STAT_POSTPROC] += stat_mark - start;
+        }
+    }
 #else
 
     if (pbi->common.frame_to_show)
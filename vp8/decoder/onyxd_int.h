@@ -16,6 +16,9 @@
 #include "treereader.h"
 #include "vp8/common/onyxc_int.h"
 #include "vp8/common/threading.h"
+#include "vp8/common/rowsync.h"
+#include "vp8/common/threadpool.h"
+#include "vpx_ports/vpx_timer.h"
 
 #if CONFIG_ERROR_CONCEALMENT
 #include "ec_types.h"
@@ -28,20 +31,123 @@ typedef struct
     void *ptr2;
 } DECODETHREAD_DATA;
 
+/* Sections of the decode that the statistics time */
+typedef enum
+{
+    STAT_MODES = 0,     /* frame header, modes and motion vectors */
+    STAT_TOKENS,
+    STAT_RECON,
+    STAT_LOOP_FILTER,
+    STAT_EXTEND,
+    STAT_POSTPROC,
+    STAT_THREAD_WAIT,
+    STAT_TIMES
+} STAT_TIME;
+
+/* Statistics of a frame or of a run of frames, see VP8D_GET_STATS */
+typedef struct
+{
+    unsigned int frames;
+    int64_t time[STAT_TIMES];                   /* nanoseconds */
+    int64_t partition_bytes[MAX_PARTITIONS];    /* the first partition first */
+} VP8D_STATS;
+
+/* Adds the time since *mark to a section, and moves the mark to now */
+static __inline void vp8d_stat_lap(int64_t *stat_time, STAT_TIME section,
+                                   int64_t *mark)
+{
+    int64_t now = vpx_nsec_timestamp();
+
+    stat_time[section] += now - *mark;
+    *mark = now;
+}
+
 typedef struct
 {
     MACROBLOCKD  mbd;
     int mb_row;
     int current_mb_col;
     short *coef_ptr;
+    int64_t stat_time[STAT_TIMES];  /* of the frame, added up by the main thread */
 } MB_ROW_DEC;
 
+/* Coefficients of one MB, parsed ahead of its reconstruction */
+typedef struct
+{
+    DECLARE_ALIGNED(16, short, qcoeff[400]);
+    DECLARE_ALIGNED(16, char, eobs[25]);
+    int eobtotal;
+    int corrupted;                  /* token partition was corrupt by the MB end */
+} MB_TOKENS;
+
 typedef struct
 {
     int64_t time_stamp;
     int size;
 } DATARATE;
 
+/* Progress of a frame decoded as its fragments arrive */
+typedef enum
+{
+    FRAG_NONE = 0,
+    FRAG_DECODING,      /* the first partition is decoded, rows follow */
+    FRAG_FAILED         /* the error is reported once the frame is complete */
+} FRAG_STATE;
+
+#if CONFIG_MULTITHREAD
+/* Progress of the frame a frame context is decoding */
+typedef enum
+{
+    FT_DECODING = 0,
+    FT_SETUP_DONE,      /* state inherited by the next frame is final */
+    FT_MODES_DONE,      /* modes, motion vectors and segment ids are final */
+    FT_FRAME_DONE
+} FT_STAGE;
+
+typedef struct
+{
+    YV12_BUFFER_CONFIG fb;
+    int ref_cnt;
+    volatile int rows_done;         /* MB rows that are final, borders included */
+} FT_FRAME_BUFFER;
+
+typedef struct FT_CONTEXT
+{
+    struct VP8D_COMP *pbi;          /* decodes one frame at a time */
+    struct VP8D_COMP *master;       /* decoder instance owning the contexts */
+    struct FT_CONTEXT *prev;        /* context decoding the previous frame */
+    volatile int stage;
+    int setup_reached;
+    int fb_idx[NUM_YV12_BUFFERS];   /* ft_fb[] entry behind each yv12_fb[] */
+    int ref_used;                   /* yv12_fb[] entries used for prediction */
+
+    unsigned char *data;
+    unsigned int data_sz;
+    unsigned int data_alloc_sz;
+    int64_t time_stamp;
+    void *user_priv;
+    vp8_ppflags_t ppflags;
+
+    int retcode;
+    int corrupt_last;
+    int show;
+
+    int quit;
+    pthread_t h_thread;
+    sem_t h_event_start;
+    sem_t h_event_done;
+} FT_CONTEXT;
+
+typedef struct
+{
+    YV12_BUFFER_CONFIG sd;
+    int64_t time_stamp;
+    void *user_priv;
+    int fb_idx;                     /* held until the next decode call */
+    YV12_BUFFER_CONFIG pp_buffer;   /* copy of the postprocessed frame */
+} FT_OUTPUT;
+#endif
+
 
 typedef struct VP8D_COMP
 {
@@ -58,6 +164,18 @@ typedef struct VP8D_COMP
     unsigned int   fragment_sizes[MAX_PARTITIONS];
     unsigned int   num_fragments;
 
+    /* With input fragments, the MBs whose tokens have arrived are decoded
+     * before the rest of the frame.
+     */
+    int frag_state;
+    int frag_error;                          /* vpx_codec_err_t of FRAG_FAILED */
+    int token_decoders_started;              /* bool decoders of token partitions */
+    int token_partitions_complete;           /* the others are still arriving */
+    const unsigned char *token_part_sizes;
+    int next_mb_row;                         /* of the MBs decoded in order */
+    int next_mb_col;
+    int saved_independent_partitions;
+
 #if CONFIG_MULTITHREAD
     /* variable for threading */
 
@@ -70,13 +188,22 @@ typedef struct VP8D_COMP
     int mt_baseline_filter_level[MAX_MB_SEGMENTS];
     int sync_range;
     int *mt_current_mb_col;                  /* Each row remembers its already decoded column. */
+    VP8_ROW_SYNC mt_row_sync;                /* waits on mt_current_mb_col */
+    volatile int mt_next_mb_row;             /* next MB row to be claimed */
+    int mt_pipeline;                         /* tokens are parsed ahead into mt_tokens */
+    MB_TOKENS *mt_tokens;                    /* ring of mt_token_rows x mb_cols */
+    int mt_token_rows;
+    volatile int mt_mbs_parsed;              /* MBs of the frame in mt_tokens */
 
-    unsigned char **mt_yabove_row;           /* mb_rows x width */
+    /* Intra prediction edges of each MB row, in a ring of a row per
+     * thread that the mb_rows pointers share.
+     */
+    unsigned char **mt_yabove_row;           /* width */
     unsigned char **mt_uabove_row;
     unsigned char **mt_vabove_row;
-    unsigned char **mt_yleft_col;            /* mb_rows x 16 */
-    unsigned char **mt_uleft_col;            /* mb_rows x 8 */
-    unsigned char **mt_vleft_col;            /* mb_rows x 8 */
+    unsigned char **mt_yleft_col;            /* 16 */
+    unsigned char **mt_uleft_col;            /* 8 */
+    unsigned char **mt_vleft_col;            /* 8 */
 
     MB_ROW_DEC           *mb_row_di;
     DECODETHREAD_DATA    *de_thread_data;
@@ -84,6 +211,53 @@ typedef struct VP8D_COMP
     pthread_t           *h_decoding_thread;
     sem_t               *h_event_start_decoding;
     sem_t                h_event_end_decoding;
+
+    /* With the shared thread pool, the rows are decoded by pool jobs
+     * rather than by threads of this decoder.
+     */
+    int use_thread_pool;
+    VP8_THREAD_POOL     *thread_pool;
+    VP8_POOL_JOB        *mt_jobs;            /* decoding_thread_count */
+
+    /* postprocessing pass the threads run instead of decoding rows */
+    struct vp8_pp_pass  *mt_pp_pass;
+    volatile int mt_pp_next_band;            /* next band to be claimed */
+
+#if CONFIG_ERROR_CONCEALMENT
+    /* MV estimation the threads run instead of decoding rows, in bands of
+     * the MB rows from mt_ec_first_row on
+     */
+    int mt_ec_bands;
+    int mt_ec_first_row;
+    volatile int mt_ec_next_band;            /* next band to be claimed */
+#endif
+
+    /* frame threading: set on the decoder instance */
+    int frame_threads;                       /* number of frame contexts */
+    FT_CONTEXT          *ft_ctx;
+    VP8_ROW_SYNC         ft_sync;            /* waits on stages and rows_done */
+    FT_FRAME_BUFFER     *ft_fb;              /* frame_threads * NUM_YV12_BUFFERS */
+    int ft_lst_idx;
+    int ft_gld_idx;
+    int ft_alt_idx;
+    unsigned int ft_submitted;               /* frames submitted so far */
+    unsigned int ft_completed;               /* frames collected so far */
+    FT_CONTEXT          *ft_swap_ctx;        /* frame whose buffer updates are pending */
+    FT_OUTPUT           *ft_out;
+    int ft_num_out;
+    int ft_out_read;
+    int ft_ref_frame_used;                   /* of the last collected frame */
+    vp8_ppflags_t ft_ppflags;
+    void *ft_user_priv;                      /* of the frame to decode */
+    void *ft_out_user_priv;                  /* of the last frame output */
+    unsigned char *ft_pending;               /* key frame waiting for a resize */
+    unsigned int ft_pending_sz;
+    unsigned int ft_pending_alloc_sz;
+    int64_t ft_pending_time_stamp;
+    void *ft_pending_user_priv;
+
+    /* frame threading: set on a frame context */
+    FT_CONTEXT          *ft;
     /* end of threading data */
 #endif
 
@@ -110,10 +284,82 @@ typedef struct VP8D_COMP
     int independent_partitions;
     int frame_corrupt_residual;
 
+    /* Set when the loop filter was applied row by row by the decode loop,
+     * so no frame level pass is needed. */
+    int lf_rows_in_decode;
+
+    /* Set when the borders were extended row by row by the decode loop. */
+    int ext_rows_in_decode;
+
+    /* Set to loop filter and extend the frame in passes after decoding it,
+     * as the decoder used to, rather than row by row. */
+    int frame_passes;
+
+    /* Fast seek: frames that update no reference are not reconstructed,
+     * and frames are not loop filtered, when set. */
+    int skip_nonref_frames;
+    int skip_loop_filter;
+    int frame_skipped;                       /* the last frame */
+
+    /* Reduced resolution decoding: frames are reconstructed into rr_fb[],
+     * at 1 / (1 << rr_scale) of the width and height, rather than into
+     * yv12_fb[]. The requested scale takes effect at the next key frame.
+     * Key frames are decoded into yv12_fb[] and downscaled into rr_fb[].
+     */
+    int rr_scale_req;
+    int rr_scale;
+    int rr_frame;                            /* the last frame */
+    YV12_BUFFER_CONFIG rr_fb[NUM_YV12_BUFFERS];
+
+    /* Frame buffers supplied by the application, backing yv12_fb[] */
+    vpx_get_frame_buffer_cb_fn_t get_fb_cb;
+    vpx_release_frame_buffer_cb_fn_t release_fb_cb;
+    void *fb_cb_priv;
+    vpx_codec_frame_buffer_t ext_fb[NUM_YV12_BUFFERS];
+
+    /* Called with the pixel rows [row_start, row_end) of the frame to show
+     * as they become final, while the rest of the frame is decoded. Set by
+     * the application interface before each frame.
+     */
+    void (*put_rows)(void *priv, const YV12_BUFFER_CONFIG *frame,
+                     int row_start, int row_end);
+    void *put_rows_priv;
+    int put_rows_active;                     /* for the frame being decoded */
+    int mb_rows_put;
+
+    /* Statistics, collected while stats_enabled is set. Each section of a
+     * MB is timed only then, so they cost a branch otherwise.
+     */
+    int stats_enabled;
+    VP8D_STATS stats_frame;                  /* the last or current frame */
+    VP8D_STATS stats_total;
+
 } VP8D_COMP;
 
 int vp8_decode_frame(VP8D_COMP *cpi);
 
+/* Returns non-zero once the fragments received hold the first partition,
+ * from which the decoding of the frame starts.
+ */
+int vp8_first_partition_received(VP8D_COMP *cpi);
+
+/* Decodes the frame as far as the fragments received so far allow. A
+ * fragment that continues the last one in memory extends it. The rest of
+ * the frame is decoded by vp8_decode_frame().
+ */
+int vp8_decode_frame_partial(VP8D_COMP *cpi);
+
+/* Puts the MB rows of the frame up to mb_row_end, which are final, from the
+ * first one not put yet.
+ */
+void vp8dx_put_rows(VP8D_COMP *pbi, int mb_row_end);
+
+/* Makes frame the statistics of the last frame and adds it to the totals */
+void vp8dx_stats_frame_done(VP8D_COMP *pbi, const VP8D_STATS *frame);
+
+int vp8dx_get_external_fb(VP8D_COMP *pbi, int idx);
+void vp8dx_release_external_fbs(VP8D_COMP *pbi, int all);
+
 #if CONFIG_DEBUG
 #define CHECK_MEM_ERROR(lval,expr) do {\
         lval = (expr); \
@@ -0,0 +1,474 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#include "vpx_config.h"
+#include "vpx_rtcd.h"
+#include "reduced.h"
+#include "vpx_mem/vpx_mem.h"
+#include "vpx_scale/yv12extend.h"
+
+#if CONFIG_OPENCL
+#include "vp8/common/opencl/vp8_opencl.h"
+#endif
+
+/* A 2x2 output of a 4x4 block is the mean of 2x2 outputs of the inverse
+ * transform. Of the first AC basis function, the mean of two adjacent
+ * outputs is +/-cos(pi/8) times its amplitude: K1, in Q12. K2 is its
+ * square, for the first diagonal basis function.
+ */
+#define K1 3784
+#define K2 3496
+
+int vp8dx_setup_reduced_frames(VP8D_COMP *pbi)
+{
+    VP8_COMMON *const pc = &pbi->common;
+    int scale = pbi->rr_scale_req;
+    int width, height;
+    int i;
+
+#if CONFIG_OPENCL
+    if (cl_initialized == CL_SUCCESS)
+        scale = 0;
+#endif
+
+    width = (pc->mb_cols * 16) >> scale;
+    height = (pc->mb_rows * 16) >> scale;
+
+    if (scale == pbi->rr_scale &&
+        (!scale || (pbi->rr_fb[0].y_width == width &&
+                    pbi->rr_fb[0].y_height == height)))
+        return 0;
+
+    vp8dx_free_reduced_frames(pbi);
+
+    if (!scale)
+        return 0;
+
+    for (i = 0; i < NUM_YV12_BUFFERS; i++)
+    {
+        YV12_BUFFER_CONFIG *fb = &pbi->rr_fb[i];
+
+        /* The allocation rounds the size up to whole MBs. */
+        if (vp8_yv12_alloc_frame_buffer(fb, (width + 15) & ~15,
+                                        (height + 15) & ~15,
+                                        VP8BORDERINPIXELS) < 0)
+        {
+            vp8dx_free_reduced_frames(pbi);
+            return -1;
+        }
+
+        fb->y_width = width;
+        fb->y_height = height;
+        fb->uv_width = width >> 1;
+        fb->uv_height = height >> 1;
+    }
+
+    pbi->rr_scale = scale;
+    return 0;
+}
+
+void vp8dx_free_reduced_frames(VP8D_COMP *pbi)
+{
+    int i;
+
+    for (i = 0; i < NUM_YV12_BUFFERS; i++)
+        vp8_yv12_de_alloc_frame_buffer(&pbi->rr_fb[i]);
+
+    pbi->rr_scale = 0;
+}
+
+static void reduce_plane(const unsigned char *src, int src_stride,
+                         unsigned char *dst, int dst_stride,
+                         int width, int height, int scale)
+{
+    const int n = 1 << scale;
+    const int round = 1 << (2 * scale - 1);
+    int r, c, i, j;
+
+    for (r = 0; r < height; r++)
+    {
+        for (c = 0; c < width; c++)
+        {
+            const unsigned char *s = src + c * n;
+            int sum = 0;
+
+            for (i = 0; i < n; i++, s += src_stride)
+                for (j = 0; j < n; j++)
+                    sum += s[j];
+
+            dst[c] = (sum + round) >> (2 * scale);
+        }
+
+        src += n * src_stride;
+        dst += dst_stride;
+    }
+}
+
+void vp8dx_reduce_frame(VP8D_COMP *pbi)
+{
+    VP8_COMMON *const pc = &pbi->common;
+    const YV12_BUFFER_CONFIG *src = pc->frame_to_show;
+    YV12_BUFFER_CONFIG *dst = &pbi->rr_fb[src - pc->yv12_fb];
+    const int scale = pbi->rr_scale;
+    const int width = (pc->mb_cols * 16) >> scale;
+    const int height = (pc->mb_rows * 16) >> scale;
+
+    reduce_plane(src->y_buffer, src->y_stride, dst->y_buffer, dst->y_stride,
+                 width, height, scale);
+    reduce_plane(src->u_buffer, src->uv_stride, dst->u_buffer,
+                 dst->uv_stride, width >> 1, height >> 1, scale);
+    reduce_plane(src->v_buffer, src->uv_stride, dst->v_buffer,
+                 dst->uv_stride, width >> 1, height >> 1, scale);
+
+    vp8_yv12_extend_frame_borders(dst);
+}
+
+static unsigned char clamp_pixel(int v)
+{
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+/* Predicts a size x size block from the pixels above and left of it, which
+ * the frame border provides at the edges as in the full size frame.
+ */
+static void predict_intra(unsigned char *dst, int stride, int size,
+                          int mode, int up_available, int left_available)
+{
+    const unsigned char *above = dst - stride;
+    int r, c;
+
+    switch (mode)
+    {
+    case V_PRED:
+        for (r = 0; r < size; r++)
+            vpx_memcpy(dst + r * stride, above, size);
+        break;
+
+    case H_PRED:
+        for (r = 0; r < size; r++)
+            vpx_memset(dst + r * stride, dst[r * stride - 1], size);
+        break;
+
+    case TM_PRED:
+        for (r = 0; r < size; r++)
+            for (c = 0; c < size; c++)
+                dst[r * stride + c] = clamp_pixel(above[c] +
+                                                  dst[r * stride - 1] -
+                                                  above[-1]);
+        break;
+
+    default:
+    {
+        int sum = 0, count = 0, dc = 128;
+
+        if (up_available)
+        {
+            for (c = 0; c < size; c++)
+                sum += above[c];
+
+            count += size;
+        }
+
+        if (left_available)
+        {
+            for (r = 0; r < size; r++)
+                sum += dst[r * stride - 1];
+
+            count += size;
+        }
+
+        if (count)
+            dc = (sum + (count >> 1)) / count;
+
+        for (r = 0; r < size; r++)
+            vpx_memset(dst + r * stride, dc, size);
+        break;
+    }
+    }
+}
+
+/* Predicts a subblock, of size x size pixels, by running the 4x4 predictor
+ * on its edges brought back to full resolution, and downscaling the result.
+ * above_right points to the pixels right of the edge above.
+ */
+static void predict_subblock(unsigned char *dst, int stride, int size,
+                             int b_mode, const unsigned char *above_right)
+{
+    const int step = 4 / size;
+    unsigned char edges[5 * 16];
+    unsigned char pred[16];
+    unsigned char *src = edges + 16 + 1;
+    int r, c, i, j;
+
+    src[-17] = dst[-stride - 1];
+
+    for (i = 0; i < 4; i++)
+    {
+        src[i - 16] = dst[-stride + i / step];
+        src[i - 12] = above_right[i / step];
+        src[i * 16 - 1] = dst[(i / step) * stride - 1];
+    }
+
+    vp8_intra4x4_predict(src, 16, b_mode, pred, 4);
+
+    for (r = 0; r < size; r++)
+        for (c = 0; c < size; c++)
+        {
+            int sum = 0;
+
+            for (i = 0; i < step; i++)
+                for (j = 0; j < step; j++)
+                    sum += pred[(r * step + i) * 4 + c * step + j];
+
+            dst[r * stride + c] = (sum + (step * step >> 1)) / (step * step);
+        }
+}
+
+/* Bilinear prediction of a w x h block at (x, y) in 1/8 pixels. The block
+ * is kept within the border of the plane, as the motion vectors, scaled
+ * down, no longer match its width.
+ */
+static void predict_inter(const unsigned char *base, int stride,
+                          int width, int height, int border,
+                          int x, int y, int w, int h,
+                          unsigned char *dst, int dst_stride)
+{
+    int ix = x >> 3, iy = y >> 3;
+    const int fx = x & 7, fy = y & 7;
+    const unsigned char *src;
+    int r, c;
+
+    if (ix < -border)
+        ix = -border;
+    else if (ix > width + border - w - 1)
+        ix = width + border - w - 1;
+
+    if (iy < -border)
+        iy = -border;
+    else if (iy > height + border - h - 1)
+        iy = height + border - h - 1;
+
+    src = base + iy * stride + ix;
+
+    for (r = 0; r < h; r++)
+    {
+        for (c = 0; c < w; c++)
+        {
+            const unsigned char *p = src + c;
+            const int top = p[0] * (8 - fx) + p[1] * fx;
+            const int bottom = p[stride] * (8 - fx) + p[stride + 1] * fx;
+
+            dst[c] = (top * (8 - fy) + bottom * fy + 32) >> 6;
+        }
+
+        src += stride;
+        dst += dst_stride;
+    }
+}
+
+/* Adds the residual of a 4x4 block, reduced to size x size (1 or 2). */
+static void add_residual(const short *q, const short *dq,
+                         unsigned char *dst, int stride, int size)
+{
+    const int dc = q[0] * dq[0];
+
+    if (size == 1)
+        dst[0] = clamp_pixel(dst[0] + ((dc + 4) >> 3));
+    else
+    {
+        const int h = (q[1] * dq[1] * K1) >> 12;
+        const int v = (q[4] * dq[4] * K1) >> 12;
+        const int d = (q[5] * dq[5] * K2) >> 12;
+
+        dst[0] = clamp_pixel(dst[0] + ((dc + h + v + d + 4) >> 3));
+        dst[1] = clamp_pixel(dst[1] + ((dc - h + v - d + 4) >> 3));
+        dst[stride] = clamp_pixel(dst[stride] + ((dc + h - v - d + 4) >> 3));
+        dst[stride + 1] =
+            clamp_pixel(dst[stride + 1] + ((dc - h - v + d + 4) >> 3));
+    }
+}
+
+static void predict_inter_mb(VP8D_COMP *pbi, MACROBLOCKD *xd,
+                             unsigned char *dst_y, unsigned char *dst_u,
+                             unsigned char *dst_v, int mb_row, int mb_col)
+{
+    VP8_COMMON *const pc = &pbi->common;
+    const MODE_INFO *mi = xd->mode_info_context;
+    const int scale = pbi->rr_scale;
+    const int y_size = 16 >> scale;
+    const int uv_size = 8 >> scale;
+    const int b_size = 4 >> scale;
+    const YV12_BUFFER_CONFIG *ref;
+    const int x = mb_col * y_size * 8, y = mb_row * y_size * 8;
+    const int uv_x = mb_col * uv_size * 8, uv_y = mb_row * uv_size * 8;
+    int i;
+
+    if (mi->mbmi.ref_frame == LAST_FRAME)
+        ref = &pbi->rr_fb[pc->lst_fb_idx];
+    else if (mi->mbmi.ref_frame == GOLDEN_FRAME)
+        ref = &pbi->rr_fb[pc->gld_fb_idx];
+    else
+        ref = &pbi->rr_fb[pc->alt_fb_idx];
+
+    if (mi->mbmi.mode != SPLITMV)
+    {
+        const MV *mv = &mi->mbmi.mv.as_mv;
+
+        predict_inter(ref->y_buffer, ref->y_stride, ref->y_width,
+                      ref->y_height, ref->border,
+                      x + (mv->col >> scale), y + (mv->row >> scale),
+                      y_size, y_size, dst_y, ref->y_stride);
+        predict_inter(ref->u_buffer, ref->uv_stride, ref->uv_width,
+                      ref->uv_height, ref->border >> 1,
+                      uv_x + (mv->col >> (scale + 1)),
+                      uv_y + (mv->row >> (scale + 1)),
+                      uv_size, uv_size, dst_u, ref->uv_stride);
+        predict_inter(ref->v_buffer, ref->uv_stride, ref->uv_width,
+                      ref->uv_height, ref->border >> 1,
+                      uv_x + (mv->col >> (scale + 1)),
+                      uv_y + (mv->row >> (scale + 1)),
+                      uv_size, uv_size, dst_v, ref->uv_stride);
+        return;
+    }
+
+    for (i = 0; i < 16; i++)
+    {
+        const MV *mv = &mi->bmi[i].mv.as_mv;
+        const int bx = (i & 3) * b_size, by = (i >> 2) * b_size;
+
+        predict_inter(ref->y_buffer, ref->y_stride, ref->y_width,
+                      ref->y_height, ref->border,
+                      x + bx * 8 + (mv->col >> scale),
+                      y + by * 8 + (mv->row >> scale),
+                      b_size, b_size,
+                      dst_y + by * ref->y_stride + bx, ref->y_stride);
+    }
+
+    /* Each 4x4 chroma block moves by the mean of the vectors of the four
+     * luma blocks it covers, halved.
+     */
+    for (i = 0; i < 4; i++)
+    {
+        const int b = (i >> 1) * 8 + (i & 1) * 2;
+        const int row = mi->bmi[b].mv.as_mv.row + mi->bmi[b + 1].mv.as_mv.row +
+                        mi->bmi[b + 4].mv.as_mv.row +
+                        mi->bmi[b + 5].mv.as_mv.row;
+        const int col = mi->bmi[b].mv.as_mv.col + mi->bmi[b + 1].mv.as_mv.col +
+                        mi->bmi[b + 4].mv.as_mv.col +
+                        mi->bmi[b + 5].mv.as_mv.col;
+        const int bx = (i & 1) * b_size, by = (i >> 1) * b_size;
+        const int offset = by * ref->uv_stride + bx;
+
+        predict_inter(ref->u_buffer, ref->uv_stride, ref->uv_width,
+                      ref->uv_height, ref->border >> 1,
+                      uv_x + bx * 8 + (col >> (scale + 3)),
+                      uv_y + by * 8 + (row >> (scale + 3)),
+                      b_size, b_size, dst_u + offset, ref->uv_stride);
+        predict_inter(ref->v_buffer, ref->uv_stride, ref->uv_width,
+                      ref->uv_height, ref->border >> 1,
+                      uv_x + bx * 8 + (col >> (scale + 3)),
+                      uv_y + by * 8 + (row >> (scale + 3)),
+                      b_size, b_size, dst_v + offset, ref->uv_stride);
+    }
+}
+
+void vp8dx_decode_reduced_mb(VP8D_COMP *pbi, MACROBLOCKD *xd,
+                             int mb_row, int mb_col)
+{
+    VP8_COMMON *const pc = &pbi->common;
+    const MODE_INFO *mi = xd->mode_info_context;
+    const int mode = mi->mbmi.mode;
+    const int has_residual = !mi->mbmi.mb_skip_coeff;
+    const int scale = pbi->rr_scale;
+    const int y_size = 16 >> scale;
+    const int uv_size = 8 >> scale;
+    const int b_size = 4 >> scale;
+    YV12_BUFFER_CONFIG *dst_fb = &pbi->rr_fb[pc->new_fb_idx];
+    const int y_stride = dst_fb->y_stride;
+    const int uv_stride = dst_fb->uv_stride;
+    unsigned char *dst_y = dst_fb->y_buffer +
+                           (mb_row * y_stride + mb_col) * y_size;
+    unsigned char *dst_u = dst_fb->u_buffer +
+                           (mb_row * uv_stride + mb_col) * uv_size;
+    unsigned char *dst_v = dst_fb->v_buffer +
+                           (mb_row * uv_stride + mb_col) * uv_size;
+    short *DQC = xd->dequant_y1;
+    unsigned char above_right[2];
+    int i;
+
+    if (mi->mbmi.ref_frame == INTRA_FRAME)
+    {
+        predict_intra(dst_u, uv_stride, uv_size, mi->mbmi.uv_mode,
+                      xd->up_available, xd->left_available);
+        predict_intra(dst_v, uv_stride, uv_size, mi->mbmi.uv_mode,
+                      xd->up_available, xd->left_available);
+
+        if (mode != B_PRED)
+            predict_intra(dst_y, y_stride, y_size, mode,
+                          xd->up_available, xd->left_available);
+    }
+    else
+        predict_inter_mb(pbi, xd, dst_y, dst_u, dst_v, mb_row, mb_col);
+
+    /* The DCs of the luma blocks come from the second order block. */
+    if (has_residual && mode != B_PRED && mode != SPLITMV)
+    {
+        short dqcoeff[16];
+
+        for (i = 0; i < 16; i++)
+            dqcoeff[i] = xd->qcoeff[24 * 16 + i] * xd->dequant_y2[i];
+
+        vp8_short_inv_walsh4x4(dqcoeff, xd->qcoeff);
+        DQC = xd->dequant_y1_dc;
+    }
+
+    if (mode == B_PRED)
+    {
+        /* As in the full size frame, the subblocks on the right take the
+         * pixels above right of the MB, and the last MB of a row repeats
+         * the last pixel above it.
+         */
+        if (mb_row && mb_col == pc->mb_cols - 1)
+            vpx_memset(above_right, dst_y[-y_stride + y_size - 1], b_size);
+        else
+            vpx_memcpy(above_right, dst_y - y_stride + y_size, b_size);
+    }
+
+    for (i = 0; i < 16; i++)
+    {
+        unsigned char *dst = dst_y + (i >> 2) * b_size * y_stride +
+                             (i & 3) * b_size;
+
+        /* Subblocks are predicted from their reconstructed neighbours. */
+        if (mode == B_PRED)
+            predict_subblock(dst, y_stride, b_size, mi->bmi[i].as_mode,
+                             (i & 3) == 3 ? above_right :
+                                            dst - y_stride + b_size);
+
+        if (has_residual)
+            add_residual(xd->qcoeff + i * 16, DQC, dst, y_stride, b_size);
+    }
+
+    if (!has_residual)
+        return;
+
+    for (i = 0; i < 4; i++)
+    {
+        const int offset = (i >> 1) * b_size * uv_stride + (i & 1) * b_size;
+
+        add_residual(xd->qcoeff + (16 + i) * 16, xd->dequant_uv,
+                     dst_u + offset, uv_stride, b_size);
+        add_residual(xd->qcoeff + (20 + i) * 16, xd->dequant_uv,
+                     dst_v + offset, uv_stride, b_size);
+    }
+
+    vpx_memset(xd->qcoeff, 0, sizeof(xd->qcoeff));
+}
@@ -0,0 +1,43 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#ifndef REDUCED_H
+#define REDUCED_H
+
+#include "onyxd_int.h"
+
+/* Reduced resolution decoding reconstructs the frames at 1 / (1 << scale)
+ * of their width and height, straight from the modes, motion vectors and
+ * low frequency coefficients, into frame buffers of that size. The result
+ * only approximates a downscaled decode: the prediction is simplified and
+ * the loop filter is not applied, so errors accumulate until the next key
+ * frame, which is decoded at full resolution and downscaled.
+ */
+
+/* (Re)allocates the reduced frames for the requested scale, on a key
+ * frame. Returns non-zero if out of memory.
+ */
+int vp8dx_setup_reduced_frames(VP8D_COMP *pbi);
+
+void vp8dx_free_reduced_frames(VP8D_COMP *pbi);
+
+/* Downscales the new frame, decoded at full resolution, into its reduced
+ * frame, and extends the borders of the latter.
+ */
+void vp8dx_reduce_frame(VP8D_COMP *pbi);
+
+/* Reconstructs the MB at (mb_row, mb_col), whose tokens are decoded, and
+ * clears its coefficients.
+ */
+void vp8dx_decode_reduced_mb(VP8D_COMP *pbi, MACROBLOCKD *xd,
+                             int mb_row, int mb_col);
+
+#endif
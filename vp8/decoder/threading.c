@@ -20,6 +20,7 @@
 
 #include "vp8/common/loopfilter.h"
 #include "vp8/common/extend.h"
+#include "vp8/common/systemdependent.h"
 #include "vpx_ports/vpx_timer.h"
 #include "detokenize.h"
 #include "vp8/common/reconinter.h"
@@ -43,7 +44,6 @@ static void setup_decoding_thread_data(VP8D_COMP *pbi, MACROBLOCKD *xd, MB_ROW_D
         mbd->subpixel_predict8x8     = xd->subpixel_predict8x8;
         mbd->subpixel_predict16x16   = xd->subpixel_predict16x16;
 
-        mbd->mode_info_context = pc->mi   + pc->mode_info_stride * (i + 1);
         mbd->mode_info_stride  = pc->mode_info_stride;
 
         mbd->frame_type = pc->frame_type;
@@ -86,11 +86,12 @@ static void setup_decoding_thread_data(VP8D_COMP *pbi, MACROBLOCKD *xd, MB_ROW_D
 }
 
 
-static void decode_macroblock(VP8D_COMP *pbi, MACROBLOCKD *xd, int mb_row, int mb_col)
+/* Reads the tokens of the MB into xd. Returns nonzero if the MB has a
+ * residual to add.
+ */
+static int decode_mb_tokens(VP8D_COMP *pbi, MACROBLOCKD *xd)
 {
     int eobtotal = 0;
-    int throw_residual = 0;
-    int i;
 
     if (xd->mode_info_context->mbmi.mb_skip_coeff)
     {
@@ -109,7 +110,22 @@ static void decode_macroblock(VP8D_COMP *pbi, MACROBLOCKD *xd, int mb_row, int m
          * mb_skip_coeff are zero.
          * */
         xd->mode_info_context->mbmi.mb_skip_coeff = 1;
+    }
+
+    return eobtotal;
+}
 
+/* Reconstructs the MB from the tokens in xd. corrupted tells whether the
+ * token partition was corrupt by the end of the MB.
+ */
+static void decode_macroblock(VP8D_COMP *pbi, MACROBLOCKD *xd, int mb_row, int mb_col,
+                              int eobtotal, int corrupted)
+{
+    int throw_residual = 0;
+    int i;
+
+    if (!eobtotal && !corrupted)
+    {
         /*mt_skip_recon_mb(pbi, xd, mb_row, mb_col);*/
         if (xd->mode_info_context->mbmi.ref_frame == INTRA_FRAME)
         {
@@ -150,7 +166,7 @@ static void decode_macroblock(VP8D_COMP *pbi, MACROBLOCKD *xd, int mb_row, int m
      */
     throw_residual = (!pbi->independent_partitions &&
                       pbi->frame_corrupt_residual);
-    throw_residual = (throw_residual || vp8dx_bool_error(xd->current_bc));
+    throw_residual = (throw_residual || corrupted);
 
 #if CONFIG_ERROR_CONCEALMENT
     if (pbi->ec_active &&
@@ -186,13 +202,13 @@ static void decode_macroblock(VP8D_COMP *pbi, MACROBLOCKD *xd, int mb_row, int m
                 if (xd->eobs[i] > 1)
                 {
                     vp8_dequant_idct_add
-                        (b->qcoeff, DQC,
+                        (qcoeff, DQC,
                         *(b->base_dst) + b->dst, b->dst_stride);
                 }
                 else
                 {
                     vp8_dc_only_idct_add
-                        (b->qcoeff[0] * DQC[0],
+                        (qcoeff[0] * DQC[0],
                         *(b->base_dst) + b->dst, b->dst_stride,
                         *(b->base_dst) + b->dst, b->dst_stride);
                     ((int *)qcoeff)[0] = 0;
@@ -249,271 +265,497 @@ static void decode_macroblock(VP8D_COMP *pbi, MACROBLOCKD *xd, int mb_row, int m
                      xd->dst.uv_stride, xd->eobs+16);
 }
 
-static THREAD_FUNCTION thread_decoding_proc(void *p_data)
+/* Decodes one MB row with xd, once the rows above it allow. Rows that share
+ * a token partition are decoded in order as long as no more threads decode
+ * than there are partitions: a row is only claimed after its thread finished
+ * the previous one, and a finished row implies that all rows above are.
+ */
+static void decode_mb_row(VP8D_COMP *pbi, MACROBLOCKD *xd, int mb_row,
+                          int64_t *stat_time)
 {
-    int ithread = ((DECODETHREAD_DATA *)p_data)->ithread;
-    VP8D_COMP *pbi = (VP8D_COMP *)(((DECODETHREAD_DATA *)p_data)->ptr1);
-    MB_ROW_DEC *mbrd = (MB_ROW_DEC *)(((DECODETHREAD_DATA *)p_data)->ptr2);
-    ENTROPY_CONTEXT_PLANES mb_row_left_context;
+    VP8_COMMON *pc = &pbi->common;
+    int i;
+    int recon_yoffset, recon_uvoffset;
+    int mb_col;
+    int eobtotal, corrupted;
+    int ref_fb_idx = pc->lst_fb_idx;
+    int dst_fb_idx = pc->new_fb_idx;
+    int recon_y_stride = pc->yv12_fb[ref_fb_idx].y_stride;
+    int recon_uv_stride = pc->yv12_fb[ref_fb_idx].uv_stride;
+    int num_part = 1 << pc->multi_token_partition;
+    int nsync = pbi->sync_range;
+    int last_mb_col = pc->mb_cols - 1;
+    volatile int *last_row_current_mb_col = NULL;
+    MB_TOKENS *tokens = NULL;
+    int64_t stat_mark = 0;
 
-    while (1)
+    int filter_level;
+    loop_filter_info_n *lfi_n = &pc->lf_info;
+
+    if (mb_row > 0)
+        last_row_current_mb_col = &pbi->mt_current_mb_col[mb_row -1];
+
+    /* bind the row to this thread's MACROBLOCKD */
+    xd->mode_info_context = pc->mi + pc->mode_info_stride * mb_row;
+
+    if (pbi->mt_pipeline)
+        tokens = pbi->mt_tokens + (mb_row % pbi->mt_token_rows) * pc->mb_cols;
+    else
     {
-        if (pbi->b_multithreaded_rd == 0)
-            break;
+        xd->current_bc = &pbi->mbc[mb_row%num_part];
+        vpx_memset(xd->left_context, 0, sizeof(ENTROPY_CONTEXT_PLANES));
+    }
 
-        /*if(WaitForSingleObject(pbi->h_event_start_decoding[ithread], INFINITE) == WAIT_OBJECT_0)*/
-        if (sem_wait(&pbi->h_event_start_decoding[ithread]) == 0)
+    recon_yoffset = mb_row * recon_y_stride * 16;
+    recon_uvoffset = mb_row * recon_uv_stride * 8;
+    /* reset above block coeffs */
+
+    if (pc->filter_level)
+    {
+        /* The ring row of this one was last used by a row that is done.
+         * The thread of the row above only writes its above row past the
+         * top left pixel.
+         */
+        if (mb_row > 0)
         {
-            if (pbi->b_multithreaded_rd == 0)
-                break;
-            else
+            pbi->mt_yabove_row[mb_row][VP8BORDERINPIXELS-1] = 129;
+            pbi->mt_uabove_row[mb_row][(VP8BORDERINPIXELS>>1)-1] = 129;
+            pbi->mt_vabove_row[mb_row][(VP8BORDERINPIXELS>>1)-1] = 129;
+        }
+
+        vpx_memset(pbi->mt_yleft_col[mb_row], (unsigned char)129, 16);
+        vpx_memset(pbi->mt_uleft_col[mb_row], (unsigned char)129, 8);
+        vpx_memset(pbi->mt_vleft_col[mb_row], (unsigned char)129, 8);
+    }
+
+    xd->above_context = pc->above_context;
+    xd->up_available = (mb_row != 0);
+
+    xd->mb_to_top_edge = -((mb_row * 16)) << 3;
+    xd->mb_to_bottom_edge = ((pc->mb_rows - 1 - mb_row) * 16) << 3;
+
+    if (stat_time)
+        stat_mark = vpx_nsec_timestamp();
+
+    for (mb_col = 0; mb_col < pc->mb_cols; mb_col++)
+    {
+        if (mb_row > 0 && (mb_col & (nsync-1)) == 0)
+        {
+            /* wait until the above-right MBs are decoded */
+            vp8_row_sync_wait(&pbi->mt_row_sync, last_row_current_mb_col,
+                              mb_col + nsync < pc->mb_cols ? mb_col + nsync : pc->mb_cols - 1);
+
+            if (stat_time)
+                vp8d_stat_lap(stat_time, STAT_THREAD_WAIT, &stat_mark);
+        }
+
+        /* Distance of MB to the various image edges.
+         * These are specified to 8th pel as they are always compared to
+         * values that are in 1/8th pel units.
+         */
+        xd->mb_to_left_edge = -((mb_col * 16) << 3);
+        xd->mb_to_right_edge = ((pc->mb_cols - 1 - mb_col) * 16) << 3;
+
+#if CONFIG_ERROR_CONCEALMENT
+        if (pbi->ec_active)
+        {
+            int corrupt_residual = (!pbi->independent_partitions &&
+                                    pbi->frame_corrupt_residual) ||
+                                    vp8dx_bool_error(xd->current_bc);
+            if ((xd->mode_info_context->mbmi.ref_frame == INTRA_FRAME) &&
+                corrupt_residual)
             {
-                VP8_COMMON *pc = &pbi->common;
-                MACROBLOCKD *xd = &mbrd->mbd;
+                /* We have an intra block with corrupt coefficients,
+                 * better to conceal with an inter block. Interpolate
+                 * MVs from neighboring MBs
+                 *
+                 * Note that for the first mb with corrupt residual in a
+                 * frame, we might not discover that before decoding the
+                 * residual. That happens after this check, and
+                 * therefore no inter concealment will be done.
+                 */
+                vp8_interpolate_motion(xd,
+                                       mb_row, mb_col,
+                                       pc->mb_rows, pc->mb_cols,
+                                       pc->mode_info_stride);
+            }
+        }
+#endif
 
-                int mb_row;
-                int num_part = 1 << pbi->common.multi_token_partition;
-                volatile int *last_row_current_mb_col;
-                int nsync = pbi->sync_range;
 
-                for (mb_row = ithread+1; mb_row < pc->mb_rows; mb_row += (pbi->decoding_thread_count + 1))
-                {
-                    int i;
-                    int recon_yoffset, recon_uvoffset;
-                    int mb_col;
-                    int ref_fb_idx = pc->lst_fb_idx;
-                    int dst_fb_idx = pc->new_fb_idx;
-                    int recon_y_stride = pc->yv12_fb[ref_fb_idx].y_stride;
-                    int recon_uv_stride = pc->yv12_fb[ref_fb_idx].uv_stride;
+        xd->dst.y_buffer = pc->yv12_fb[dst_fb_idx].y_buffer + recon_yoffset;
+        xd->dst.u_buffer = pc->yv12_fb[dst_fb_idx].u_buffer + recon_uvoffset;
+        xd->dst.v_buffer = pc->yv12_fb[dst_fb_idx].v_buffer + recon_uvoffset;
 
-                    int filter_level;
-                    loop_filter_info_n *lfi_n = &pc->lf_info;
+        xd->left_available = (mb_col != 0);
 
-                    pbi->mb_row_di[ithread].mb_row = mb_row;
-                    pbi->mb_row_di[ithread].mbd.current_bc =  &pbi->mbc[mb_row%num_part];
+        /* Select the appropriate reference frame for this MB */
+        if (xd->mode_info_context->mbmi.ref_frame == LAST_FRAME)
+            ref_fb_idx = pc->lst_fb_idx;
+        else if (xd->mode_info_context->mbmi.ref_frame == GOLDEN_FRAME)
+            ref_fb_idx = pc->gld_fb_idx;
+        else
+            ref_fb_idx = pc->alt_fb_idx;
 
-                    last_row_current_mb_col = &pbi->mt_current_mb_col[mb_row -1];
+        xd->pre.y_buffer = pc->yv12_fb[ref_fb_idx].y_buffer + recon_yoffset;
+        xd->pre.u_buffer = pc->yv12_fb[ref_fb_idx].u_buffer + recon_uvoffset;
+        xd->pre.v_buffer = pc->yv12_fb[ref_fb_idx].v_buffer + recon_uvoffset;
 
-                    recon_yoffset = mb_row * recon_y_stride * 16;
-                    recon_uvoffset = mb_row * recon_uv_stride * 8;
-                    /* reset above block coeffs */
+        if (xd->mode_info_context->mbmi.ref_frame != INTRA_FRAME)
+        {
+            /* propagate errors from reference frames */
+            xd->corrupted |= pc->yv12_fb[ref_fb_idx].corrupted;
+        }
 
-                    xd->above_context = pc->above_context;
-                    xd->left_context = &mb_row_left_context;
-                    vpx_memset(&mb_row_left_context, 0, sizeof(mb_row_left_context));
-                    xd->up_available = (mb_row != 0);
+        if (tokens)
+        {
+            /* wait until the tokens of this MB are parsed */
+            vp8_row_sync_wait(&pbi->mt_row_sync, &pbi->mt_mbs_parsed,
+                              mb_row * pc->mb_cols + mb_col + 1);
 
-                    xd->mb_to_top_edge = -((mb_row * 16)) << 3;
-                    xd->mb_to_bottom_edge = ((pc->mb_rows - 1 - mb_row) * 16) << 3;
+            if (stat_time)
+                vp8d_stat_lap(stat_time, STAT_THREAD_WAIT, &stat_mark);
 
-                    for (mb_col = 0; mb_col < pc->mb_cols; mb_col++)
-                    {
-                        if ((mb_col & (nsync-1)) == 0)
-                        {
-                            while (mb_col > (*last_row_current_mb_col - nsync) && *last_row_current_mb_col != pc->mb_cols - 1)
-                            {
-                                x86_pause_hint();
-                                thread_sleep(0);
-                            }
-                        }
-
-                        /* Distance of MB to the various image edges.
-                         * These are specified to 8th pel as they are always
-                         * compared to values that are in 1/8th pel units.
-                         */
-                        xd->mb_to_left_edge = -((mb_col * 16) << 3);
-                        xd->mb_to_right_edge = ((pc->mb_cols - 1 - mb_col) * 16) << 3;
+            eobtotal = tokens->eobtotal;
+            corrupted = tokens->corrupted;
 
-#if CONFIG_ERROR_CONCEALMENT
-                        {
-                            int corrupt_residual =
-                                        (!pbi->independent_partitions &&
-                                        pbi->frame_corrupt_residual) ||
-                                        vp8dx_bool_error(xd->current_bc);
-                            if (pbi->ec_active &&
-                                (xd->mode_info_context->mbmi.ref_frame ==
-                                                                 INTRA_FRAME) &&
-                                corrupt_residual)
-                            {
-                                /* We have an intra block with corrupt
-                                 * coefficients, better to conceal with an inter
-                                 * block.
-                                 * Interpolate MVs from neighboring MBs
-                                 *
-                                 * Note that for the first mb with corrupt
-                                 * residual in a frame, we might not discover
-                                 * that before decoding the residual. That
-                                 * happens after this check, and therefore no
-                                 * inter concealment will be done.
-                                 */
-                                vp8_interpolate_motion(xd,
-                                                       mb_row, mb_col,
-                                                       pc->mb_rows, pc->mb_cols,
-                                                       pc->mode_info_stride);
-                            }
-                        }
-#endif
+            if (eobtotal || corrupted)
+            {
+                vpx_memcpy(xd->qcoeff, tokens->qcoeff, sizeof(xd->qcoeff));
+                vpx_memcpy(xd->eobs, tokens->eobs, sizeof(xd->eobs));
+            }
 
+            tokens++;
+        }
+        else
+        {
+            eobtotal = decode_mb_tokens(pbi, xd);
+            corrupted = vp8dx_bool_error(xd->current_bc);
+        }
 
-                        xd->dst.y_buffer = pc->yv12_fb[dst_fb_idx].y_buffer + recon_yoffset;
-                        xd->dst.u_buffer = pc->yv12_fb[dst_fb_idx].u_buffer + recon_uvoffset;
-                        xd->dst.v_buffer = pc->yv12_fb[dst_fb_idx].v_buffer + recon_uvoffset;
-
-                        xd->left_available = (mb_col != 0);
-
-                        /* Select the appropriate reference frame for this MB */
-                        if (xd->mode_info_context->mbmi.ref_frame == LAST_FRAME)
-                            ref_fb_idx = pc->lst_fb_idx;
-                        else if (xd->mode_info_context->mbmi.ref_frame == GOLDEN_FRAME)
-                            ref_fb_idx = pc->gld_fb_idx;
-                        else
-                            ref_fb_idx = pc->alt_fb_idx;
-
-                        xd->pre.y_buffer = pc->yv12_fb[ref_fb_idx].y_buffer + recon_yoffset;
-                        xd->pre.u_buffer = pc->yv12_fb[ref_fb_idx].u_buffer + recon_uvoffset;
-                        xd->pre.v_buffer = pc->yv12_fb[ref_fb_idx].v_buffer + recon_uvoffset;
-
-                        if (xd->mode_info_context->mbmi.ref_frame !=
-                                INTRA_FRAME)
-                        {
-                            /* propagate errors from reference frames */
-                            xd->corrupted |= pc->yv12_fb[ref_fb_idx].corrupted;
-                        }
-
-                        decode_macroblock(pbi, xd, mb_row, mb_col);
-
-                        /* check if the boolean decoder has suffered an error */
-                        xd->corrupted |= vp8dx_bool_error(xd->current_bc);
-
-                        if (pbi->common.filter_level)
-                        {
-                            int skip_lf = (xd->mode_info_context->mbmi.mode != B_PRED &&
-                                            xd->mode_info_context->mbmi.mode != SPLITMV &&
-                                            xd->mode_info_context->mbmi.mb_skip_coeff);
-
-                            const int mode_index = lfi_n->mode_lf_lut[xd->mode_info_context->mbmi.mode];
-                            const int seg = xd->mode_info_context->mbmi.segment_id;
-                            const int ref_frame = xd->mode_info_context->mbmi.ref_frame;
-
-                            filter_level = lfi_n->lvl[seg][ref_frame][mode_index];
-
-                            if( mb_row != pc->mb_rows-1 )
-                            {
-                                /* Save decoded MB last row data for next-row decoding */
-                                vpx_memcpy((pbi->mt_yabove_row[mb_row + 1] + 32 + mb_col*16), (xd->dst.y_buffer + 15 * recon_y_stride), 16);
-                                vpx_memcpy((pbi->mt_uabove_row[mb_row + 1] + 16 + mb_col*8), (xd->dst.u_buffer + 7 * recon_uv_stride), 8);
-                                vpx_memcpy((pbi->mt_vabove_row[mb_row + 1] + 16 + mb_col*8), (xd->dst.v_buffer + 7 * recon_uv_stride), 8);
-                            }
-
-                            /* save left_col for next MB decoding */
-                            if(mb_col != pc->mb_cols-1)
-                            {
-                                MODE_INFO *next = xd->mode_info_context +1;
-
-                                if (next->mbmi.ref_frame == INTRA_FRAME)
-                                {
-                                    for (i = 0; i < 16; i++)
-                                        pbi->mt_yleft_col[mb_row][i] = xd->dst.y_buffer [i* recon_y_stride + 15];
-                                    for (i = 0; i < 8; i++)
-                                    {
-                                        pbi->mt_uleft_col[mb_row][i] = xd->dst.u_buffer [i* recon_uv_stride + 7];
-                                        pbi->mt_vleft_col[mb_row][i] = xd->dst.v_buffer [i* recon_uv_stride + 7];
-                                    }
-                                }
-                            }
-
-                            /* loopfilter on this macroblock. */
-                            if (filter_level)
-                            {
-                                if(pc->filter_type == NORMAL_LOOPFILTER)
-                                {
-                                    loop_filter_info lfi;
-                                    FRAME_TYPE frame_type = pc->frame_type;
-                                    const int hev_index = lfi_n->hev_thr_lut[frame_type][filter_level];
-                                    lfi.mblim = lfi_n->mblim[filter_level];
-                                    lfi.blim = lfi_n->blim[filter_level];
-                                    lfi.lim = lfi_n->lim[filter_level];
-                                    lfi.hev_thr = lfi_n->hev_thr[hev_index];
-
-                                    if (mb_col > 0)
-                                        vp8_loop_filter_mbv
-                                        (xd->dst.y_buffer, xd->dst.u_buffer, xd->dst.v_buffer, recon_y_stride, recon_uv_stride, &lfi);
-
-                                    if (!skip_lf)
-                                        vp8_loop_filter_bv
-                                        (xd->dst.y_buffer, xd->dst.u_buffer, xd->dst.v_buffer, recon_y_stride, recon_uv_stride, &lfi);
-
-                                    /* don't apply across umv border */
-                                    if (mb_row > 0)
-                                        vp8_loop_filter_mbh
-                                        (xd->dst.y_buffer, xd->dst.u_buffer, xd->dst.v_buffer, recon_y_stride, recon_uv_stride, &lfi);
-
-                                    if (!skip_lf)
-                                        vp8_loop_filter_bh
-                                        (xd->dst.y_buffer, xd->dst.u_buffer, xd->dst.v_buffer,  recon_y_stride, recon_uv_stride, &lfi);
-                                }
-                                else
-                                {
-                                    if (mb_col > 0)
-                                        vp8_loop_filter_simple_mbv
-                                        (xd->dst.y_buffer, recon_y_stride, lfi_n->mblim[filter_level]);
-
-                                    if (!skip_lf)
-                                        vp8_loop_filter_simple_bv
-                                        (xd->dst.y_buffer, recon_y_stride, lfi_n->blim[filter_level]);
-
-                                    /* don't apply across umv border */
-                                    if (mb_row > 0)
-                                        vp8_loop_filter_simple_mbh
-                                        (xd->dst.y_buffer, recon_y_stride, lfi_n->mblim[filter_level]);
-
-                                    if (!skip_lf)
-                                        vp8_loop_filter_simple_bh
-                                        (xd->dst.y_buffer, recon_y_stride, lfi_n->blim[filter_level]);
-                                }
-                            }
-
-                        }
-
-                        recon_yoffset += 16;
-                        recon_uvoffset += 8;
-
-                        ++xd->mode_info_context;  /* next mb */
-
-                        xd->above_context++;
-
-                        /*pbi->mb_row_di[ithread].current_mb_col = mb_col;*/
-                        pbi->mt_current_mb_col[mb_row] = mb_col;
-                    }
+        if (stat_time)
+            vp8d_stat_lap(stat_time, STAT_TOKENS, &stat_mark);
+
+        decode_macroblock(pbi, xd, mb_row, mb_col, eobtotal, corrupted);
+
+        if (stat_time)
+            vp8d_stat_lap(stat_time, STAT_RECON, &stat_mark);
+
+        /* check if the boolean decoder has suffered an error */
+        xd->corrupted |= corrupted;
 
-                    /* adjust to the next row of mbs */
-                    if (pbi->common.filter_level)
+        if (pbi->common.filter_level)
+        {
+            int skip_lf = (xd->mode_info_context->mbmi.mode != B_PRED &&
+                            xd->mode_info_context->mbmi.mode != SPLITMV &&
+                            xd->mode_info_context->mbmi.mb_skip_coeff);
+
+            const int mode_index = lfi_n->mode_lf_lut[xd->mode_info_context->mbmi.mode];
+            const int seg = xd->mode_info_context->mbmi.segment_id;
+            const int ref_frame = xd->mode_info_context->mbmi.ref_frame;
+
+            filter_level = lfi_n->lvl[seg][ref_frame][mode_index];
+
+            /* Save decoded MB last row data for next-row decoding */
+            if(mb_row != pc->mb_rows-1)
+            {
+                vpx_memcpy((pbi->mt_yabove_row[mb_row +1] + 32 + mb_col*16), (xd->dst.y_buffer + 15 * recon_y_stride), 16);
+                vpx_memcpy((pbi->mt_uabove_row[mb_row +1] + 16 + mb_col*8), (xd->dst.u_buffer + 7 * recon_uv_stride), 8);
+                vpx_memcpy((pbi->mt_vabove_row[mb_row +1] + 16 + mb_col*8), (xd->dst.v_buffer + 7 * recon_uv_stride), 8);
+            }
+
+            /* save left_col for next MB decoding */
+            if(mb_col != pc->mb_cols-1)
+            {
+                MODE_INFO *next = xd->mode_info_context +1;
+
+                if (next->mbmi.ref_frame == INTRA_FRAME)
+                {
+                    for (i = 0; i < 16; i++)
+                        pbi->mt_yleft_col[mb_row][i] = xd->dst.y_buffer [i* recon_y_stride + 15];
+                    for (i = 0; i < 8; i++)
                     {
-                        if(mb_row != pc->mb_rows-1)
-                        {
-                            int lasty = pc->yv12_fb[ref_fb_idx].y_width + VP8BORDERINPIXELS;
-                            int lastuv = (pc->yv12_fb[ref_fb_idx].y_width>>1) + (VP8BORDERINPIXELS>>1);
-
-                            for (i = 0; i < 4; i++)
-                            {
-                                pbi->mt_yabove_row[mb_row +1][lasty + i] = pbi->mt_yabove_row[mb_row +1][lasty -1];
-                                pbi->mt_uabove_row[mb_row +1][lastuv + i] = pbi->mt_uabove_row[mb_row +1][lastuv -1];
-                                pbi->mt_vabove_row[mb_row +1][lastuv + i] = pbi->mt_vabove_row[mb_row +1][lastuv -1];
-                            }
-                        }
-                    } else
-                        vp8_extend_mb_row(&pc->yv12_fb[dst_fb_idx], xd->dst.y_buffer + 16, xd->dst.u_buffer + 8, xd->dst.v_buffer + 8);
-
-                    ++xd->mode_info_context;      /* skip prediction column */
-
-                    /* since we have multithread */
-                    xd->mode_info_context += xd->mode_info_stride * pbi->decoding_thread_count;
+                        pbi->mt_uleft_col[mb_row][i] = xd->dst.u_buffer [i* recon_uv_stride + 7];
+                        pbi->mt_vleft_col[mb_row][i] = xd->dst.v_buffer [i* recon_uv_stride + 7];
+                    }
                 }
             }
+
+            /* loopfilter on this macroblock. */
+            if (filter_level)
+            {
+                if(pc->filter_type == NORMAL_LOOPFILTER)
+                {
+                    loop_filter_info lfi;
+                    FRAME_TYPE frame_type = pc->frame_type;
+                    const int hev_index = lfi_n->hev_thr_lut[frame_type][filter_level];
+                    lfi.mblim = lfi_n->mblim[filter_level];
+                    lfi.blim = lfi_n->blim[filter_level];
+                    lfi.lim = lfi_n->lim[filter_level];
+                    lfi.hev_thr = lfi_n->hev_thr[hev_index];
+
+                    if (mb_col > 0)
+                        vp8_loop_filter_mbv
+                        (xd->dst.y_buffer, xd->dst.u_buffer, xd->dst.v_buffer, recon_y_stride, recon_uv_stride, &lfi);
+
+                    if (!skip_lf)
+                        vp8_loop_filter_bv
+                        (xd->dst.y_buffer, xd->dst.u_buffer, xd->dst.v_buffer, recon_y_stride, recon_uv_stride, &lfi);
+
+                    /* don't apply across umv border */
+                    if (mb_row > 0)
+                        vp8_loop_filter_mbh
+                        (xd->dst.y_buffer, xd->dst.u_buffer, xd->dst.v_buffer, recon_y_stride, recon_uv_stride, &lfi);
+
+                    if (!skip_lf)
+                        vp8_loop_filter_bh
+                        (xd->dst.y_buffer, xd->dst.u_buffer, xd->dst.v_buffer,  recon_y_stride, recon_uv_stride, &lfi);
+                }
+                else
+                {
+                    if (mb_col > 0)
+                        vp8_loop_filter_simple_mbv
+                        (xd->dst.y_buffer, recon_y_stride, lfi_n->mblim[filter_level]);
+
+                    if (!skip_lf)
+                        vp8_loop_filter_simple_bv
+                        (xd->dst.y_buffer, recon_y_stride, lfi_n->blim[filter_level]);
+
+                    /* don't apply across umv border */
+                    if (mb_row > 0)
+                        vp8_loop_filter_simple_mbh
+                        (xd->dst.y_buffer, recon_y_stride, lfi_n->mblim[filter_level]);
+
+                    if (!skip_lf)
+                        vp8_loop_filter_simple_bh
+                        (xd->dst.y_buffer, recon_y_stride, lfi_n->blim[filter_level]);
+                }
+            }
+
+            if (stat_time)
+                vp8d_stat_lap(stat_time, STAT_LOOP_FILTER, &stat_mark);
+        }
+        recon_yoffset += 16;
+        recon_uvoffset += 8;
+
+        ++xd->mode_info_context;  /* next mb */
+
+        xd->above_context++;
+
+        /* the last MB is posted once the row is extended */
+        if (mb_col != last_mb_col)
+            vp8_row_sync_post(&pbi->mt_row_sync, &pbi->mt_current_mb_col[mb_row], mb_col);
+    }
+
+    /* adjust to the next row of mbs */
+    if (pbi->common.filter_level)
+    {
+        if(mb_row != pc->mb_rows-1)
+        {
+            int lasty = pc->yv12_fb[ref_fb_idx].y_width + VP8BORDERINPIXELS;
+            int lastuv = (pc->yv12_fb[ref_fb_idx].y_width>>1) + (VP8BORDERINPIXELS>>1);
+
+            for (i = 0; i < 4; i++)
+            {
+                pbi->mt_yabove_row[mb_row +1][lasty + i] = pbi->mt_yabove_row[mb_row +1][lasty -1];
+                pbi->mt_uabove_row[mb_row +1][lastuv + i] = pbi->mt_uabove_row[mb_row +1][lastuv -1];
+                pbi->mt_vabove_row[mb_row +1][lastuv + i] = pbi->mt_vabove_row[mb_row +1][lastuv -1];
+            }
+        }
+    }else
+        vp8_extend_mb_row(&pc->yv12_fb[dst_fb_idx], xd->dst.y_buffer + 16, xd->dst.u_buffer + 8, xd->dst.v_buffer + 8);
+
+    vp8_row_sync_post(&pbi->mt_row_sync, &pbi->mt_current_mb_col[mb_row], last_mb_col);
+
+    /* Extend the borders of the rows that are final while they are still in
+     * the cache. The row above is once this one is filtered, and no longer
+     * provides the left edge for intra prediction.
+     */
+    if (mb_row > 0)
+        vp8_extend_mb_row_borders(&pc->yv12_fb[dst_fb_idx], mb_row - 1);
+
+    if (mb_row == pc->mb_rows - 1)
+        vp8_extend_mb_row_borders(&pc->yv12_fb[dst_fb_idx], mb_row);
+
+    if (stat_time)
+        vp8d_stat_lap(stat_time, STAT_EXTEND, &stat_mark);
+}
+
+/* Claims and decodes MB rows until all rows of the frame are taken. Rows are
+ * handed out in order to whichever thread is free, so a descheduled thread
+ * only delays the row it holds.
+ */
+static void decode_mb_rows(VP8D_COMP *pbi, MB_ROW_DEC *mbrd)
+{
+    int64_t *stat_time = pbi->stats_enabled ? mbrd->stat_time : NULL;
+    int mb_row;
+
+    while ((mb_row = atomic_fetch_add(&pbi->mt_next_mb_row, 1)) < pbi->common.mb_rows)
+        decode_mb_row(pbi, &mbrd->mbd, mb_row, stat_time);
+}
+
+/* Puts the rows that are final from the thread decoding the frame. Row N-1
+ * is final once row N is loop filtered.
+ */
+static void put_final_rows(VP8D_COMP *pbi)
+{
+    VP8_COMMON *pc = &pbi->common;
+    int mb_row = pbi->mb_rows_put;
+
+    if (!pbi->put_rows_active)
+        return;
+
+    while (mb_row + 1 < pc->mb_rows &&
+           atomic_load_acquire(&pbi->mt_current_mb_col[mb_row + 1]) >=
+           pc->mb_cols - 1)
+        mb_row++;
+
+    vp8dx_put_rows(pbi, mb_row);
+}
+
+/* Parses the tokens of a frame with a single token partition into the
+ * mt_tokens ring, ahead of the threads reconstructing the rows. A ring row
+ * is reused once the row previously held in it is decoded.
+ */
+static void parse_mb_rows(VP8D_COMP *pbi, MACROBLOCKD *xd)
+{
+    VP8_COMMON *pc = &pbi->common;
+    int mb_row, mb_col;
+    int last_mb_col = pc->mb_cols - 1;
+    int64_t *stat_time = pbi->stats_enabled ? pbi->stats_frame.time : NULL;
+    int64_t stat_mark = 0;
+
+    xd->mode_info_context = pc->mi;
+
+    for (mb_row = 0; mb_row < pc->mb_rows; mb_row++)
+    {
+        MB_TOKENS *tokens = pbi->mt_tokens + (mb_row % pbi->mt_token_rows) * pc->mb_cols;
+
+        if (stat_time)
+            stat_mark = vpx_nsec_timestamp();
+
+        if (mb_row >= pbi->mt_token_rows)
+        {
+            vp8_row_sync_wait(&pbi->mt_row_sync,
+                              &pbi->mt_current_mb_col[mb_row - pbi->mt_token_rows],
+                              last_mb_col);
+
+            if (stat_time)
+                vp8d_stat_lap(stat_time, STAT_THREAD_WAIT, &stat_mark);
         }
-        /*  add this to each frame */
-        if ((mbrd->mb_row == pbi->common.mb_rows-1) || ((mbrd->mb_row == pbi->common.mb_rows-2) && (pbi->common.mb_rows % (pbi->decoding_thread_count+1))==1))
+
+        xd->above_context = pc->above_context;
+        vpx_memset(xd->left_context, 0, sizeof(ENTROPY_CONTEXT_PLANES));
+
+        for (mb_col = 0; mb_col < pc->mb_cols; mb_col++)
+        {
+            tokens->eobtotal = decode_mb_tokens(pbi, xd);
+            tokens->corrupted = vp8dx_bool_error(xd->current_bc);
+
+            if (tokens->eobtotal || tokens->corrupted)
+            {
+                vpx_memcpy(tokens->qcoeff, xd->qcoeff, sizeof(xd->qcoeff));
+                vpx_memcpy(tokens->eobs, xd->eobs, sizeof(xd->eobs));
+                vpx_memset(xd->qcoeff, 0, sizeof(xd->qcoeff));
+            }
+
+            tokens++;
+            xd->mode_info_context++;
+            xd->above_context++;
+
+            vp8_row_sync_post(&pbi->mt_row_sync, &pbi->mt_mbs_parsed,
+                              mb_row * pc->mb_cols + mb_col + 1);
+        }
+
+        ++xd->mode_info_context;      /* skip prediction column */
+
+        if (stat_time)
+            vp8d_stat_lap(stat_time, STAT_TOKENS, &stat_mark);
+
+        put_final_rows(pbi);
+    }
+}
+
+
+#if CONFIG_POSTPROC
+/* Runs bands of the postprocessing pass until none is left. */
+static void run_post_proc_bands(VP8D_COMP *pbi)
+{
+    vp8_pp_pass_t *pass = pbi->mt_pp_pass;
+    int band;
+
+    while ((band = atomic_fetch_add(&pbi->mt_pp_next_band, 1)) < pass->num_bands)
+        pass->fn(pass, band);
+
+    vp8_clear_system_state();
+}
+#endif
+
+
+#if CONFIG_ERROR_CONCEALMENT
+/* Estimates the missing MVs of bands of the concealed MB rows until none is
+ * left.
+ */
+static void run_ec_bands(VP8D_COMP *pbi)
+{
+    const int first_row = pbi->mt_ec_first_row;
+    const int rows = pbi->common.mb_rows - first_row;
+    int band;
+
+    while ((band = atomic_fetch_add(&pbi->mt_ec_next_band, 1)) < pbi->mt_ec_bands)
+        vp8_estimate_missing_mvs_rows(pbi,
+                                      first_row + rows * band / pbi->mt_ec_bands,
+                                      first_row + rows * (band + 1) / pbi->mt_ec_bands);
+}
+#endif
+
+
+/* Runs the work the threads were posted for: a pass over bands of the frame,
+ * or else the MB rows of the frame being decoded.
+ */
+static void run_thread_work(VP8D_COMP *pbi, MB_ROW_DEC *mbrd)
+{
+#if CONFIG_POSTPROC
+    if (pbi->mt_pp_pass)
+    {
+        run_post_proc_bands(pbi);
+        return;
+    }
+#endif
+#if CONFIG_ERROR_CONCEALMENT
+    if (pbi->mt_ec_bands)
+    {
+        run_ec_bands(pbi);
+        return;
+    }
+#endif
+    decode_mb_rows(pbi, mbrd);
+}
+
+
+static THREAD_FUNCTION thread_decoding_proc(void *p_data)
+{
+    int ithread = ((DECODETHREAD_DATA *)p_data)->ithread;
+    VP8D_COMP *pbi = (VP8D_COMP *)(((DECODETHREAD_DATA *)p_data)->ptr1);
+    MB_ROW_DEC *mbrd = (MB_ROW_DEC *)(((DECODETHREAD_DATA *)p_data)->ptr2);
+    ENTROPY_CONTEXT_PLANES mb_row_left_context;
+
+    mbrd->mbd.left_context = &mb_row_left_context;
+
+    while (1)
+    {
+        if (pbi->b_multithreaded_rd == 0)
+            break;
+
+        /*if(WaitForSingleObject(pbi->h_event_start_decoding[ithread], INFINITE) == WAIT_OBJECT_0)*/
+        if (sem_wait(&pbi->h_event_start_decoding[ithread]) == 0)
         {
+            if (pbi->b_multithreaded_rd == 0)
+                break;
+
+            run_thread_work(pbi, mbrd);
+
+            /*  add this to each frame */
             /*SetEvent(pbi->h_event_end_decoding);*/
             sem_post(&pbi->h_event_end_decoding);
         }
@@ -523,6 +765,21 @@ static THREAD_FUNCTION thread_decoding_proc(void *p_data)
 }
 
 
+/* Decodes rows of the frame as a job of the shared thread pool. */
+static void decode_mb_rows_job(void *arg1, void *arg2)
+{
+    VP8D_COMP *pbi = (VP8D_COMP *)arg1;
+    MB_ROW_DEC *mbrd = (MB_ROW_DEC *)arg2;
+    ENTROPY_CONTEXT_PLANES mb_row_left_context;
+
+    mbrd->mbd.left_context = &mb_row_left_context;
+
+    run_thread_work(pbi, mbrd);
+
+    sem_post(&pbi->h_event_end_decoding);
+}
+
+
 void vp8_decoder_create_threads(VP8D_COMP *pbi)
 {
     int core_count = 0;
@@ -540,13 +797,48 @@ void vp8_decoder_create_threads(VP8D_COMP *pbi)
 
     if (core_count > 1)
     {
+        if (vp8_row_sync_init(&pbi->mt_row_sync))
+            vpx_internal_error(&pbi->common.error, VPX_CODEC_MEM_ERROR,
+                               "Failed to initialize row synchronization");
+
         pbi->b_multithreaded_rd = 1;
         pbi->decoding_thread_count = core_count - 1;
 
-        CHECK_MEM_ERROR(pbi->h_decoding_thread, vpx_malloc(sizeof(pthread_t) * pbi->decoding_thread_count));
-        CHECK_MEM_ERROR(pbi->h_event_start_decoding, vpx_malloc(sizeof(sem_t) * pbi->decoding_thread_count));
+        if (pbi->use_thread_pool)
+        {
+            pbi->thread_pool = vp8_thread_pool_acquire(pbi->common.processor_core_count);
+
+            if (!pbi->thread_pool)
+                vpx_internal_error(&pbi->common.error, VPX_CODEC_MEM_ERROR,
+                                   "Failed to start the decoder thread pool");
+
+            /* More jobs than workers would only wait for one another. */
+            if (pbi->decoding_thread_count > pbi->thread_pool->num_workers)
+                pbi->decoding_thread_count = pbi->thread_pool->num_workers;
+        }
+
         CHECK_MEM_ERROR(pbi->mb_row_di, vpx_memalign(32, sizeof(MB_ROW_DEC) * pbi->decoding_thread_count));
         vpx_memset(pbi->mb_row_di, 0, sizeof(MB_ROW_DEC) * pbi->decoding_thread_count);
+
+        sem_init(&pbi->h_event_end_decoding, 0, 0);
+
+        if (pbi->thread_pool)
+        {
+            CHECK_MEM_ERROR(pbi->mt_jobs, vpx_calloc(pbi->decoding_thread_count, sizeof(VP8_POOL_JOB)));
+
+            for (ithread = 0; ithread < pbi->decoding_thread_count; ithread++)
+            {
+                pbi->mt_jobs[ithread].fn = decode_mb_rows_job;
+                pbi->mt_jobs[ithread].arg1 = pbi;
+                pbi->mt_jobs[ithread].arg2 = &pbi->mb_row_di[ithread];
+            }
+
+            pbi->allocated_decoding_thread_count = pbi->decoding_thread_count;
+            return;
+        }
+
+        CHECK_MEM_ERROR(pbi->h_decoding_thread, vpx_malloc(sizeof(pthread_t) * pbi->decoding_thread_count));
+        CHECK_MEM_ERROR(pbi->h_event_start_decoding, vpx_malloc(sizeof(sem_t) * pbi->decoding_thread_count));
         CHECK_MEM_ERROR(pbi->de_thread_data, vpx_malloc(sizeof(DECODETHREAD_DATA) * pbi->decoding_thread_count));
 
         for (ithread = 0; ithread < pbi->decoding_thread_count; ithread++)
@@ -560,89 +852,59 @@ void vp8_decoder_create_threads(VP8D_COMP *pbi)
             pthread_create(&pbi->h_decoding_thread[ithread], 0, thread_decoding_proc, (&pbi->de_thread_data[ithread]));
         }
 
-        sem_init(&pbi->h_event_end_decoding, 0, 0);
-
         pbi->allocated_decoding_thread_count = pbi->decoding_thread_count;
     }
 }
 
 
-void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows)
+/* Allocates the pointers of the MB rows of the frame into a ring of rows
+ * buffers of size bytes, the first of which starts the allocation.
+ */
+static unsigned char **alloc_row_ring(int mb_rows, int rows, int size)
 {
+    unsigned char **row_ptrs = vpx_malloc(sizeof(*row_ptrs) * mb_rows);
+    unsigned char *buf = vpx_calloc(rows * size, 1);
     int i;
 
-    if (pbi->b_multithreaded_rd)
+    if (!row_ptrs || !buf)
     {
-            vpx_free(pbi->mt_current_mb_col);
-            pbi->mt_current_mb_col = NULL ;
+        vpx_free(row_ptrs);
+        vpx_free(buf);
+        return NULL;
+    }
 
-        /* Free above_row buffers. */
-        if (pbi->mt_yabove_row)
-        {
-            for (i=0; i< mb_rows; i++)
-            {
-                    vpx_free(pbi->mt_yabove_row[i]);
-                    pbi->mt_yabove_row[i] = NULL ;
-            }
-            vpx_free(pbi->mt_yabove_row);
-            pbi->mt_yabove_row = NULL ;
-        }
+    for (i = 0; i < mb_rows; i++)
+        row_ptrs[i] = buf + (i % rows) * size;
 
-        if (pbi->mt_uabove_row)
-        {
-            for (i=0; i< mb_rows; i++)
-            {
-                    vpx_free(pbi->mt_uabove_row[i]);
-                    pbi->mt_uabove_row[i] = NULL ;
-            }
-            vpx_free(pbi->mt_uabove_row);
-            pbi->mt_uabove_row = NULL ;
-        }
+    return row_ptrs;
+}
 
-        if (pbi->mt_vabove_row)
-        {
-            for (i=0; i< mb_rows; i++)
-            {
-                    vpx_free(pbi->mt_vabove_row[i]);
-                    pbi->mt_vabove_row[i] = NULL ;
-            }
-            vpx_free(pbi->mt_vabove_row);
-            pbi->mt_vabove_row = NULL ;
-        }
+static void free_row_ring(unsigned char ***row_ptrs)
+{
+    if (*row_ptrs)
+    {
+        vpx_free((*row_ptrs)[0]);
+        vpx_free(*row_ptrs);
+        *row_ptrs = NULL;
+    }
+}
 
-        /* Free left_col buffers. */
-        if (pbi->mt_yleft_col)
-        {
-            for (i=0; i< mb_rows; i++)
-            {
-                    vpx_free(pbi->mt_yleft_col[i]);
-                    pbi->mt_yleft_col[i] = NULL ;
-            }
-            vpx_free(pbi->mt_yleft_col);
-            pbi->mt_yleft_col = NULL ;
-        }
+void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows)
+{
+    if (pbi->b_multithreaded_rd)
+    {
+            vpx_free(pbi->mt_current_mb_col);
+            pbi->mt_current_mb_col = NULL ;
 
-        if (pbi->mt_uleft_col)
-        {
-            for (i=0; i< mb_rows; i++)
-            {
-                    vpx_free(pbi->mt_uleft_col[i]);
-                    pbi->mt_uleft_col[i] = NULL ;
-            }
-            vpx_free(pbi->mt_uleft_col);
-            pbi->mt_uleft_col = NULL ;
-        }
+            vpx_free(pbi->mt_tokens);
+            pbi->mt_tokens = NULL;
 
-        if (pbi->mt_vleft_col)
-        {
-            for (i=0; i< mb_rows; i++)
-            {
-                    vpx_free(pbi->mt_vleft_col[i]);
-                    pbi->mt_vleft_col[i] = NULL ;
-            }
-            vpx_free(pbi->mt_vleft_col);
-            pbi->mt_vleft_col = NULL ;
-        }
+        free_row_ring(&pbi->mt_yabove_row);
+        free_row_ring(&pbi->mt_uabove_row);
+        free_row_ring(&pbi->mt_vabove_row);
+        free_row_ring(&pbi->mt_yleft_col);
+        free_row_ring(&pbi->mt_uleft_col);
+        free_row_ring(&pbi->mt_vleft_col);
     }
 }
 
@@ -650,8 +912,8 @@ void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows)
 void vp8mt_alloc_temp_buffers(VP8D_COMP *pbi, int width, int prev_mb_rows)
 {
     VP8_COMMON *const pc = & pbi->common;
-    int i;
     int uv_width;
+    int rows;
 
     if (pbi->b_multithreaded_rd)
     {
@@ -671,31 +933,26 @@ void vp8mt_alloc_temp_buffers(VP8D_COMP *pbi, int width, int prev_mb_rows)
         /* Allocate an int for each mb row. */
         CHECK_MEM_ERROR(pbi->mt_current_mb_col, vpx_malloc(sizeof(int) * pc->mb_rows));
 
-        /* Allocate memory for above_row buffers. */
-        CHECK_MEM_ERROR(pbi->mt_yabove_row, vpx_malloc(sizeof(unsigned char *) * pc->mb_rows));
-        for (i=0; i< pc->mb_rows; i++)
-            CHECK_MEM_ERROR(pbi->mt_yabove_row[i], vpx_calloc(sizeof(unsigned char) * (width + (VP8BORDERINPIXELS<<1)), 1));
-
-        CHECK_MEM_ERROR(pbi->mt_uabove_row, vpx_malloc(sizeof(unsigned char *) * pc->mb_rows));
-        for (i=0; i< pc->mb_rows; i++)
-            CHECK_MEM_ERROR(pbi->mt_uabove_row[i], vpx_calloc(sizeof(unsigned char) * (uv_width + VP8BORDERINPIXELS), 1));
+        /* The intra prediction rows and columns are only live while their MB
+         * row is decoded. Rows finish in order, so no more rows than there
+         * are threads are decoded at once, and the thread decoding row N
+         * only writes the above row of row N + 1 behind the thread decoding
+         * row N, which is one row further than the ring reaches back. A row
+         * per thread is then enough.
+         */
+        rows = pbi->allocated_decoding_thread_count + 1;
+        if (rows > pc->mb_rows)
+            rows = pc->mb_rows;
 
-        CHECK_MEM_ERROR(pbi->mt_vabove_row, vpx_malloc(sizeof(unsigned char *) * pc->mb_rows));
-        for (i=0; i< pc->mb_rows; i++)
-            CHECK_MEM_ERROR(pbi->mt_vabove_row[i], vpx_calloc(sizeof(unsigned char) * (uv_width + VP8BORDERINPIXELS), 1));
+        /* Allocate memory for above_row buffers. */
+        CHECK_MEM_ERROR(pbi->mt_yabove_row, alloc_row_ring(pc->mb_rows, rows, width + (VP8BORDERINPIXELS<<1)));
+        CHECK_MEM_ERROR(pbi->mt_uabove_row, alloc_row_ring(pc->mb_rows, rows, uv_width + VP8BORDERINPIXELS));
+        CHECK_MEM_ERROR(pbi->mt_vabove_row, alloc_row_ring(pc->mb_rows, rows, uv_width + VP8BORDERINPIXELS));
 
         /* Allocate memory for left_col buffers. */
-        CHECK_MEM_ERROR(pbi->mt_yleft_col, vpx_malloc(sizeof(unsigned char *) * pc->mb_rows));
-        for (i=0; i< pc->mb_rows; i++)
-            CHECK_MEM_ERROR(pbi->mt_yleft_col[i], vpx_calloc(sizeof(unsigned char) * 16, 1));
-
-        CHECK_MEM_ERROR(pbi->mt_uleft_col, vpx_malloc(sizeof(unsigned char *) * pc->mb_rows));
-        for (i=0; i< pc->mb_rows; i++)
-            CHECK_MEM_ERROR(pbi->mt_uleft_col[i], vpx_calloc(sizeof(unsigned char) * 8, 1));
-
-        CHECK_MEM_ERROR(pbi->mt_vleft_col, vpx_malloc(sizeof(unsigned char *) * pc->mb_rows));
-        for (i=0; i< pc->mb_rows; i++)
-            CHECK_MEM_ERROR(pbi->mt_vleft_col[i], vpx_calloc(sizeof(unsigned char) * 8, 1));
+        CHECK_MEM_ERROR(pbi->mt_yleft_col, alloc_row_ring(pc->mb_rows, rows, 16));
+        CHECK_MEM_ERROR(pbi->mt_uleft_col, alloc_row_ring(pc->mb_rows, rows, 8));
+        CHECK_MEM_ERROR(pbi->mt_vleft_col, alloc_row_ring(pc->mb_rows, rows, 8));
     }
 }
 
@@ -709,19 +966,32 @@ void vp8_decoder_remove_threads(VP8D_COMP *pbi)
 
         pbi->b_multithreaded_rd = 0;
 
-        /* allow all threads to exit */
-        for (i = 0; i < pbi->allocated_decoding_thread_count; i++)
+        if (pbi->thread_pool)
         {
-            sem_post(&pbi->h_event_start_decoding[i]);
-            pthread_join(pbi->h_decoding_thread[i], NULL);
+            vp8_thread_pool_release(pbi->thread_pool);
+            pbi->thread_pool = NULL;
+
+            vpx_free(pbi->mt_jobs);
+            pbi->mt_jobs = NULL;
         }
 
-        for (i = 0; i < pbi->allocated_decoding_thread_count; i++)
+        /* allow all threads to exit */
+        if (pbi->h_decoding_thread)
         {
-            sem_destroy(&pbi->h_event_start_decoding[i]);
+            for (i = 0; i < pbi->allocated_decoding_thread_count; i++)
+            {
+                sem_post(&pbi->h_event_start_decoding[i]);
+                pthread_join(pbi->h_decoding_thread[i], NULL);
+            }
+
+            for (i = 0; i < pbi->allocated_decoding_thread_count; i++)
+            {
+                sem_destroy(&pbi->h_event_start_decoding[i]);
+            }
         }
 
         sem_destroy(&pbi->h_event_end_decoding);
+        vp8_row_sync_destroy(&pbi->mt_row_sync);
 
             vpx_free(pbi->h_decoding_thread);
             pbi->h_decoding_thread = NULL;
@@ -739,271 +1009,144 @@ void vp8_decoder_remove_threads(VP8D_COMP *pbi)
 
 void vp8mt_decode_mb_rows( VP8D_COMP *pbi, MACROBLOCKD *xd)
 {
-    int mb_row;
     VP8_COMMON *pc = &pbi->common;
-
-    int num_part = 1 << pbi->common.multi_token_partition;
-    int i;
-    volatile int *last_row_current_mb_col = NULL;
-    int nsync = pbi->sync_range;
+    int i, j;
+    int64_t stat_mark = 0;
 
     int filter_level = pc->filter_level;
-    loop_filter_info_n *lfi_n = &pc->lf_info;
 
     if (filter_level)
     {
-        /* Set above_row buffer to 127 for decoding first MB row */
+        /* Set above_row buffer to 127 for decoding first MB row. The
+         * borders of the other rows are set as each row starts.
+         */
         vpx_memset(pbi->mt_yabove_row[0] + VP8BORDERINPIXELS-1, 127, pc->yv12_fb[pc->lst_fb_idx].y_width + 5);
         vpx_memset(pbi->mt_uabove_row[0] + (VP8BORDERINPIXELS>>1)-1, 127, (pc->yv12_fb[pc->lst_fb_idx].y_width>>1) +5);
         vpx_memset(pbi->mt_vabove_row[0] + (VP8BORDERINPIXELS>>1)-1, 127, (pc->yv12_fb[pc->lst_fb_idx].y_width>>1) +5);
 
-        for (i=1; i<pc->mb_rows; i++)
-        {
-            vpx_memset(pbi->mt_yabove_row[i] + VP8BORDERINPIXELS-1, (unsigned char)129, 1);
-            vpx_memset(pbi->mt_uabove_row[i] + (VP8BORDERINPIXELS>>1)-1, (unsigned char)129, 1);
-            vpx_memset(pbi->mt_vabove_row[i] + (VP8BORDERINPIXELS>>1)-1, (unsigned char)129, 1);
-        }
-
-        /* Set left_col to 129 initially */
-        for (i=0; i<pc->mb_rows; i++)
-        {
-            vpx_memset(pbi->mt_yleft_col[i], (unsigned char)129, 16);
-            vpx_memset(pbi->mt_uleft_col[i], (unsigned char)129, 8);
-            vpx_memset(pbi->mt_vleft_col[i], (unsigned char)129, 8);
-        }
-
         /* Initialize the loop filter for this frame. */
         vp8_loop_filter_frame_init(pc, &pbi->mb, filter_level);
     }
 
     setup_decoding_thread_data(pbi, xd, pbi->mb_row_di, pbi->decoding_thread_count);
 
-    for (i = 0; i < pbi->decoding_thread_count; i++)
-        sem_post(&pbi->h_event_start_decoding[i]);
+    pbi->mt_next_mb_row = 0;
 
-    for (mb_row = 0; mb_row < pc->mb_rows; mb_row += (pbi->decoding_thread_count + 1))
+    if (pbi->mt_pipeline)
     {
-        xd->current_bc = &pbi->mbc[mb_row%num_part];
-
-        /* vp8_decode_mb_row(pbi, pc, mb_row, xd); */
+        if (!pbi->mt_tokens)
         {
-            int i;
-            int recon_yoffset, recon_uvoffset;
-            int mb_col;
-            int ref_fb_idx = pc->lst_fb_idx;
-            int dst_fb_idx = pc->new_fb_idx;
-            int recon_y_stride = pc->yv12_fb[ref_fb_idx].y_stride;
-            int recon_uv_stride = pc->yv12_fb[ref_fb_idx].uv_stride;
-
-           /* volatile int *last_row_current_mb_col = NULL; */
-            if (mb_row > 0)
-                last_row_current_mb_col = &pbi->mt_current_mb_col[mb_row -1];
-
-            vpx_memset(&pc->left_context, 0, sizeof(pc->left_context));
-            recon_yoffset = mb_row * recon_y_stride * 16;
-            recon_uvoffset = mb_row * recon_uv_stride * 8;
-            /* reset above block coeffs */
-
-            xd->above_context = pc->above_context;
-            xd->up_available = (mb_row != 0);
-
-            xd->mb_to_top_edge = -((mb_row * 16)) << 3;
-            xd->mb_to_bottom_edge = ((pc->mb_rows - 1 - mb_row) * 16) << 3;
-
-            for (mb_col = 0; mb_col < pc->mb_cols; mb_col++)
-            {
-                if ( mb_row > 0 && (mb_col & (nsync-1)) == 0){
-                    while (mb_col > (*last_row_current_mb_col - nsync) && *last_row_current_mb_col != pc->mb_cols - 1)
-                    {
-                        x86_pause_hint();
-                        thread_sleep(0);
-                    }
-                }
-
-                /* Distance of MB to the various image edges.
-                 * These are specified to 8th pel as they are always compared to
-                 * values that are in 1/8th pel units.
-                 */
-                xd->mb_to_left_edge = -((mb_col * 16) << 3);
-                xd->mb_to_right_edge = ((pc->mb_cols - 1 - mb_col) * 16) << 3;
-
-#if CONFIG_ERROR_CONCEALMENT
-                {
-                    int corrupt_residual = (!pbi->independent_partitions &&
-                                            pbi->frame_corrupt_residual) ||
-                                            vp8dx_bool_error(xd->current_bc);
-                    if (pbi->ec_active &&
-                        (xd->mode_info_context->mbmi.ref_frame == INTRA_FRAME) &&
-                        corrupt_residual)
-                    {
-                        /* We have an intra block with corrupt coefficients,
-                         * better to conceal with an inter block. Interpolate
-                         * MVs from neighboring MBs
-                         *
-                         * Note that for the first mb with corrupt residual in a
-                         * frame, we might not discover that before decoding the
-                         * residual. That happens after this check, and
-                         * therefore no inter concealment will be done.
-                         */
-                        vp8_interpolate_motion(xd,
-                                               mb_row, mb_col,
-                                               pc->mb_rows, pc->mb_cols,
-                                               pc->mode_info_stride);
-                    }
-                }
-#endif
-
+            pbi->mt_token_rows = 2 * (pbi->allocated_decoding_thread_count + 1);
+            CHECK_MEM_ERROR(pbi->mt_tokens, vpx_memalign(16, sizeof(MB_TOKENS) * pbi->mt_token_rows * pc->mb_cols));
+        }
 
-                xd->dst.y_buffer = pc->yv12_fb[dst_fb_idx].y_buffer + recon_yoffset;
-                xd->dst.u_buffer = pc->yv12_fb[dst_fb_idx].u_buffer + recon_uvoffset;
-                xd->dst.v_buffer = pc->yv12_fb[dst_fb_idx].v_buffer + recon_uvoffset;
+        pbi->mt_mbs_parsed = 0;
+    }
 
-                xd->left_available = (mb_col != 0);
+    for (i = 0; i < pbi->decoding_thread_count; i++)
+    {
+        if (pbi->thread_pool)
+            vp8_thread_pool_submit(pbi->thread_pool, &pbi->mt_jobs[i]);
+        else
+            sem_post(&pbi->h_event_start_decoding[i]);
+    }
 
-                /* Select the appropriate reference frame for this MB */
-                if (xd->mode_info_context->mbmi.ref_frame == LAST_FRAME)
-                    ref_fb_idx = pc->lst_fb_idx;
-                else if (xd->mode_info_context->mbmi.ref_frame == GOLDEN_FRAME)
-                    ref_fb_idx = pc->gld_fb_idx;
-                else
-                    ref_fb_idx = pc->alt_fb_idx;
+    if (pbi->mt_pipeline)
+        parse_mb_rows(pbi, xd);
+    else
+    {
+        int64_t *stat_time = pbi->stats_enabled ? pbi->stats_frame.time : NULL;
+        int mb_row;
 
-                xd->pre.y_buffer = pc->yv12_fb[ref_fb_idx].y_buffer + recon_yoffset;
-                xd->pre.u_buffer = pc->yv12_fb[ref_fb_idx].u_buffer + recon_uvoffset;
-                xd->pre.v_buffer = pc->yv12_fb[ref_fb_idx].v_buffer + recon_uvoffset;
+        while ((mb_row = atomic_fetch_add(&pbi->mt_next_mb_row, 1)) < pc->mb_rows)
+        {
+            decode_mb_row(pbi, xd, mb_row, stat_time);
+            put_final_rows(pbi);
+        }
+    }
 
-                if (xd->mode_info_context->mbmi.ref_frame != INTRA_FRAME)
-                {
-                    /* propagate errors from reference frames */
-                    xd->corrupted |= pc->yv12_fb[ref_fb_idx].corrupted;
-                }
+    if (pbi->stats_enabled)
+        stat_mark = vpx_nsec_timestamp();
 
-                decode_macroblock(pbi, xd, mb_row, mb_col);
+    /* wait for the threads to finish their rows */
+    for (i = 0; i < pbi->decoding_thread_count; i++)
+        sem_wait(&pbi->h_event_end_decoding);
 
-                /* check if the boolean decoder has suffered an error */
-                xd->corrupted |= vp8dx_bool_error(xd->current_bc);
+    if (pbi->stats_enabled)
+    {
+        vp8d_stat_lap(pbi->stats_frame.time, STAT_THREAD_WAIT, &stat_mark);
 
-                if (pbi->common.filter_level)
-                {
-                    int skip_lf = (xd->mode_info_context->mbmi.mode != B_PRED &&
-                                    xd->mode_info_context->mbmi.mode != SPLITMV &&
-                                    xd->mode_info_context->mbmi.mb_skip_coeff);
+        /* the threads' own times, now that they are done with the frame */
+        for (i = 0; i < pbi->decoding_thread_count; i++)
+        {
+            for (j = 0; j < STAT_TIMES; j++)
+                pbi->stats_frame.time[j] += pbi->mb_row_di[i].stat_time[j];
 
-                    const int mode_index = lfi_n->mode_lf_lut[xd->mode_info_context->mbmi.mode];
-                    const int seg = xd->mode_info_context->mbmi.segment_id;
-                    const int ref_frame = xd->mode_info_context->mbmi.ref_frame;
+            vpx_memset(pbi->mb_row_di[i].stat_time, 0,
+                       sizeof(pbi->mb_row_di[i].stat_time));
+        }
+    }
+}
 
-                    filter_level = lfi_n->lvl[seg][ref_frame][mode_index];
+#if CONFIG_POSTPROC
+/* Runs a postprocessing pass on all the decoding threads, which take its
+ * bands in turn, as they take MB rows when decoding.
+ */
+void vp8mt_run_post_proc_pass(void *ctx, vp8_pp_pass_t *pass)
+{
+    VP8D_COMP *pbi = (VP8D_COMP *)ctx;
+    int i;
 
-                    /* Save decoded MB last row data for next-row decoding */
-                    if(mb_row != pc->mb_rows-1)
-                    {
-                        vpx_memcpy((pbi->mt_yabove_row[mb_row +1] + 32 + mb_col*16), (xd->dst.y_buffer + 15 * recon_y_stride), 16);
-                        vpx_memcpy((pbi->mt_uabove_row[mb_row +1] + 16 + mb_col*8), (xd->dst.u_buffer + 7 * recon_uv_stride), 8);
-                        vpx_memcpy((pbi->mt_vabove_row[mb_row +1] + 16 + mb_col*8), (xd->dst.v_buffer + 7 * recon_uv_stride), 8);
-                    }
+    pbi->mt_pp_pass = pass;
+    pbi->mt_pp_next_band = 0;
 
-                    /* save left_col for next MB decoding */
-                    if(mb_col != pc->mb_cols-1)
-                    {
-                        MODE_INFO *next = xd->mode_info_context +1;
-
-                        if (next->mbmi.ref_frame == INTRA_FRAME)
-                        {
-                            for (i = 0; i < 16; i++)
-                                pbi->mt_yleft_col[mb_row][i] = xd->dst.y_buffer [i* recon_y_stride + 15];
-                            for (i = 0; i < 8; i++)
-                            {
-                                pbi->mt_uleft_col[mb_row][i] = xd->dst.u_buffer [i* recon_uv_stride + 7];
-                                pbi->mt_vleft_col[mb_row][i] = xd->dst.v_buffer [i* recon_uv_stride + 7];
-                            }
-                        }
-                    }
+    for (i = 0; i < pbi->allocated_decoding_thread_count; i++)
+    {
+        if (pbi->thread_pool)
+            vp8_thread_pool_submit(pbi->thread_pool, &pbi->mt_jobs[i]);
+        else
+            sem_post(&pbi->h_event_start_decoding[i]);
+    }
 
-                    /* loopfilter on this macroblock. */
-                    if (filter_level)
-                    {
-                        if(pc->filter_type == NORMAL_LOOPFILTER)
-                        {
-                            loop_filter_info lfi;
-                            FRAME_TYPE frame_type = pc->frame_type;
-                            const int hev_index = lfi_n->hev_thr_lut[frame_type][filter_level];
-                            lfi.mblim = lfi_n->mblim[filter_level];
-                            lfi.blim = lfi_n->blim[filter_level];
-                            lfi.lim = lfi_n->lim[filter_level];
-                            lfi.hev_thr = lfi_n->hev_thr[hev_index];
-
-                            if (mb_col > 0)
-                                vp8_loop_filter_mbv
-                                (xd->dst.y_buffer, xd->dst.u_buffer, xd->dst.v_buffer, recon_y_stride, recon_uv_stride, &lfi);
-
-                            if (!skip_lf)
-                                vp8_loop_filter_bv
-                                (xd->dst.y_buffer, xd->dst.u_buffer, xd->dst.v_buffer, recon_y_stride, recon_uv_stride, &lfi);
-
-                            /* don't apply across umv border */
-                            if (mb_row > 0)
-                                vp8_loop_filter_mbh
-                                (xd->dst.y_buffer, xd->dst.u_buffer, xd->dst.v_buffer, recon_y_stride, recon_uv_stride, &lfi);
-
-                            if (!skip_lf)
-                                vp8_loop_filter_bh
-                                (xd->dst.y_buffer, xd->dst.u_buffer, xd->dst.v_buffer,  recon_y_stride, recon_uv_stride, &lfi);
-                        }
-                        else
-                        {
-                            if (mb_col > 0)
-                                vp8_loop_filter_simple_mbv
-                                (xd->dst.y_buffer, recon_y_stride, lfi_n->mblim[filter_level]);
-
-                            if (!skip_lf)
-                                vp8_loop_filter_simple_bv
-                                (xd->dst.y_buffer, recon_y_stride, lfi_n->blim[filter_level]);
-
-                            /* don't apply across umv border */
-                            if (mb_row > 0)
-                                vp8_loop_filter_simple_mbh
-                                (xd->dst.y_buffer, recon_y_stride, lfi_n->mblim[filter_level]);
-
-                            if (!skip_lf)
-                                vp8_loop_filter_simple_bh
-                                (xd->dst.y_buffer, recon_y_stride, lfi_n->blim[filter_level]);
-                        }
-                    }
+    run_post_proc_bands(pbi);
 
-                }
-                recon_yoffset += 16;
-                recon_uvoffset += 8;
+    for (i = 0; i < pbi->allocated_decoding_thread_count; i++)
+        sem_wait(&pbi->h_event_end_decoding);
 
-                ++xd->mode_info_context;  /* next mb */
+    pbi->mt_pp_pass = NULL;
+}
+#endif
 
-                xd->above_context++;
+#if CONFIG_ERROR_CONCEALMENT
+/* Estimates the missing MVs of the frame on all the decoding threads. The
+ * rows from the first corrupt MB on are split in a band per thread, each
+ * built from its own overlap lists.
+ */
+void vp8mt_estimate_missing_mvs(VP8D_COMP *pbi)
+{
+    VP8_COMMON *pc = &pbi->common;
+    const int first_row = pbi->mvs_corrupt_from_mb / pc->mb_cols;
+    int i;
 
-                pbi->mt_current_mb_col[mb_row] = mb_col;
-            }
+    pbi->mt_ec_first_row = first_row;
+    pbi->mt_ec_bands = pbi->allocated_decoding_thread_count + 1;
+    if (pbi->mt_ec_bands > pc->mb_rows - first_row)
+        pbi->mt_ec_bands = pc->mb_rows - first_row;
+    pbi->mt_ec_next_band = 0;
 
-            /* adjust to the next row of mbs */
-            if (pbi->common.filter_level)
-            {
-                if(mb_row != pc->mb_rows-1)
-                {
-                    int lasty = pc->yv12_fb[ref_fb_idx].y_width + VP8BORDERINPIXELS;
-                    int lastuv = (pc->yv12_fb[ref_fb_idx].y_width>>1) + (VP8BORDERINPIXELS>>1);
+    for (i = 0; i < pbi->allocated_decoding_thread_count; i++)
+    {
+        if (pbi->thread_pool)
+            vp8_thread_pool_submit(pbi->thread_pool, &pbi->mt_jobs[i]);
+        else
+            sem_post(&pbi->h_event_start_decoding[i]);
+    }
 
-                    for (i = 0; i < 4; i++)
-                    {
-                        pbi->mt_yabove_row[mb_row +1][lasty + i] = pbi->mt_yabove_row[mb_row +1][lasty -1];
-                        pbi->mt_uabove_row[mb_row +1][lastuv + i] = pbi->mt_uabove_row[mb_row +1][lastuv -1];
-                        pbi->mt_vabove_row[mb_row +1][lastuv + i] = pbi->mt_vabove_row[mb_row +1][lastuv -1];
-                    }
-                }
-            }else
-                vp8_extend_mb_row(&pc->yv12_fb[dst_fb_idx], xd->dst.y_buffer + 16, xd->dst.u_buffer + 8, xd->dst.v_buffer + 8);
+    run_ec_bands(pbi);
 
-            ++xd->mode_info_context;      /* skip prediction column */
-        }
-        xd->mode_info_context += xd->mode_info_stride * pbi->decoding_thread_count;
-    }
+    for (i = 0; i < pbi->allocated_decoding_thread_count; i++)
+        sem_wait(&pbi->h_event_end_decoding);
 
-    sem_wait(&pbi->h_event_end_decoding);   /* add back for each frame */
+    pbi->mt_ec_bands = 0;
 }
+#endif
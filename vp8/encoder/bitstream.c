@@ -374,234 +374,345 @@ static void write_partition_size(unsigned char *cx_data, int size)
 
 }
 
-static void pack_tokens_into_partitions_c(VP8_COMP *cpi, unsigned char *cx_data,
-                                          unsigned char * cx_data_end,
-                                          int num_part)
+/* Bool codes the tokens of the rows of partition part, starting w on
+ * [ptr, ptr_end).
+ */
+static void pack_tokens_into_partition(VP8_COMP *cpi, vp8_writer *w,
+                                       unsigned char *ptr,
+                                       unsigned char *ptr_end,
+                                       int part, int num_part)
 {
-
-    int i;
-    unsigned char *ptr = cx_data;
-    unsigned char *ptr_end = cx_data_end;
     unsigned int shift;
-    vp8_writer *w;
-    ptr = cx_data;
 
-    for (i = 0; i < num_part; i++)
+    vp8_start_encode(w, ptr, ptr_end);
     {
-        w = cpi->bc + i + 1;
-        vp8_start_encode(w, ptr, ptr_end);
+        unsigned int split;
+        int count = w->count;
+        unsigned int range = w->range;
+        unsigned int lowvalue = w->lowvalue;
+        int mb_row;
+
+        for (mb_row = part; mb_row < cpi->common.mb_rows; mb_row += num_part)
         {
-            unsigned int split;
-            int count = w->count;
-            unsigned int range = w->range;
-            unsigned int lowvalue = w->lowvalue;
-            int mb_row;
+            TOKENEXTRA *p    = cpi->tplist[mb_row].start;
+            TOKENEXTRA *stop = cpi->tplist[mb_row].stop;
 
-            for (mb_row = i; mb_row < cpi->common.mb_rows; mb_row += num_part)
+            while (p < stop)
             {
-                TOKENEXTRA *p    = cpi->tplist[mb_row].start;
-                TOKENEXTRA *stop = cpi->tplist[mb_row].stop;
+                const int t = p->Token;
+                vp8_token *const a = vp8_coef_encodings + t;
+                const vp8_extra_bit_struct *const b = vp8_extra_bits + t;
+                int i = 0;
+                const unsigned char *pp = p->context_tree;
+                int v = a->value;
+                int n = a->Len;
 
-                while (p < stop)
+                if (p->skip_eob_node)
                 {
-                    const int t = p->Token;
-                    vp8_token *const a = vp8_coef_encodings + t;
-                    const vp8_extra_bit_struct *const b = vp8_extra_bits + t;
-                    int i = 0;
-                    const unsigned char *pp = p->context_tree;
-                    int v = a->value;
-                    int n = a->Len;
+                    n--;
+                    i = 2;
+                }
 
-                    if (p->skip_eob_node)
+                do
+                {
+                    const int bb = (v >> --n) & 1;
+                    split = 1 + (((range - 1) * pp[i>>1]) >> 8);
+                    i = vp8_coef_tree[i+bb];
+
+                    if (bb)
                     {
-                        n--;
-                        i = 2;
+                        lowvalue += split;
+                        range = range - split;
                     }
-
-                    do
+                    else
                     {
-                        const int bb = (v >> --n) & 1;
-                        split = 1 + (((range - 1) * pp[i>>1]) >> 8);
-                        i = vp8_coef_tree[i+bb];
+                        range = split;
+                    }
 
-                        if (bb)
-                        {
-                            lowvalue += split;
-                            range = range - split;
-                        }
-                        else
-                        {
-                            range = split;
-                        }
+                    shift = vp8_norm[range];
+                    range <<= shift;
+                    count += shift;
 
-                        shift = vp8_norm[range];
-                        range <<= shift;
-                        count += shift;
+                    if (count >= 0)
+                    {
+                        int offset = shift - count;
 
-                        if (count >= 0)
+                        if ((lowvalue << (offset - 1)) & 0x80000000)
                         {
-                            int offset = shift - count;
+                            int x = w->pos - 1;
 
-                            if ((lowvalue << (offset - 1)) & 0x80000000)
+                            while (x >= 0 && w->buffer[x] == 0xff)
                             {
-                                int x = w->pos - 1;
-
-                                while (x >= 0 && w->buffer[x] == 0xff)
-                                {
-                                    w->buffer[x] = (unsigned char)0;
-                                    x--;
-                                }
-
-                                w->buffer[x] += 1;
+                                w->buffer[x] = (unsigned char)0;
+                                x--;
                             }
 
-                            validate_buffer(w->buffer + w->pos,
-                                            1,
-                                            cx_data_end,
-                                            &cpi->common.error);
+                            w->buffer[x] += 1;
+                        }
 
-                            w->buffer[w->pos++] = (lowvalue >> (24 - offset));
+                        validate_buffer(w->buffer + w->pos,
+                                        1,
+                                        ptr_end,
+                                        w->error);
 
-                            lowvalue <<= offset;
-                            shift = count;
-                            lowvalue &= 0xffffff;
-                            count -= 8 ;
-                        }
+                        w->buffer[w->pos++] = (lowvalue >> (24 - offset));
 
-                        lowvalue <<= shift;
+                        lowvalue <<= offset;
+                        shift = count;
+                        lowvalue &= 0xffffff;
+                        count -= 8 ;
                     }
-                    while (n);
 
+                    lowvalue <<= shift;
+                }
+                while (n);
+
+
+                if (b->base_val)
+                {
+                    const int e = p->Extra, L = b->Len;
 
-                    if (b->base_val)
+                    if (L)
                     {
-                        const int e = p->Extra, L = b->Len;
+                        const unsigned char *pp = b->prob;
+                        int v = e >> 1;
+                        int n = L;              /* number of bits in v, assumed nonzero */
+                        int i = 0;
 
-                        if (L)
+                        do
                         {
-                            const unsigned char *pp = b->prob;
-                            int v = e >> 1;
-                            int n = L;              /* number of bits in v, assumed nonzero */
-                            int i = 0;
+                            const int bb = (v >> --n) & 1;
+                            split = 1 + (((range - 1) * pp[i>>1]) >> 8);
+                            i = b->tree[i+bb];
 
-                            do
+                            if (bb)
                             {
-                                const int bb = (v >> --n) & 1;
-                                split = 1 + (((range - 1) * pp[i>>1]) >> 8);
-                                i = b->tree[i+bb];
+                                lowvalue += split;
+                                range = range - split;
+                            }
+                            else
+                            {
+                                range = split;
+                            }
 
-                                if (bb)
-                                {
-                                    lowvalue += split;
-                                    range = range - split;
-                                }
-                                else
-                                {
-                                    range = split;
-                                }
+                            shift = vp8_norm[range];
+                            range <<= shift;
+                            count += shift;
 
-                                shift = vp8_norm[range];
-                                range <<= shift;
-                                count += shift;
+                            if (count >= 0)
+                            {
+                                int offset = shift - count;
 
-                                if (count >= 0)
+                                if ((lowvalue << (offset - 1)) & 0x80000000)
                                 {
-                                    int offset = shift - count;
+                                    int x = w->pos - 1;
 
-                                    if ((lowvalue << (offset - 1)) & 0x80000000)
+                                    while (x >= 0 && w->buffer[x] == 0xff)
                                     {
-                                        int x = w->pos - 1;
-
-                                        while (x >= 0 && w->buffer[x] == 0xff)
-                                        {
-                                            w->buffer[x] = (unsigned char)0;
-                                            x--;
-                                        }
-
-                                        w->buffer[x] += 1;
+                                        w->buffer[x] = (unsigned char)0;
+                                        x--;
                                     }
 
-                                    validate_buffer(w->buffer + w->pos,
-                                                    1,
-                                                    cx_data_end,
-                                                    &cpi->common.error);
+                                    w->buffer[x] += 1;
+                                }
 
-                                    w->buffer[w->pos++] =
-                                        (lowvalue >> (24 - offset));
+                                validate_buffer(w->buffer + w->pos,
+                                                1,
+                                                ptr_end,
+                                                w->error);
 
-                                    lowvalue <<= offset;
-                                    shift = count;
-                                    lowvalue &= 0xffffff;
-                                    count -= 8 ;
-                                }
+                                w->buffer[w->pos++] =
+                                    (lowvalue >> (24 - offset));
 
-                                lowvalue <<= shift;
+                                lowvalue <<= offset;
+                                shift = count;
+                                lowvalue &= 0xffffff;
+                                count -= 8 ;
                             }
-                            while (n);
+
+                            lowvalue <<= shift;
                         }
+                        while (n);
+                    }
+
+                    {
+                        split = (range + 1) >> 1;
 
+                        if (e & 1)
+                        {
+                            lowvalue += split;
+                            range = range - split;
+                        }
+                        else
                         {
-                            split = (range + 1) >> 1;
+                            range = split;
+                        }
 
-                            if (e & 1)
-                            {
-                                lowvalue += split;
-                                range = range - split;
-                            }
-                            else
-                            {
-                                range = split;
-                            }
+                        range <<= 1;
 
-                            range <<= 1;
+                        if ((lowvalue & 0x80000000))
+                        {
+                            int x = w->pos - 1;
 
-                            if ((lowvalue & 0x80000000))
+                            while (x >= 0 && w->buffer[x] == 0xff)
                             {
-                                int x = w->pos - 1;
-
-                                while (x >= 0 && w->buffer[x] == 0xff)
-                                {
-                                    w->buffer[x] = (unsigned char)0;
-                                    x--;
-                                }
+                                w->buffer[x] = (unsigned char)0;
+                                x--;
+                            }
 
-                                w->buffer[x] += 1;
+                            w->buffer[x] += 1;
 
-                            }
+                        }
 
-                            lowvalue  <<= 1;
+                        lowvalue  <<= 1;
 
-                            if (!++count)
-                            {
-                                count = -8;
-                                validate_buffer(w->buffer + w->pos,
-                                                1,
-                                                cx_data_end,
-                                                &cpi->common.error);
+                        if (!++count)
+                        {
+                            count = -8;
+                            validate_buffer(w->buffer + w->pos,
+                                            1,
+                                            ptr_end,
+                                            w->error);
 
-                                w->buffer[w->pos++] = (lowvalue >> 24);
+                            w->buffer[w->pos++] = (lowvalue >> 24);
 
-                                lowvalue &= 0xffffff;
-                            }
+                            lowvalue &= 0xffffff;
                         }
-
                     }
 
-                    ++p;
                 }
+
+                ++p;
             }
+        }
 
-            w->count    = count;
-            w->lowvalue = lowvalue;
-            w->range    = range;
+        w->count    = count;
+        w->lowvalue = lowvalue;
+        w->range    = range;
 
-        }
+    }
+
+    vp8_stop_encode(w);
+}
+
+static void pack_tokens_into_partitions_c(VP8_COMP *cpi, unsigned char *cx_data,
+                                          unsigned char * cx_data_end,
+                                          int num_part)
+{
+    int i;
+    unsigned char *ptr = cx_data;
+    vp8_writer *w;
 
-        vp8_stop_encode(w);
+    for (i = 0; i < num_part; i++)
+    {
+        w = cpi->bc + i + 1;
+        pack_tokens_into_partition(cpi, w, ptr, cx_data_end, i, num_part);
         ptr += w->pos;
     }
 }
 
+#if CONFIG_MULTITHREAD
+/* Packs the partitions first, first + step, ... into their shares of
+ * cpi->mt_part_buf. Running out of buffer is reported in error rather
+ * than raised, as the encoding threads have nowhere to return to.
+ */
+void vp8_pack_tokens_into_mt_partitions(VP8_COMP *cpi, int first, int step,
+                                        struct vpx_internal_error_info *error)
+{
+    const int num_part = 1 << cpi->common.multi_token_partition;
+    const unsigned int part_sz = cpi->mt_part_buf_sz / num_part;
+    int i;
+
+    error->error_code = VPX_CODEC_OK;
+
+    if (setjmp(error->jmp))
+    {
+        error->setjmp = 0;
+        return;
+    }
+
+    error->setjmp = 1;
+
+    for (i = first; i < num_part; i += step)
+    {
+        cpi->bc[i + 1].error = error;
+        pack_tokens_into_partition(cpi, cpi->bc + i + 1,
+                                   cpi->mt_part_buf + i * part_sz,
+                                   cpi->mt_part_buf + (i + 1) * part_sz,
+                                   i, num_part);
+    }
+
+    error->setjmp = 0;
+}
+
+/* Packs the partitions on the encoding threads, each into an equal share of
+ * a buffer the size of cx_data, then copies them one after the other to
+ * cx_data. Partitions are made of interleaved rows, so they are close in
+ * size: should one not fit its share anyway, they are packed again
+ * serially.
+ */
+static void pack_tokens_into_partitions_mt(VP8_COMP *cpi,
+                                           unsigned char *cx_data,
+                                           unsigned char *cx_data_end,
+                                           int num_part)
+{
+    VP8_COMMON *const pc = &cpi->common;
+    struct vpx_internal_error_info error;
+    unsigned int buf_sz = cx_data_end - cx_data;
+    unsigned char *ptr = cx_data;
+    int num_threads = cpi->encoding_thread_count;
+    int failed = 0;
+    int i;
+
+    if (num_threads > num_part - 1)
+        num_threads = num_part - 1;
+
+    if (cpi->mt_part_buf_sz < buf_sz)
+    {
+        vpx_free(cpi->mt_part_buf);
+        cpi->mt_part_buf_sz = 0;
+        CHECK_MEM_ERROR(cpi->mt_part_buf, vpx_malloc(buf_sz));
+        cpi->mt_part_buf_sz = buf_sz;
+    }
+
+    cpi->mt_pack_tokens = 1;
+
+    for (i = 0; i < num_threads; i++)
+        sem_post(&cpi->h_event_start_encoding[i]);
+
+    vp8_pack_tokens_into_mt_partitions(cpi, 0, cpi->encoding_thread_count + 1,
+                                       &error);
+
+    for (i = 0; i < num_threads; i++)
+        sem_wait(&cpi->h_event_end_encoding);
+
+    cpi->mt_pack_tokens = 0;
+
+    failed = error.error_code != VPX_CODEC_OK;
+
+    for (i = 0; i < num_threads; i++)
+        failed |= cpi->mb_row_ei[i].pack_error.error_code != VPX_CODEC_OK;
+
+    for (i = 1; i < num_part + 1; i++)
+        cpi->bc[i].error = &pc->error;
+
+    if (failed)
+    {
+        pack_tokens_into_partitions(cpi, cx_data, cx_data_end, num_part);
+        return;
+    }
+
+    for (i = 0; i < num_part; i++)
+    {
+        vp8_writer *w = cpi->bc + i + 1;
+
+        validate_buffer(ptr, w->pos, cx_data_end, &pc->error);
+        vpx_memcpy(ptr, w->buffer, w->pos);
+        ptr += w->pos;
+    }
+}
+#endif
+
 
 static void pack_mb_row_tokens_c(VP8_COMP *cpi, vp8_writer *w)
 {
@@ -1912,8 +2023,14 @@ void vp8_pack_bitstream(VP8_COMP *cpi, unsigned char *dest, unsigned char * dest
             cpi->bc[i].error = &pc->error;
         }
 
-        pack_tokens_into_partitions(cpi, cx_data + 3 * (num_part - 1),
-                                    cx_data_end, num_part);
+#if CONFIG_MULTITHREAD
+        if (cpi->b_multi_threaded)
+            pack_tokens_into_partitions_mt(cpi, cx_data + 3 * (num_part - 1),
+                                           cx_data_end, num_part);
+        else
+#endif
+            pack_tokens_into_partitions(cpi, cx_data + 3 * (num_part - 1),
+                                        cx_data_end, num_part);
 
         for(i = 1; i < num_part; i++)
         {
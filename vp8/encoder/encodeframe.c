@@ -439,12 +439,9 @@ void encode_mb_row(VP8_COMP *cpi,
         {
             if ((mb_col & (nsync - 1)) == 0)
             {
-                while (mb_col > (*last_row_current_mb_col - nsync)
-                        && (*last_row_current_mb_col) != (cm->mb_cols - 1))
-                {
-                    x86_pause_hint();
-                    thread_sleep(0);
-                }
+                vp8_row_sync_wait(&cpi->mt_row_sync, last_row_current_mb_col,
+                                  mb_col + nsync < cm->mb_cols
+                                  ? mb_col + nsync : cm->mb_cols - 1);
             }
         }
 #endif
@@ -548,9 +545,11 @@ void encode_mb_row(VP8_COMP *cpi,
 
         xd->above_context++;
 #if CONFIG_MULTITHREAD
-        if (cpi->b_multi_threaded != 0)
+        // the last MB is posted once the row is extended
+        if ((cpi->b_multi_threaded != 0) && (mb_col != rightmost_col))
         {
-            cpi->mt_current_mb_col[mb_row] = mb_col;
+            vp8_row_sync_post(&cpi->mt_row_sync,
+                              &cpi->mt_current_mb_col[mb_row], mb_col);
         }
 #endif
     }
@@ -562,16 +561,17 @@ void encode_mb_row(VP8_COMP *cpi,
         xd->dst.u_buffer + 8,
         xd->dst.v_buffer + 8);
 
-    // this is to account for the border
-    xd->mode_info_context++;
-    x->partition_info++;
-
 #if CONFIG_MULTITHREAD
-    if ((cpi->b_multi_threaded != 0) && (mb_row == cm->mb_rows - 1))
+    if (cpi->b_multi_threaded != 0)
     {
-        sem_post(&cpi->h_event_end_encoding); /* signal frame encoding end */
+        vp8_row_sync_post(&cpi->mt_row_sync,
+                          &cpi->mt_current_mb_col[mb_row], rightmost_col);
     }
 #endif
+
+    // this is to account for the border
+    xd->mode_info_context++;
+    x->partition_info++;
 }
 
 void init_encode_frame_mb_context(VP8_COMP *cpi)
@@ -769,7 +769,8 @@ void vp8_encode_frame(VP8_COMP *cpi)
 
             }
 
-            sem_wait(&cpi->h_event_end_encoding); /* wait for other threads to finish */
+            for (i = 0; i < cpi->encoding_thread_count; i++)
+                sem_wait(&cpi->h_event_end_encoding); /* wait for other threads to finish */
 
             cpi->tok_count = 0;
 
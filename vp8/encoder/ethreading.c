@@ -12,6 +12,7 @@
 #include "vp8/common/threading.h"
 #include "vp8/common/common.h"
 #include "vp8/common/extend.h"
+#include "firstpass.h"
 
 #if CONFIG_MULTITHREAD
 
@@ -23,6 +24,13 @@ extern int vp8cx_encode_intra_macro_block(VP8_COMP *cpi, MACROBLOCK *x,
 extern void vp8cx_mb_init_quantizer(VP8_COMP *cpi, MACROBLOCK *x, int ok_to_skip);
 extern void vp8_build_block_offsets(MACROBLOCK *x);
 extern void vp8_setup_block_ptrs(MACROBLOCK *x);
+extern void vp8_temporal_filter_mb_row(VP8_COMP *cpi, MACROBLOCK *x,
+                                       int mb_row);
+extern int vp8cx_score_filter_level(VP8_COMP *cpi, YV12_BUFFER_CONFIG *sd,
+                                    YV12_BUFFER_CONFIG *dest, int filt_lvl);
+extern void vp8_pack_tokens_into_mt_partitions(VP8_COMP *cpi, int first,
+                                               int step,
+                                               struct vpx_internal_error_info *error);
 
 extern void loopfilter_frame(VP8_COMP *cpi, VP8_COMMON *cm);
 
@@ -81,6 +89,47 @@ THREAD_FUNCTION thread_encoding_proc(void *p_data)
             if (cpi->b_multi_threaded == 0) // we're shutting down
                 break;
 
+            if (cpi->mt_pack_tokens)
+            {
+                vp8_pack_tokens_into_mt_partitions(cpi, ithread + 1,
+                                                   cpi->encoding_thread_count + 1,
+                                                   &mbri->pack_error);
+
+                sem_post(&cpi->h_event_end_encoding);
+                continue;
+            }
+
+            if (cpi->mt_pick_lf)
+            {
+                mbri->lf_err = vp8cx_score_filter_level(cpi, cpi->Source,
+                                                        &mbri->pick_lf_lvl_frame,
+                                                        mbri->lf_level);
+
+                sem_post(&cpi->h_event_end_encoding);
+                continue;
+            }
+
+#if VP8_TEMPORAL_ALT_REF && !(CONFIG_REALTIME_ONLY)
+            if (cpi->mt_temporal_filter)
+            {
+                for (mb_row = ithread + 1; mb_row < cm->mb_rows; mb_row += (cpi->encoding_thread_count + 1))
+                    vp8_temporal_filter_mb_row(cpi, x, mb_row);
+
+                sem_post(&cpi->h_event_end_encoding);
+                continue;
+            }
+#endif
+
+#if !(CONFIG_REALTIME_ONLY)
+            if (cpi->pass == 1)
+            {
+                for (mb_row = ithread + 1; mb_row < cm->mb_rows; mb_row += (cpi->encoding_thread_count + 1))
+                    vp8_first_pass_mb_row(cpi, x, mb_row, &mbri->fp_stats);
+
+                continue;
+            }
+#endif
+
             for (mb_row = ithread + 1; mb_row < cm->mb_rows; mb_row += (cpi->encoding_thread_count + 1))
             {
 
@@ -119,11 +168,8 @@ THREAD_FUNCTION thread_encoding_proc(void *p_data)
                 {
                     if ((mb_col & (nsync - 1)) == 0)
                     {
-                        while (mb_col > (*last_row_current_mb_col - nsync) && *last_row_current_mb_col != cm->mb_cols - 1)
-                        {
-                            x86_pause_hint();
-                            thread_sleep(0);
-                        }
+                        vp8_row_sync_wait(&cpi->mt_row_sync, last_row_current_mb_col,
+                                          mb_col + nsync < cm->mb_cols ? mb_col + nsync : cm->mb_cols - 1);
                     }
 
                     // Distance of Mb to the various image edges.
@@ -247,7 +293,9 @@ THREAD_FUNCTION thread_encoding_proc(void *p_data)
                     x->partition_info++;
                     xd->above_context++;
 
-                    cpi->mt_current_mb_col[mb_row] = mb_col;
+                    // the last MB is posted once the row is extended
+                    if (mb_col != cm->mb_cols - 1)
+                        vp8_row_sync_post(&cpi->mt_row_sync, &cpi->mt_current_mb_col[mb_row], mb_col);
                 }
 
                 //extend the recon for intra prediction
@@ -257,6 +305,8 @@ THREAD_FUNCTION thread_encoding_proc(void *p_data)
                     xd->dst.u_buffer + 8,
                     xd->dst.v_buffer + 8);
 
+                vp8_row_sync_post(&cpi->mt_row_sync, &cpi->mt_current_mb_col[mb_row], cm->mb_cols - 1);
+
                 // this is to account for the border
                 xd->mode_info_context++;
                 x->partition_info++;
@@ -268,13 +318,11 @@ THREAD_FUNCTION thread_encoding_proc(void *p_data)
                 xd->mode_info_context += xd->mode_info_stride * cpi->encoding_thread_count;
                 x->partition_info += xd->mode_info_stride * cpi->encoding_thread_count;
                 x->gf_active_ptr   += cm->mb_cols * cpi->encoding_thread_count;
-
-                if (mb_row == cm->mb_rows - 1)
-                {
-                    //SetEvent(cpi->h_event_main);
-                    sem_post(&cpi->h_event_end_encoding); /* signal frame encoding end */
-                }
             }
+
+            /* Each thread signals once it is done with all its rows: the
+             * row below a thread's last one can be finished before it. */
+            sem_post(&cpi->h_event_end_encoding); /* signal frame encoding end */
         }
     }
 
@@ -500,11 +548,26 @@ void vp8cx_create_encoder_threads(VP8_COMP *cpi)
         CHECK_MEM_ERROR(cpi->mt_current_mb_col,
                         vpx_malloc(sizeof(*cpi->mt_current_mb_col) * cm->mb_rows));
 
+        if (vp8_row_sync_init(&cpi->mt_row_sync))
+            vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
+                               "Failed to initialize row synchronization");
+
         sem_init(&cpi->h_event_end_encoding, 0, 0);
 
         cpi->b_multi_threaded = 1;
         cpi->encoding_thread_count = th_count;
 
+        /* scratch buffers for the threads to score filter levels on */
+        for (ithread = 0; ithread < th_count; ithread++)
+        {
+            if (vp8_yv12_alloc_frame_buffer(&cpi->mb_row_ei[ithread].pick_lf_lvl_frame,
+                                            cpi->pick_lf_lvl_frame.y_width,
+                                            cpi->pick_lf_lvl_frame.y_height,
+                                            VP8BORDERINPIXELS))
+                vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
+                                   "Failed to allocate filter level buffer");
+        }
+
         /*
         printf("[VP8:] multi_threaded encoding is enabled with %d threads\n\n",
                (cpi->encoding_thread_count +1));
@@ -551,6 +614,7 @@ void vp8cx_remove_encoder_threads(VP8_COMP *cpi)
                 pthread_join(cpi->h_encoding_thread[i], 0);
 
                 sem_destroy(&cpi->h_event_start_encoding[i]);
+                vp8_yv12_de_alloc_frame_buffer(&cpi->mb_row_ei[i].pick_lf_lvl_frame);
             }
 
             sem_post(&cpi->h_event_start_lpf);
@@ -560,6 +624,7 @@ void vp8cx_remove_encoder_threads(VP8_COMP *cpi)
         sem_destroy(&cpi->h_event_end_encoding);
         sem_destroy(&cpi->h_event_end_lpf);
         sem_destroy(&cpi->h_event_start_lpf);
+        vp8_row_sync_destroy(&cpi->mt_row_sync);
 
         //free thread related resources
         vpx_free(cpi->h_event_start_encoding);
@@ -567,6 +632,9 @@ void vp8cx_remove_encoder_threads(VP8_COMP *cpi)
         vpx_free(cpi->mb_row_ei);
         vpx_free(cpi->en_thread_data);
         vpx_free(cpi->mt_current_mb_col);
+        vpx_free(cpi->mt_part_buf);
+        cpi->mt_part_buf = NULL;
+        cpi->mt_part_buf_sz = 0;
     }
 }
 #endif
@@ -36,6 +36,11 @@ extern void vp8_setup_block_ptrs(MACROBLOCK *x);
 extern void vp8cx_frame_init_quantizer(VP8_COMP *cpi);
 extern void vp8_set_mbmode_and_mvs(MACROBLOCK *x, MB_PREDICTION_MODE mb, int_mv *mv);
 extern void vp8_alloc_compressor_data(VP8_COMP *cpi);
+#if CONFIG_MULTITHREAD
+extern void vp8cx_init_mbrthread_data(VP8_COMP *cpi, MACROBLOCK *x,
+                                      MB_ROW_COMP *mbr_ei, int mb_row,
+                                      int count);
+#endif
 
 //#define GFQ_ADJUSTMENT (40 + ((15*Q)/10))
 //#define GFQ_ADJUSTMENT (80 + ((15*Q)/10))
@@ -387,6 +392,36 @@ void vp8_end_first_pass(VP8_COMP *cpi)
     output_stats(cpi, cpi->output_pkt_list, &cpi->twopass.total_stats);
 }
 
+/* Concatenates the first pass stats of consecutive segments of a clip,
+ * each run from its own first frame, and ends them with the total record
+ * of the whole clip. The frame records keep the numbering of their
+ * segment, so the second pass finds the segment starts as the records of
+ * frame 0 past the first one.
+ */
+void vp8_merge_first_pass_stats(FIRSTPASS_STATS *merged,
+                                const FIRSTPASS_STATS *const *segments,
+                                const unsigned int *segment_frames,
+                                int num_segments)
+{
+    FIRSTPASS_STATS total;
+    int i;
+    unsigned int j;
+
+    zero_stats(&total);
+
+    for (i = 0; i < num_segments; i++)
+    {
+        for (j = 0; j < segment_frames[i]; j++)
+        {
+            *merged = segments[i][j];
+            accumulate_stats(&total, merged);
+            merged++;
+        }
+    }
+
+    *merged = total;
+}
+
 static void zz_motion_search( VP8_COMP *cpi, MACROBLOCK * x, YV12_BUFFER_CONFIG * recon_buffer, int * best_motion_err, int recon_yoffset )
 {
     MACROBLOCKD * const xd = & x->e_mbd;
@@ -478,10 +513,14 @@ static void first_pass_motion_search(VP8_COMP *cpi, MACROBLOCK *x,
     }
 }
 
-void vp8_first_pass(VP8_COMP *cpi)
+/* Runs the first pass over the MBs of a row, adding their statistics to
+ * stats. The first and last non-zero MVs of the row are kept, so that the
+ * count of new MVs can be completed across rows once the frame is done.
+ */
+void vp8_first_pass_mb_row(VP8_COMP *cpi, MACROBLOCK *x, int mb_row,
+                           FIRSTPASS_MB_STATS *stats)
 {
-    int mb_row, mb_col;
-    MACROBLOCK *const x = & cpi->mb;
+    int mb_col;
     VP8_COMMON *const cm = & cpi->common;
     MACROBLOCKD *const xd = & x->e_mbd;
 
@@ -491,24 +530,296 @@ void vp8_first_pass(VP8_COMP *cpi)
     YV12_BUFFER_CONFIG *gld_yv12 = &cm->yv12_fb[cm->gld_fb_idx];
     int recon_y_stride = lst_yv12->y_stride;
     int recon_uv_stride = lst_yv12->uv_stride;
-    int64_t intra_error = 0;
-    int64_t coded_error = 0;
-
-    int sum_mvr = 0, sum_mvc = 0;
-    int sum_mvr_abs = 0, sum_mvc_abs = 0;
-    int sum_mvrs = 0, sum_mvcs = 0;
-    int mvcount = 0;
-    int intercount = 0;
-    int second_ref_count = 0;
     int intrapenalty = 256;
-    int neutral_count = 0;
-    int new_mv_count = 0;
-    int sum_in_vectors = 0;
+    int_mv *row_mvs = &cpi->fp_row_mvs[2 * mb_row];
     uint32_t lastmv_as_int = 0;
 
+    int_mv best_ref_mv;
     int_mv zero_ref_mv;
 
+#if CONFIG_MULTITHREAD
+    const int nsync = cpi->mt_sync_range;
+    const int rightmost_col = cm->mb_cols - 1;
+    volatile const int *last_row_current_mb_col;
+
+    if ((cpi->b_multi_threaded != 0) && (mb_row != 0))
+        last_row_current_mb_col = &cpi->mt_current_mb_col[mb_row - 1];
+    else
+        last_row_current_mb_col = &rightmost_col;
+#endif
+
     zero_ref_mv.as_int = 0;
+    best_ref_mv.as_int = 0;
+    row_mvs[0].as_int = 0;
+
+    x->src.y_buffer = cpi->Source->y_buffer + mb_row * 16 * x->src.y_stride;
+    x->src.u_buffer = cpi->Source->u_buffer + mb_row * 8 * x->src.uv_stride;
+    x->src.v_buffer = cpi->Source->v_buffer + mb_row * 8 * x->src.uv_stride;
+
+    // reset above block coeffs
+    xd->up_available = (mb_row != 0);
+    recon_yoffset = (mb_row * recon_y_stride * 16);
+    recon_uvoffset = (mb_row * recon_uv_stride * 8);
+
+    // Set up limit values for motion vectors to prevent them extending outside the UMV borders
+    x->mv_row_min = -((mb_row * 16) + (VP8BORDERINPIXELS - 16));
+    x->mv_row_max = ((cm->mb_rows - 1 - mb_row) * 16) + (VP8BORDERINPIXELS - 16);
+
+
+    // for each macroblock col in image
+    for (mb_col = 0; mb_col < cm->mb_cols; mb_col++)
+    {
+        int this_error;
+        int gf_motion_error = INT_MAX;
+        int use_dc_pred = (mb_col || mb_row) && (!mb_col || !mb_row);
+
+#if CONFIG_MULTITHREAD
+        if ((cpi->b_multi_threaded != 0) && (mb_row != 0))
+        {
+            if ((mb_col & (nsync - 1)) == 0)
+            {
+                vp8_row_sync_wait(&cpi->mt_row_sync, last_row_current_mb_col,
+                                  mb_col + nsync < cm->mb_cols
+                                  ? mb_col + nsync : cm->mb_cols - 1);
+            }
+        }
+#endif
+
+        xd->dst.y_buffer = new_yv12->y_buffer + recon_yoffset;
+        xd->dst.u_buffer = new_yv12->u_buffer + recon_uvoffset;
+        xd->dst.v_buffer = new_yv12->v_buffer + recon_uvoffset;
+        xd->left_available = (mb_col != 0);
+
+        //Copy current mb to a buffer
+        vp8_copy_mem16x16(x->src.y_buffer, x->src.y_stride, x->thismb, 16);
+
+        // do intra 16x16 prediction
+        this_error = vp8_encode_intra(cpi, x, use_dc_pred);
+
+        // "intrapenalty" below deals with situations where the intra and inter error scores are very low (eg a plain black frame)
+        // We do not have special cases in first pass for 0,0 and nearest etc so all inter modes carry an overhead cost estimate fot the mv.
+        // When the error score is very low this causes us to pick all or lots of INTRA modes and throw lots of key frames.
+        // This penalty adds a cost matching that of a 0,0 mv to the intra case.
+        this_error += intrapenalty;
+
+        // Cumulative intra error total
+        stats->intra_error += (int64_t)this_error;
+
+        // Set up limit values for motion vectors to prevent them extending outside the UMV borders
+        x->mv_col_min = -((mb_col * 16) + (VP8BORDERINPIXELS - 16));
+        x->mv_col_max = ((cm->mb_cols - 1 - mb_col) * 16) + (VP8BORDERINPIXELS - 16);
+
+        // Other than for the first frame do a motion search
+        if (cm->current_video_frame > 0)
+        {
+            BLOCKD *d = &x->e_mbd.block[0];
+            MV tmp_mv = {0, 0};
+            int tmp_err;
+            int motion_error = INT_MAX;
+
+            // Simple 0,0 motion with no mv overhead
+            zz_motion_search( cpi, x, lst_yv12, &motion_error, recon_yoffset );
+            d->bmi.mv.as_mv.row = 0;
+            d->bmi.mv.as_mv.col = 0;
+
+            // Test last reference frame using the previous best mv as the
+            // starting point (best reference) for the search
+            first_pass_motion_search(cpi, x, &best_ref_mv,
+                                    &d->bmi.mv.as_mv, lst_yv12,
+                                    &motion_error, recon_yoffset);
+
+            // If the current best reference mv is not centred on 0,0 then do a 0,0 based search as well
+            if (best_ref_mv.as_int)
+            {
+               tmp_err = INT_MAX;
+               first_pass_motion_search(cpi, x, &zero_ref_mv, &tmp_mv,
+                                 lst_yv12, &tmp_err, recon_yoffset);
+
+               if ( tmp_err < motion_error )
+               {
+                    motion_error = tmp_err;
+                    d->bmi.mv.as_mv.row = tmp_mv.row;
+                    d->bmi.mv.as_mv.col = tmp_mv.col;
+               }
+            }
+
+            // Experimental search in a second reference frame ((0,0) based only)
+            if (cm->current_video_frame > 1)
+            {
+                first_pass_motion_search(cpi, x, &zero_ref_mv, &tmp_mv, gld_yv12, &gf_motion_error, recon_yoffset);
+
+                if ((gf_motion_error < motion_error) && (gf_motion_error < this_error))
+                {
+                    stats->second_ref_count++;
+                    //motion_error = gf_motion_error;
+                    //d->bmi.mv.as_mv.row = tmp_mv.row;
+                    //d->bmi.mv.as_mv.col = tmp_mv.col;
+                }
+                /*else
+                {
+                    xd->pre.y_buffer = cm->last_frame.y_buffer + recon_yoffset;
+                    xd->pre.u_buffer = cm->last_frame.u_buffer + recon_uvoffset;
+                    xd->pre.v_buffer = cm->last_frame.v_buffer + recon_uvoffset;
+                }*/
+
+
+                // Reset to last frame as reference buffer
+                xd->pre.y_buffer = lst_yv12->y_buffer + recon_yoffset;
+                xd->pre.u_buffer = lst_yv12->u_buffer + recon_uvoffset;
+                xd->pre.v_buffer = lst_yv12->v_buffer + recon_uvoffset;
+            }
+
+            /* Intra assumed best */
+            best_ref_mv.as_int = 0;
+
+            if (motion_error <= this_error)
+            {
+                // Keep a count of cases where the inter and intra were
+                // very close and very low. This helps with scene cut
+                // detection for example in cropped clips with black bars
+                // at the sides or top and bottom.
+                if( (((this_error-intrapenalty) * 9) <=
+                     (motion_error*10)) &&
+                    (this_error < (2*intrapenalty)) )
+                {
+                    stats->neutral_count++;
+                }
+
+                d->bmi.mv.as_mv.row <<= 3;
+                d->bmi.mv.as_mv.col <<= 3;
+                this_error = motion_error;
+                vp8_set_mbmode_and_mvs(x, NEWMV, &d->bmi.mv);
+                vp8_encode_inter16x16y(x);
+                stats->sum_mvr += d->bmi.mv.as_mv.row;
+                stats->sum_mvr_abs += abs(d->bmi.mv.as_mv.row);
+                stats->sum_mvc += d->bmi.mv.as_mv.col;
+                stats->sum_mvc_abs += abs(d->bmi.mv.as_mv.col);
+                stats->sum_mvrs += d->bmi.mv.as_mv.row * d->bmi.mv.as_mv.row;
+                stats->sum_mvcs += d->bmi.mv.as_mv.col * d->bmi.mv.as_mv.col;
+                stats->intercount++;
+
+                best_ref_mv.as_int = d->bmi.mv.as_int;
+
+                // Was the vector non-zero
+                if (d->bmi.mv.as_int)
+                {
+                    stats->mvcount++;
+
+                    // Was it different from the last non zero vector. The
+                    // first one of the row is checked against the rows
+                    // above in vp8_first_pass().
+                    if (!row_mvs[0].as_int)
+                        row_mvs[0].as_int = d->bmi.mv.as_int;
+                    else if ( d->bmi.mv.as_int != lastmv_as_int )
+                        stats->new_mv_count++;
+                    lastmv_as_int = d->bmi.mv.as_int;
+
+                    // Does the Row vector point inwards or outwards
+                    if (mb_row < cm->mb_rows / 2)
+                    {
+                        if (d->bmi.mv.as_mv.row > 0)
+                            stats->sum_in_vectors--;
+                        else if (d->bmi.mv.as_mv.row < 0)
+                            stats->sum_in_vectors++;
+                    }
+                    else if (mb_row > cm->mb_rows / 2)
+                    {
+                        if (d->bmi.mv.as_mv.row > 0)
+                            stats->sum_in_vectors++;
+                        else if (d->bmi.mv.as_mv.row < 0)
+                            stats->sum_in_vectors--;
+                    }
+
+                    // Does the Row vector point inwards or outwards
+                    if (mb_col < cm->mb_cols / 2)
+                    {
+                        if (d->bmi.mv.as_mv.col > 0)
+                            stats->sum_in_vectors--;
+                        else if (d->bmi.mv.as_mv.col < 0)
+                            stats->sum_in_vectors++;
+                    }
+                    else if (mb_col > cm->mb_cols / 2)
+                    {
+                        if (d->bmi.mv.as_mv.col > 0)
+                            stats->sum_in_vectors++;
+                        else if (d->bmi.mv.as_mv.col < 0)
+                            stats->sum_in_vectors--;
+                    }
+                }
+            }
+        }
+
+        stats->coded_error += (int64_t)this_error;
+
+        // adjust to the next column of macroblocks
+        x->src.y_buffer += 16;
+        x->src.u_buffer += 8;
+        x->src.v_buffer += 8;
+
+        recon_yoffset += 16;
+        recon_uvoffset += 8;
+
+#if CONFIG_MULTITHREAD
+        // the last MB is posted once the row is extended
+        if ((cpi->b_multi_threaded != 0) && (mb_col != rightmost_col))
+        {
+            vp8_row_sync_post(&cpi->mt_row_sync,
+                              &cpi->mt_current_mb_col[mb_row], mb_col);
+        }
+#endif
+    }
+
+    row_mvs[1].as_int = lastmv_as_int;
+
+    //extend the recon for intra prediction
+    vp8_extend_mb_row(new_yv12, xd->dst.y_buffer + 16, xd->dst.u_buffer + 8, xd->dst.v_buffer + 8);
+    vp8_clear_system_state();  //__asm emms;
+
+#if CONFIG_MULTITHREAD
+    if (cpi->b_multi_threaded != 0)
+    {
+        vp8_row_sync_post(&cpi->mt_row_sync,
+                          &cpi->mt_current_mb_col[mb_row], rightmost_col);
+
+        if (mb_row == cm->mb_rows - 1)
+            sem_post(&cpi->h_event_end_encoding); /* signal frame end */
+    }
+#endif
+}
+
+static void accumulate_mb_stats(FIRSTPASS_MB_STATS *stats,
+                                const FIRSTPASS_MB_STATS *part)
+{
+    stats->intra_error      += part->intra_error;
+    stats->coded_error      += part->coded_error;
+    stats->sum_mvr          += part->sum_mvr;
+    stats->sum_mvc          += part->sum_mvc;
+    stats->sum_mvr_abs      += part->sum_mvr_abs;
+    stats->sum_mvc_abs      += part->sum_mvc_abs;
+    stats->sum_mvrs         += part->sum_mvrs;
+    stats->sum_mvcs         += part->sum_mvcs;
+    stats->mvcount          += part->mvcount;
+    stats->intercount       += part->intercount;
+    stats->second_ref_count += part->second_ref_count;
+    stats->neutral_count    += part->neutral_count;
+    stats->new_mv_count     += part->new_mv_count;
+    stats->sum_in_vectors   += part->sum_in_vectors;
+}
+
+void vp8_first_pass(VP8_COMP *cpi)
+{
+    int mb_row;
+    MACROBLOCK *const x = & cpi->mb;
+    VP8_COMMON *const cm = & cpi->common;
+    MACROBLOCKD *const xd = & x->e_mbd;
+
+    YV12_BUFFER_CONFIG *lst_yv12 = &cm->yv12_fb[cm->lst_fb_idx];
+    YV12_BUFFER_CONFIG *new_yv12 = &cm->yv12_fb[cm->new_fb_idx];
+    YV12_BUFFER_CONFIG *gld_yv12 = &cm->yv12_fb[cm->gld_fb_idx];
+    FIRSTPASS_MB_STATS mb_stats;
+    uint32_t lastmv_as_int = 0;
+
+    vpx_memset(&mb_stats, 0, sizeof(mb_stats));
 
     vp8_clear_system_state();  //__asm emms;
 
@@ -519,6 +830,7 @@ void vp8_first_pass(VP8_COMP *cpi)
     x->partition_info = x->pi;
 
     xd->mode_info_context = cm->mi;
+    xd->mode_info_stride = cm->mode_info_stride;
 
     vp8_build_block_offsets(x);
 
@@ -540,209 +852,55 @@ void vp8_first_pass(VP8_COMP *cpi)
         vp8_build_component_cost_table(cpi->mb.mvcost, (const MV_CONTEXT *) cm->fc.mvc, flag);
     }
 
-    // for each macroblock row in image
-    for (mb_row = 0; mb_row < cm->mb_rows; mb_row++)
+#if CONFIG_MULTITHREAD
+    if (cpi->b_multi_threaded)
     {
-        int_mv best_ref_mv;
-
-        best_ref_mv.as_int = 0;
+        int i;
 
-        // reset above block coeffs
-        xd->up_available = (mb_row != 0);
-        recon_yoffset = (mb_row * recon_y_stride * 16);
-        recon_uvoffset = (mb_row * recon_uv_stride * 8);
+        vp8cx_init_mbrthread_data(cpi, x, cpi->mb_row_ei, 1, cpi->encoding_thread_count);
 
-        // Set up limit values for motion vectors to prevent them extending outside the UMV borders
-        x->mv_row_min = -((mb_row * 16) + (VP8BORDERINPIXELS - 16));
-        x->mv_row_max = ((cm->mb_rows - 1 - mb_row) * 16) + (VP8BORDERINPIXELS - 16);
+        for (i = 0; i < cm->mb_rows; i++)
+            cpi->mt_current_mb_col[i] = -1;
 
-
-        // for each macroblock col in image
-        for (mb_col = 0; mb_col < cm->mb_cols; mb_col++)
+        for (i = 0; i < cpi->encoding_thread_count; i++)
         {
-            int this_error;
-            int gf_motion_error = INT_MAX;
-            int use_dc_pred = (mb_col || mb_row) && (!mb_col || !mb_row);
-
-            xd->dst.y_buffer = new_yv12->y_buffer + recon_yoffset;
-            xd->dst.u_buffer = new_yv12->u_buffer + recon_uvoffset;
-            xd->dst.v_buffer = new_yv12->v_buffer + recon_uvoffset;
-            xd->left_available = (mb_col != 0);
-
-            //Copy current mb to a buffer
-            vp8_copy_mem16x16(x->src.y_buffer, x->src.y_stride, x->thismb, 16);
-
-            // do intra 16x16 prediction
-            this_error = vp8_encode_intra(cpi, x, use_dc_pred);
+            MB_ROW_COMP *mbri = &cpi->mb_row_ei[i];
 
-            // "intrapenalty" below deals with situations where the intra and inter error scores are very low (eg a plain black frame)
-            // We do not have special cases in first pass for 0,0 and nearest etc so all inter modes carry an overhead cost estimate fot the mv.
-            // When the error score is very low this causes us to pick all or lots of INTRA modes and throw lots of key frames.
-            // This penalty adds a cost matching that of a 0,0 mv to the intra case.
-            this_error += intrapenalty;
+            // the motion searches cost the vectors as the main thread does
+            vpx_memcpy(mbri->mb.mvsadcosts, x->mvsadcosts, sizeof(x->mvsadcosts));
+            vpx_memset(&mbri->fp_stats, 0, sizeof(mbri->fp_stats));
 
-            // Cumulative intra error total
-            intra_error += (int64_t)this_error;
-
-            // Set up limit values for motion vectors to prevent them extending outside the UMV borders
-            x->mv_col_min = -((mb_col * 16) + (VP8BORDERINPIXELS - 16));
-            x->mv_col_max = ((cm->mb_cols - 1 - mb_col) * 16) + (VP8BORDERINPIXELS - 16);
-
-            // Other than for the first frame do a motion search
-            if (cm->current_video_frame > 0)
-            {
-                BLOCKD *d = &x->e_mbd.block[0];
-                MV tmp_mv = {0, 0};
-                int tmp_err;
-                int motion_error = INT_MAX;
-
-                // Simple 0,0 motion with no mv overhead
-                zz_motion_search( cpi, x, lst_yv12, &motion_error, recon_yoffset );
-                d->bmi.mv.as_mv.row = 0;
-                d->bmi.mv.as_mv.col = 0;
-
-                // Test last reference frame using the previous best mv as the
-                // starting point (best reference) for the search
-                first_pass_motion_search(cpi, x, &best_ref_mv,
-                                        &d->bmi.mv.as_mv, lst_yv12,
-                                        &motion_error, recon_yoffset);
-
-                // If the current best reference mv is not centred on 0,0 then do a 0,0 based search as well
-                if (best_ref_mv.as_int)
-                {
-                   tmp_err = INT_MAX;
-                   first_pass_motion_search(cpi, x, &zero_ref_mv, &tmp_mv,
-                                     lst_yv12, &tmp_err, recon_yoffset);
-
-                   if ( tmp_err < motion_error )
-                   {
-                        motion_error = tmp_err;
-                        d->bmi.mv.as_mv.row = tmp_mv.row;
-                        d->bmi.mv.as_mv.col = tmp_mv.col;
-                   }
-                }
-
-                // Experimental search in a second reference frame ((0,0) based only)
-                if (cm->current_video_frame > 1)
-                {
-                    first_pass_motion_search(cpi, x, &zero_ref_mv, &tmp_mv, gld_yv12, &gf_motion_error, recon_yoffset);
-
-                    if ((gf_motion_error < motion_error) && (gf_motion_error < this_error))
-                    {
-                        second_ref_count++;
-                        //motion_error = gf_motion_error;
-                        //d->bmi.mv.as_mv.row = tmp_mv.row;
-                        //d->bmi.mv.as_mv.col = tmp_mv.col;
-                    }
-                    /*else
-                    {
-                        xd->pre.y_buffer = cm->last_frame.y_buffer + recon_yoffset;
-                        xd->pre.u_buffer = cm->last_frame.u_buffer + recon_uvoffset;
-                        xd->pre.v_buffer = cm->last_frame.v_buffer + recon_uvoffset;
-                    }*/
-
-
-                    // Reset to last frame as reference buffer
-                    xd->pre.y_buffer = lst_yv12->y_buffer + recon_yoffset;
-                    xd->pre.u_buffer = lst_yv12->u_buffer + recon_uvoffset;
-                    xd->pre.v_buffer = lst_yv12->v_buffer + recon_uvoffset;
-                }
-
-                /* Intra assumed best */
-                best_ref_mv.as_int = 0;
+            sem_post(&cpi->h_event_start_encoding[i]);
+        }
 
-                if (motion_error <= this_error)
-                {
-                    // Keep a count of cases where the inter and intra were
-                    // very close and very low. This helps with scene cut
-                    // detection for example in cropped clips with black bars
-                    // at the sides or top and bottom.
-                    if( (((this_error-intrapenalty) * 9) <=
-                         (motion_error*10)) &&
-                        (this_error < (2*intrapenalty)) )
-                    {
-                        neutral_count++;
-                    }
+        for (mb_row = 0; mb_row < cm->mb_rows; mb_row += (cpi->encoding_thread_count + 1))
+            vp8_first_pass_mb_row(cpi, x, mb_row, &mb_stats);
 
-                    d->bmi.mv.as_mv.row <<= 3;
-                    d->bmi.mv.as_mv.col <<= 3;
-                    this_error = motion_error;
-                    vp8_set_mbmode_and_mvs(x, NEWMV, &d->bmi.mv);
-                    vp8_encode_inter16x16y(x);
-                    sum_mvr += d->bmi.mv.as_mv.row;
-                    sum_mvr_abs += abs(d->bmi.mv.as_mv.row);
-                    sum_mvc += d->bmi.mv.as_mv.col;
-                    sum_mvc_abs += abs(d->bmi.mv.as_mv.col);
-                    sum_mvrs += d->bmi.mv.as_mv.row * d->bmi.mv.as_mv.row;
-                    sum_mvcs += d->bmi.mv.as_mv.col * d->bmi.mv.as_mv.col;
-                    intercount++;
-
-                    best_ref_mv.as_int = d->bmi.mv.as_int;
-
-                    // Was the vector non-zero
-                    if (d->bmi.mv.as_int)
-                    {
-                        mvcount++;
-
-                        // Was it different from the last non zero vector
-                        if ( d->bmi.mv.as_int != lastmv_as_int )
-                            new_mv_count++;
-                        lastmv_as_int = d->bmi.mv.as_int;
-
-                        // Does the Row vector point inwards or outwards
-                        if (mb_row < cm->mb_rows / 2)
-                        {
-                            if (d->bmi.mv.as_mv.row > 0)
-                                sum_in_vectors--;
-                            else if (d->bmi.mv.as_mv.row < 0)
-                                sum_in_vectors++;
-                        }
-                        else if (mb_row > cm->mb_rows / 2)
-                        {
-                            if (d->bmi.mv.as_mv.row > 0)
-                                sum_in_vectors++;
-                            else if (d->bmi.mv.as_mv.row < 0)
-                                sum_in_vectors--;
-                        }
-
-                        // Does the Row vector point inwards or outwards
-                        if (mb_col < cm->mb_cols / 2)
-                        {
-                            if (d->bmi.mv.as_mv.col > 0)
-                                sum_in_vectors--;
-                            else if (d->bmi.mv.as_mv.col < 0)
-                                sum_in_vectors++;
-                        }
-                        else if (mb_col > cm->mb_cols / 2)
-                        {
-                            if (d->bmi.mv.as_mv.col > 0)
-                                sum_in_vectors++;
-                            else if (d->bmi.mv.as_mv.col < 0)
-                                sum_in_vectors--;
-                        }
-                    }
-                }
-            }
+        sem_wait(&cpi->h_event_end_encoding); /* wait for other threads to finish */
 
-            coded_error += (int64_t)this_error;
+        for (i = 0; i < cpi->encoding_thread_count; i++)
+            accumulate_mb_stats(&mb_stats, &cpi->mb_row_ei[i].fp_stats);
+    }
+    else
+#endif
+    {
+        // for each macroblock row in image
+        for (mb_row = 0; mb_row < cm->mb_rows; mb_row++)
+            vp8_first_pass_mb_row(cpi, x, mb_row, &mb_stats);
+    }
 
-            // adjust to the next column of macroblocks
-            x->src.y_buffer += 16;
-            x->src.u_buffer += 8;
-            x->src.v_buffer += 8;
+    // Count the first non-zero vector of each row if it differs from the
+    // last one of the rows above
+    for (mb_row = 0; mb_row < cm->mb_rows; mb_row++)
+    {
+        const int_mv *row_mvs = &cpi->fp_row_mvs[2 * mb_row];
 
-            recon_yoffset += 16;
-            recon_uvoffset += 8;
+        if (row_mvs[0].as_int)
+        {
+            if (row_mvs[0].as_int != lastmv_as_int)
+                mb_stats.new_mv_count++;
+            lastmv_as_int = row_mvs[1].as_int;
         }
-
-        // adjust to the next row of mbs
-        x->src.y_buffer += 16 * x->src.y_stride - 16 * cm->mb_cols;
-        x->src.u_buffer += 8 * x->src.uv_stride - 8 * cm->mb_cols;
-        x->src.v_buffer += 8 * x->src.uv_stride - 8 * cm->mb_cols;
-
-        //extend the recon for intra prediction
-        vp8_extend_mb_row(new_yv12, xd->dst.y_buffer + 16, xd->dst.u_buffer + 8, xd->dst.v_buffer + 8);
-        vp8_clear_system_state();  //__asm emms;
     }
 
     vp8_clear_system_state();  //__asm emms;
@@ -752,8 +910,8 @@ void vp8_first_pass(VP8_COMP *cpi)
         FIRSTPASS_STATS fps;
 
         fps.frame      = cm->current_video_frame ;
-        fps.intra_error = intra_error >> 8;
-        fps.coded_error = coded_error >> 8;
+        fps.intra_error = mb_stats.intra_error >> 8;
+        fps.coded_error = mb_stats.coded_error >> 8;
         weight = simple_weight(cpi->Source);
 
 
@@ -774,22 +932,22 @@ void vp8_first_pass(VP8_COMP *cpi)
         fps.new_mv_count = 0.0;
         fps.count      = 1.0;
 
-        fps.pcnt_inter   = 1.0 * (double)intercount / cm->MBs;
-        fps.pcnt_second_ref = 1.0 * (double)second_ref_count / cm->MBs;
-        fps.pcnt_neutral = 1.0 * (double)neutral_count / cm->MBs;
+        fps.pcnt_inter   = 1.0 * (double)mb_stats.intercount / cm->MBs;
+        fps.pcnt_second_ref = 1.0 * (double)mb_stats.second_ref_count / cm->MBs;
+        fps.pcnt_neutral = 1.0 * (double)mb_stats.neutral_count / cm->MBs;
 
-        if (mvcount > 0)
+        if (mb_stats.mvcount > 0)
         {
-            fps.MVr = (double)sum_mvr / (double)mvcount;
-            fps.mvr_abs = (double)sum_mvr_abs / (double)mvcount;
-            fps.MVc = (double)sum_mvc / (double)mvcount;
-            fps.mvc_abs = (double)sum_mvc_abs / (double)mvcount;
-            fps.MVrv = ((double)sum_mvrs - (fps.MVr * fps.MVr / (double)mvcount)) / (double)mvcount;
-            fps.MVcv = ((double)sum_mvcs - (fps.MVc * fps.MVc / (double)mvcount)) / (double)mvcount;
-            fps.mv_in_out_count = (double)sum_in_vectors / (double)(mvcount * 2);
-            fps.new_mv_count = new_mv_count;
+            fps.MVr = (double)mb_stats.sum_mvr / (double)mb_stats.mvcount;
+            fps.mvr_abs = (double)mb_stats.sum_mvr_abs / (double)mb_stats.mvcount;
+            fps.MVc = (double)mb_stats.sum_mvc / (double)mb_stats.mvcount;
+            fps.mvc_abs = (double)mb_stats.sum_mvc_abs / (double)mb_stats.mvcount;
+            fps.MVrv = ((double)mb_stats.sum_mvrs - (fps.MVr * fps.MVr / (double)mb_stats.mvcount)) / (double)mb_stats.mvcount;
+            fps.MVcv = ((double)mb_stats.sum_mvcs - (fps.MVc * fps.MVc / (double)mb_stats.mvcount)) / (double)mb_stats.mvcount;
+            fps.mv_in_out_count = (double)mb_stats.sum_in_vectors / (double)(mb_stats.mvcount * 2);
+            fps.new_mv_count = mb_stats.new_mv_count;
 
-            fps.pcnt_motion = 1.0 * (double)mvcount / cpi->common.MBs;
+            fps.pcnt_motion = 1.0 * (double)mb_stats.mvcount / cpi->common.MBs;
         }
 
         // TODO:  handle the case when duration is set to 0, or something less
@@ -1645,6 +1803,7 @@ static void define_gf_group(VP8_COMP *cpi, FIRSTPASS_STATS *this_frame)
 {
     FIRSTPASS_STATS next_frame;
     FIRSTPASS_STATS *start_pos;
+    FIRSTPASS_STATS *this_frame_pos;    // Record this_frame was read from
     int i;
     double r;
     double boost_score = 0.0;
@@ -1679,6 +1838,7 @@ static void define_gf_group(VP8_COMP *cpi, FIRSTPASS_STATS *this_frame)
     vp8_clear_system_state();  //__asm emms;
 
     start_pos = cpi->twopass.stats_in;
+    this_frame_pos = start_pos - 1;
 
     vpx_memset(&next_frame, 0, sizeof(next_frame)); // assure clean
 
@@ -1772,6 +1932,7 @@ static void define_gf_group(VP8_COMP *cpi, FIRSTPASS_STATS *this_frame)
         }
 
         vpx_memcpy(this_frame, &next_frame, sizeof(*this_frame));
+        this_frame_pos = cpi->twopass.stats_in - 1;
 
         old_boost_score = boost_score;
     }
@@ -1818,6 +1979,8 @@ static void define_gf_group(VP8_COMP *cpi, FIRSTPASS_STATS *this_frame)
             if (EOF == input_stats(cpi, this_frame))
                 break;
 
+            this_frame_pos = cpi->twopass.stats_in - 1;
+
             if (i < cpi->twopass.frames_to_key)
             {
                 mod_frame_err = calculate_modified_err(cpi, this_frame);
@@ -1940,11 +2103,12 @@ static void define_gf_group(VP8_COMP *cpi, FIRSTPASS_STATS *this_frame)
             // We only filter frames that lie within a distance of half
             // the GF interval from the ARF frame. We also have to trap
             // cases where the filter extends beyond the end of clip.
-            // Note: this_frame->frame has been updated in the loop
-            // so it now points at the ARF frame.
+            // Note: this_frame has been updated in the loop so it now
+            // points at the ARF frame. Its frame number restarts in each
+            // segment of merged stats, so count the records after it.
             half_gf_int = cpi->baseline_gf_interval >> 1;
-            frames_after_arf = cpi->twopass.total_stats.count -
-                               this_frame->frame - 1;
+            frames_after_arf = (int)(cpi->twopass.stats_in_end -
+                                     this_frame_pos - 1);
 
             switch (cpi->oxcf.arnr_type)
             {
@@ -2636,6 +2800,10 @@ static void find_next_key_frame(VP8_COMP *cpi, FIRSTPASS_STATS *this_frame)
         vpx_memcpy(&last_frame, this_frame, sizeof(*this_frame));
         input_stats(cpi, this_frame);
 
+        // A segment of merged stats starts with a key frame
+        if (this_frame->frame == 0)
+            break;
+
         // Provided that we are not at the end of the file...
         if (cpi->oxcf.auto_key
             && lookup_next_frame_stats(cpi, &next_frame) != EOF)
@@ -14,7 +14,13 @@
 
 extern void vp8_init_first_pass(VP8_COMP *cpi);
 extern void vp8_first_pass(VP8_COMP *cpi);
+extern void vp8_first_pass_mb_row(VP8_COMP *cpi, MACROBLOCK *x, int mb_row,
+                                  FIRSTPASS_MB_STATS *stats);
 extern void vp8_end_first_pass(VP8_COMP *cpi);
+extern void vp8_merge_first_pass_stats(FIRSTPASS_STATS *merged,
+                                       const FIRSTPASS_STATS *const *segments,
+                                       const unsigned int *segment_frames,
+                                       int num_segments);
 
 extern void vp8_init_second_pass(VP8_COMP *cpi);
 extern void vp8_second_pass(VP8_COMP *cpi);
@@ -328,6 +328,9 @@ static void dealloc_compressor_data(VP8_COMP *cpi)
     vpx_free(cpi->tplist);
     cpi->tplist = NULL;
 
+    vpx_free(cpi->fp_row_mvs);
+    cpi->fp_row_mvs = NULL;
+
     // Delete last frame MV storage buffers
     vpx_free(cpi->lfmv);
     cpi->lfmv = 0;
@@ -1087,6 +1090,18 @@ void vp8_alloc_compressor_data(VP8_COMP *cpi)
         vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
                            "Failed to allocate last frame buffer");
 
+#if CONFIG_MULTITHREAD
+    {
+        int i;
+
+        for (i = 0; i < cpi->encoding_thread_count; i++)
+            if (vp8_yv12_alloc_frame_buffer(&cpi->mb_row_ei[i].pick_lf_lvl_frame,
+                                            width, height, VP8BORDERINPIXELS))
+                vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
+                                   "Failed to allocate filter level buffer");
+    }
+#endif
+
     if (vp8_yv12_alloc_frame_buffer(&cpi->scaled_source,
                                     width, height, VP8BORDERINPIXELS))
         vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
@@ -1137,6 +1152,10 @@ void vp8_alloc_compressor_data(VP8_COMP *cpi)
     vpx_free(cpi->tplist);
 
     CHECK_MEM_ERROR(cpi->tplist, vpx_malloc(sizeof(TOKENLIST) * cpi->common.mb_rows));
+
+    vpx_free(cpi->fp_row_mvs);
+
+    CHECK_MEM_ERROR(cpi->fp_row_mvs, vpx_malloc(sizeof(int_mv) * 2 * cpi->common.mb_rows));
 }
 
 
@@ -2139,6 +2158,15 @@ void vp8_remove_compressor(VP8_COMP **ptr)
                 }
             }
 
+            if (cpi->temporal_filter_count)
+            {
+                fprintf(f, "ARNRFrm\tTime(us)\tPerFrm(us)\n");
+                fprintf(f, "%7u\t%8u\t%10.0f\n", cpi->temporal_filter_count,
+                        cpi->time_temporal_filter,
+                        (double)cpi->time_temporal_filter /
+                            cpi->temporal_filter_count);
+            }
+
             fclose(f);
 #if 0
             f = fopen("qskip.stt", "a");
@@ -2273,6 +2301,7 @@ void vp8_remove_compressor(VP8_COMP **ptr)
 #if 0
         {
             printf("\n_pick_loop_filter_level:%d\n", cpi->time_pick_lpf / 1000);
+            printf("\n_temporal_filter:%d\n", cpi->time_temporal_filter / 1000);
             printf("\n_frames recive_data encod_mb_row compress_frame  Total\n");
             printf("%6d %10ld %10ld %10ld %10ld\n", cpi->common.current_video_frame, cpi->time_receive_data / 1000, cpi->time_encode_mb_row / 1000, cpi->time_compress_data / 1000, (cpi->time_receive_data + cpi->time_compress_data) / 1000);
         }
@@ -4633,8 +4662,14 @@ int vp8_get_compressed_data(VP8_COMP *cpi, unsigned int *frame_flags, unsigned l
             cpi->alt_ref_source = cpi->source;
             if (cpi->oxcf.arnr_max_frames > 0)
             {
+                struct vpx_usec_timer timer;
+
+                vpx_usec_timer_start(&timer);
                 vp8_temporal_filter_prepare_c(cpi,
                                               cpi->frames_till_gf_update_due);
+                vpx_usec_timer_mark(&timer);
+                cpi->time_temporal_filter += vpx_usec_timer_elapsed(&timer);
+                cpi->temporal_filter_count++;
                 force_src_buffer = &cpi->alt_ref_buffer;
             }
             cm->frames_till_alt_ref_frame = cpi->frames_till_gf_update_due;
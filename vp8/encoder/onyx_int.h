@@ -23,6 +23,7 @@
 #include "quantize.h"
 #include "vp8/common/entropy.h"
 #include "vp8/common/threading.h"
+#include "vp8/common/rowsync.h"
 #include "vpx_ports/mem.h"
 #include "vpx/internal/vpx_codec_internal.h"
 #include "mcomp.h"
@@ -194,11 +195,32 @@ typedef struct
 
 } SPEED_FEATURES;
 
+// Sums of the first pass statistics of the MBs of some rows
+typedef struct
+{
+    int64_t intra_error;
+    int64_t coded_error;
+    int sum_mvr, sum_mvc;
+    int sum_mvr_abs, sum_mvc_abs;
+    int sum_mvrs, sum_mvcs;
+    int mvcount;
+    int intercount;
+    int second_ref_count;
+    int neutral_count;
+    int new_mv_count;
+    int sum_in_vectors;
+} FIRSTPASS_MB_STATS;
+
 typedef struct
 {
     MACROBLOCK  mb;
     int segment_counts[MAX_MB_SEGMENTS];
     int totalrate;
+    FIRSTPASS_MB_STATS fp_stats;    // of the rows of this thread, in pass 1
+    YV12_BUFFER_CONFIG pick_lf_lvl_frame;
+    int lf_level;                   // filter level this thread scores
+    int lf_err;                     // and its error
+    struct vpx_internal_error_info pack_error;  // of its token partitions
 } MB_ROW_COMP;
 
 typedef struct
@@ -523,9 +545,15 @@ typedef struct VP8_COMP
 #if CONFIG_MULTITHREAD
     // multithread data
     int * mt_current_mb_col;
+    VP8_ROW_SYNC mt_row_sync;
     int mt_sync_range;
     int b_multi_threaded;
     int encoding_thread_count;
+    int mt_temporal_filter;     // threads filter the alt ref, not encode
+    int mt_pick_lf;             // threads score filter levels, not encode
+    int mt_pack_tokens;         // threads pack token partitions, not encode
+    unsigned char *mt_part_buf; // the token partitions they pack into
+    unsigned int mt_part_buf_sz;
 
     pthread_t *h_encoding_thread;
     pthread_t h_filter_thread;
@@ -542,6 +570,7 @@ typedef struct VP8_COMP
 #endif
 
     TOKENLIST *tplist;
+    int_mv *fp_row_mvs;     // first and last non-zero pass 1 MV of each MB row
     unsigned int partition_sz[MAX_PARTITIONS];
     // end of multithread data
 
@@ -554,6 +583,8 @@ typedef struct VP8_COMP
     unsigned int time_receive_data;
     unsigned int time_compress_data;
     unsigned int time_pick_lpf;
+    unsigned int time_temporal_filter;
+    unsigned int temporal_filter_count;
     unsigned int time_encode_mb_row;
 
     int base_skip_false_prob[128];
@@ -606,6 +637,9 @@ typedef struct VP8_COMP
     YV12_BUFFER_CONFIG alt_ref_buffer;
     YV12_BUFFER_CONFIG *frames[MAX_LAG_BUFFERS];
     int fixed_divide[512];
+    int arnr_frame_count;       // frames, alt ref and strength of the filter
+    int arnr_alt_ref_index;
+    int arnr_filter_strength;
 #endif
 
 #if CONFIG_INTERNAL_STATS
@@ -258,6 +258,82 @@ void vp8cx_set_alt_lf_level(VP8_COMP *cpi, int filt_val)
     mbd->segment_feature_data[MB_LVL_ALT_LF][3] = cpi->segment_feature_data[MB_LVL_ALT_LF][3];
 }
 
+/* Filters a copy of the Y plane of the recon buffer at filt_lvl into dest
+ * and returns its squared error against sd. Nothing but dest is written, so
+ * several levels can be scored at once on different buffers.
+ */
+int vp8cx_score_filter_level(VP8_COMP *cpi, YV12_BUFFER_CONFIG *sd,
+                             YV12_BUFFER_CONFIG *dest, int filt_lvl)
+{
+    VP8_COMMON *cm = &cpi->common;
+    unsigned char lvl[4][4][4];
+
+    vp8_yv12_copy_y_ptr(cm->frame_to_show, dest);
+    vp8_loop_filter_lvl_init(lvl, &cpi->mb.e_mbd, filt_lvl);
+    vp8_loop_filter_yonly(cm, dest, lvl);
+
+    return vp8_calc_ss_err(sd, dest);
+}
+
+/* Adds filt_lvl to the levels of a round unless it is scored already. */
+static int add_filter_level(int *levels, int num_levels, int filt_lvl,
+                            const int *ss_err)
+{
+    int i;
+
+    if (ss_err[filt_lvl])
+        return num_levels;
+
+    for (i = 0; i < num_levels; i++)
+        if (levels[i] == filt_lvl)
+            return num_levels;
+
+    levels[num_levels] = filt_lvl;
+    return num_levels + 1;
+}
+
+/* Scores the levels of a round into ss_err. With encoding threads, the
+ * threads score all but the first level, each on a buffer of its own.
+ */
+static void score_filter_levels(VP8_COMP *cpi, YV12_BUFFER_CONFIG *sd,
+                                const int *levels, int num_levels,
+                                int *ss_err)
+{
+    int i;
+
+#if CONFIG_MULTITHREAD
+    if (cpi->b_multi_threaded && num_levels > 1)
+    {
+        for (i = 1; i < num_levels; i++)
+            cpi->mb_row_ei[i - 1].lf_level = levels[i];
+
+        cpi->mt_pick_lf = 1;
+
+        for (i = 1; i < num_levels; i++)
+            sem_post(&cpi->h_event_start_encoding[i - 1]);
+
+        ss_err[levels[0]] = vp8cx_score_filter_level(cpi, sd,
+                                                     &cpi->pick_lf_lvl_frame,
+                                                     levels[0]);
+
+        for (i = 1; i < num_levels; i++)
+            sem_wait(&cpi->h_event_end_encoding);
+
+        cpi->mt_pick_lf = 0;
+
+        for (i = 1; i < num_levels; i++)
+            ss_err[levels[i]] = cpi->mb_row_ei[i - 1].lf_err;
+
+        return;
+    }
+#endif
+
+    for (i = 0; i < num_levels; i++)
+        ss_err[levels[i]] = vp8cx_score_filter_level(cpi, sd,
+                                                     &cpi->pick_lf_lvl_frame,
+                                                     levels[i]);
+}
+
 void vp8cx_pick_filter_level(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
 {
     VP8_COMMON *cm = &cpi->common;
@@ -278,18 +354,34 @@ void vp8cx_pick_filter_level(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
 
     int ss_err[MAX_LOOP_FILTER + 1];
 
-    YV12_BUFFER_CONFIG * saved_frame = cm->frame_to_show;
+    /* Levels scored together, and how many of them there may be. Each round
+     * holds the levels the search needs next, and with encoding threads,
+     * the levels it may need in the round after, which cost no extra time.
+     */
+    int levels[8];
+    int num_levels;
+    int max_levels = 1;
 
-    vpx_memset(ss_err, 0, sizeof(ss_err));
+#if CONFIG_MULTITHREAD
+    if (cpi->b_multi_threaded)
+        max_levels = cpi->encoding_thread_count + 1;
+#endif
 
-    /* Replace unfiltered frame buffer with a new one */
-    cm->frame_to_show = &cpi->pick_lf_lvl_frame;
+    vpx_memset(ss_err, 0, sizeof(ss_err));
 
     if (cm->frame_type == KEY_FRAME)
         cm->sharpness_level = 0;
     else
         cm->sharpness_level = cpi->oxcf.Sharpness;
 
+    if (cm->sharpness_level != cm->last_sharpness_level)
+    {
+        vp8_loop_filter_update_sharpness(&cm->lf_info, cm->sharpness_level);
+        cm->last_sharpness_level = cm->sharpness_level;
+    }
+
+    vp8cx_set_alt_lf_level(cpi, cm->filter_level);
+
     // Start the search at the previous frame filter level unless it is now out of range.
     filt_mid = cm->filter_level;
 
@@ -301,17 +393,21 @@ void vp8cx_pick_filter_level(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
     // Define the initial step size
     filter_step = (filt_mid < 16) ? 4 : filt_mid / 4;
 
-    // Get baseline error score
+    // Get baseline error score, and ahead of time the first low and high
+    num_levels = add_filter_level(levels, 0, filt_mid, ss_err);
 
-    /* Copy the unfiltered / processed recon buffer to the new buffer */
-    vp8_yv12_copy_y_ptr(saved_frame, cm->frame_to_show);
+    filt_high = ((filt_mid + filter_step) > max_filter_level) ? max_filter_level : (filt_mid + filter_step);
+    filt_low = ((filt_mid - filter_step) < min_filter_level) ? min_filter_level : (filt_mid - filter_step);
 
-    vp8cx_set_alt_lf_level(cpi, filt_mid);
-    vp8_loop_filter_frame_yonly(cm, &cpi->mb.e_mbd, filt_mid);
+    if (num_levels < max_levels)
+        num_levels = add_filter_level(levels, num_levels, filt_low, ss_err);
 
-    best_err = vp8_calc_ss_err(sd, cm->frame_to_show);
+    if (num_levels < max_levels)
+        num_levels = add_filter_level(levels, num_levels, filt_high, ss_err);
 
-    ss_err[filt_mid] = best_err;
+    score_filter_levels(cpi, sd, levels, num_levels, ss_err);
+
+    best_err = ss_err[filt_mid];
 
     filt_best = filt_mid;
 
@@ -326,20 +422,42 @@ void vp8cx_pick_filter_level(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
         filt_high = ((filt_mid + filter_step) > max_filter_level) ? max_filter_level : (filt_mid + filter_step);
         filt_low = ((filt_mid - filter_step) < min_filter_level) ? min_filter_level : (filt_mid - filter_step);
 
+        // Score the low and high levels needed by this step, if not already
+        num_levels = 0;
+
         if ((filt_direction <= 0) && (filt_low != filt_mid))
+            num_levels = add_filter_level(levels, num_levels, filt_low, ss_err);
+
+        if ((filt_direction >= 0) && (filt_high != filt_mid))
+            num_levels = add_filter_level(levels, num_levels, filt_high, ss_err);
+
+        // and on spare threads, those of the steps that may follow
+        if (num_levels > 0 && num_levels < max_levels && filter_step / 2 > 0)
         {
-            if(ss_err[filt_low] == 0)
+            int half_step = filter_step / 2;
+            int spec[4];
+            int i;
+
+            spec[0] = filt_mid - half_step;
+            spec[1] = filt_mid + half_step;
+            spec[2] = filt_low - filter_step;
+            spec[3] = filt_high + filter_step;
+
+            for (i = 0; i < 4 && num_levels < max_levels; i++)
             {
-                // Get Low filter error score
-                vp8_yv12_copy_y_ptr(saved_frame, cm->frame_to_show);
-                vp8cx_set_alt_lf_level(cpi, filt_low);
-                vp8_loop_filter_frame_yonly(cm, &cpi->mb.e_mbd, filt_low);
+                int lvl = spec[i] < min_filter_level ? min_filter_level :
+                          spec[i] > max_filter_level ? max_filter_level : spec[i];
 
-                filt_err = vp8_calc_ss_err(sd, cm->frame_to_show);
-                ss_err[filt_low] = filt_err;
+                num_levels = add_filter_level(levels, num_levels, lvl, ss_err);
             }
-            else
-                filt_err = ss_err[filt_low];
+        }
+
+        if (num_levels)
+            score_filter_levels(cpi, sd, levels, num_levels, ss_err);
+
+        if ((filt_direction <= 0) && (filt_low != filt_mid))
+        {
+            filt_err = ss_err[filt_low];
 
             // If value is close to the best so far then bias towards a lower loop filter value.
             if ((filt_err - Bias) < best_err)
@@ -355,17 +473,7 @@ void vp8cx_pick_filter_level(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
         // Now look at filt_high
         if ((filt_direction >= 0) && (filt_high != filt_mid))
         {
-            if(ss_err[filt_high] == 0)
-            {
-                vp8_yv12_copy_y_ptr(saved_frame, cm->frame_to_show);
-                vp8cx_set_alt_lf_level(cpi, filt_high);
-                vp8_loop_filter_frame_yonly(cm, &cpi->mb.e_mbd, filt_high);
-
-                filt_err = vp8_calc_ss_err(sd, cm->frame_to_show);
-                ss_err[filt_high] = filt_err;
-            }
-            else
-                filt_err = ss_err[filt_high];
+            filt_err = ss_err[filt_high];
 
             // Was it better than the previous best?
             if (filt_err < (best_err - Bias))
@@ -389,7 +497,4 @@ void vp8cx_pick_filter_level(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
     }
 
     cm->filter_level = filt_best;
-
-    /* restore unfiltered frame pointer */
-    cm->frame_to_show = saved_frame;
 }
@@ -1258,6 +1258,78 @@ static vpx_codec_enc_cfg_map_t vp8e_usage_cfg_map[] =
 };
 
 
+vpx_codec_err_t vpx_codec_vp8_cx_merge_stats(vpx_fixed_buf_t *merged,
+                                             const vpx_fixed_buf_t *segments,
+                                             unsigned int *segment_frames,
+                                             unsigned int num_segments)
+{
+#if !(CONFIG_REALTIME_ONLY)
+    size_t                  packet_sz = sizeof(FIRSTPASS_STATS);
+    const FIRSTPASS_STATS **stats;
+    unsigned int           *frames;
+    size_t                  sz = packet_sz;
+    unsigned int            i;
+
+    if (!merged || !segments || !num_segments)
+        return VPX_CODEC_INVALID_PARAM;
+
+    /* Each segment must hold its frame records and their total record */
+    for (i = 0; i < num_segments; i++)
+    {
+        const FIRSTPASS_STATS *total;
+        size_t n_packets = segments[i].sz / packet_sz;
+
+        if (!segments[i].buf || segments[i].sz % packet_sz || n_packets < 2)
+            return VPX_CODEC_INVALID_PARAM;
+
+        total = (const FIRSTPASS_STATS *)segments[i].buf + n_packets - 1;
+
+        if ((size_t)(total->count + 0.5) != n_packets - 1)
+            return VPX_CODEC_INVALID_PARAM;
+
+        sz += segments[i].sz - packet_sz;
+    }
+
+    if (!merged->buf)
+    {
+        merged->sz = sz;
+        return VPX_CODEC_OK;
+    }
+
+    if (merged->sz < sz)
+        return VPX_CODEC_INVALID_PARAM;
+
+    stats = calloc(num_segments, sizeof(*stats));
+    frames = calloc(num_segments, sizeof(*frames));
+
+    if (!stats || !frames)
+    {
+        free(stats);
+        free(frames);
+        return VPX_CODEC_MEM_ERROR;
+    }
+
+    for (i = 0; i < num_segments; i++)
+    {
+        stats[i] = segments[i].buf;
+        frames[i] = (unsigned int)(segments[i].sz / packet_sz - 1);
+
+        if (segment_frames)
+            segment_frames[i] = frames[i];
+    }
+
+    vp8_merge_first_pass_stats(merged->buf, stats, frames, num_segments);
+    merged->sz = sz;
+
+    free(stats);
+    free(frames);
+    return VPX_CODEC_OK;
+#else
+    return VPX_CODEC_INCAPABLE;
+#endif
+}
+
+
 #ifndef VERSION_STRING
 #define VERSION_STRING
 #endif
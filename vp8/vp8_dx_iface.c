@@ -14,9 +14,11 @@
 #include "vpx/vpx_decoder.h"
 #include "vpx/vp8dx.h"
 #include "vpx/internal/vpx_codec_internal.h"
+#include "vpx_mem/vpx_mem.h"
 #include "vpx_version.h"
 #include "common/onyxd.h"
 #include "decoder/onyxd_int.h"
+#include "common/systemdependent.h"
 
 #if CONFIG_OPENCL
 #include "common/opencl/vp8_opencl.h"
@@ -25,6 +27,10 @@
 #define VP8_CAP_POSTPROC (CONFIG_POSTPROC ? VPX_CODEC_CAP_POSTPROC : 0)
 #define VP8_CAP_ERROR_CONCEALMENT (CONFIG_ERROR_CONCEALMENT ? \
                                     VPX_CODEC_CAP_ERROR_CONCEALMENT : 0)
+#define VP8_CAP_FRAME_THREADING (CONFIG_MULTITHREAD ? \
+                                  VPX_CODEC_CAP_FRAME_THREADING : 0)
+#define VP8_CAP_THREAD_POOL (CONFIG_MULTITHREAD ? \
+                              VPX_CODEC_CAP_THREAD_POOL : 0)
 
 typedef vpx_codec_stream_info_t  vp8_stream_info_t;
 
@@ -64,6 +70,10 @@ struct vpx_codec_alg_priv
     struct VP8D_COMP       *pbi;
     int                     postproc_cfg_set;
     vp8_postproc_cfg_t      postproc_cfg;
+    int                     fast_seek;
+    int                     reduced_resolution;
+    int                     stats_enabled;
+    int                     frame_passes;
 #if CONFIG_POSTPROC_VISUALIZER
     unsigned int            dbg_postproc_flag;
     int                     dbg_color_ref_frame_flag;
@@ -74,6 +84,9 @@ struct vpx_codec_alg_priv
     vpx_image_t             img;
     int                     img_setup;
     int                     img_avail;
+    vpx_image_t             slice_img;
+    void                   *slice_user_priv;
+    unsigned int            slice_rows_put;  /* of the frame being decoded */
 };
 
 static unsigned long vp8_priv_sz(const vpx_codec_dec_cfg_t *si, vpx_codec_flags_t flags)
@@ -347,6 +360,77 @@ static void yuvconfig2image(vpx_image_t               *img,
     img->self_allocd = 0;
 }
 
+/* Returns the priv of the application's frame buffer holding the image. */
+static void *frame_buffer_priv(VP8D_COMP                 *pbi,
+                               const YV12_BUFFER_CONFIG  *yv12)
+{
+    int i;
+
+    for (i = 0; i < NUM_YV12_BUFFERS; i++)
+        if (pbi->ext_fb[i].data &&
+            pbi->common.yv12_fb[i].y_buffer == yv12->y_buffer)
+            return pbi->ext_fb[i].priv;
+
+    return NULL;
+}
+
+/* Passes the rows of img from the first one not put yet up to row_end to
+ * the put_slice callback.
+ */
+static void put_slice(vpx_codec_alg_priv_t *ctx, const vpx_image_t *img,
+                      unsigned int row_end)
+{
+    vpx_image_rect_t valid, update;
+
+    if (row_end <= ctx->slice_rows_put)
+        return;
+
+    valid.x = 0;
+    valid.y = 0;
+    valid.w = img->d_w;
+    valid.h = row_end;
+    update = valid;
+    update.y = ctx->slice_rows_put;
+    update.h = row_end - ctx->slice_rows_put;
+
+    ctx->slice_rows_put = row_end;
+    ctx->base.dec.put_slice_cb.u.put_slice(ctx->base.dec.put_slice_cb.user_priv,
+                                           img, &valid, &update);
+}
+
+/* Called by the decoder as rows of the frame to show become final */
+static void put_decoded_rows(void *priv, const YV12_BUFFER_CONFIG *frame,
+                             int row_start, int row_end)
+{
+    vpx_codec_alg_priv_t *ctx = (vpx_codec_alg_priv_t *)priv;
+
+    if (row_start == 0)
+        ctx->slice_rows_put = 0;
+
+    yuvconfig2image(&ctx->slice_img, frame, ctx->slice_user_priv);
+    ctx->slice_img.fb_priv = frame_buffer_priv(ctx->pbi, frame);
+    put_slice(ctx, &ctx->slice_img, row_end);
+}
+
+/* Whether frames are decoded in parallel: once the decoder is created,
+ * whether it started frame threading, before that, whether it will.
+ */
+static int frame_threading_active(vpx_codec_alg_priv_t *ctx)
+{
+#if CONFIG_MULTITHREAD
+    if (ctx->pbi)
+        return ctx->pbi->frame_threads > 0;
+
+    return (ctx->base.init_flags & VPX_CODEC_USE_FRAME_THREADING)
+           && ctx->cfg.threads > 1
+           && !(ctx->base.init_flags & (VPX_CODEC_USE_ERROR_CONCEALMENT |
+                                        VPX_CODEC_USE_INPUT_FRAGMENTS))
+           && !ctx->base.dec.get_fb_cb;
+#else
+    return 0;
+#endif
+}
+
 static vpx_codec_err_t vp8_decode(vpx_codec_alg_priv_t  *ctx,
                                   const uint8_t         *data,
                                   unsigned int            data_sz,
@@ -357,6 +441,16 @@ static vpx_codec_err_t vp8_decode(vpx_codec_alg_priv_t  *ctx,
 
     ctx->img_avail = 0;
 
+    /* Frame-parallel decoders are flushed with no data. When frame
+     * threading is not running, that is not a lost frame, and there is
+     * nothing to flush.
+     */
+    if (!data && !data_sz
+        && (ctx->base.init_flags & VPX_CODEC_USE_FRAME_THREADING)
+        && !(ctx->base.init_flags & VPX_CODEC_USE_INPUT_FRAGMENTS)
+        && !frame_threading_active(ctx))
+        return VPX_CODEC_OK;
+
     /* Determine the stream parameters. Note that we rely on peek_si to
      * validate that we have a buffer that does not wrap around the top
      * of the heap.
@@ -415,6 +509,13 @@ static vpx_codec_err_t vp8_decode(vpx_codec_alg_priv_t  *ctx,
                     (ctx->base.init_flags & VPX_CODEC_USE_ERROR_CONCEALMENT);
             oxcf.input_fragments =
                     (ctx->base.init_flags & VPX_CODEC_USE_INPUT_FRAGMENTS);
+            oxcf.frame_threading =
+                    (ctx->base.init_flags & VPX_CODEC_USE_FRAME_THREADING);
+            oxcf.thread_pool =
+                    (ctx->base.init_flags & VPX_CODEC_USE_THREAD_POOL);
+            oxcf.get_fb_cb = ctx->base.dec.get_fb_cb;
+            oxcf.release_fb_cb = ctx->base.dec.release_fb_cb;
+            oxcf.fb_cb_priv = ctx->base.dec.fb_cb_priv;
 
             optr = vp8dx_create_decompressor(&oxcf);
 
@@ -466,22 +567,238 @@ static vpx_codec_err_t vp8_decode(vpx_codec_alg_priv_t  *ctx,
 #endif
         }
 
+#if CONFIG_MULTITHREAD
+        /* Frames decoded in parallel are postprocessed as they complete,
+         * and output up to a few calls later, with their own user_priv.
+         */
+        ctx->pbi->ft_ppflags = flags;
+        ctx->pbi->ft_user_priv = user_priv;
+#endif
+
+        ctx->pbi->skip_nonref_frames =
+            (ctx->fast_seek & VP8_SEEK_SKIP_NONREF) != 0;
+        ctx->pbi->skip_loop_filter =
+            (ctx->fast_seek & VP8_SEEK_SKIP_LOOPFILTER) != 0;
+        ctx->pbi->rr_scale_req = ctx->reduced_resolution;
+        ctx->pbi->stats_enabled = ctx->stats_enabled;
+        ctx->pbi->frame_passes = ctx->frame_passes;
+
+        /* Slices are put as the decoder finishes rows, unless frames are
+         * postprocessed or decoded in parallel, in which case they are put
+         * whole once output, every frame output by the call.
+         */
+        ctx->pbi->put_rows = NULL;
+        if (ctx->base.dec.put_slice_cb.u.put_slice && !ctx->fast_seek
+            && !(ctx->base.init_flags & VPX_CODEC_USE_FRAME_THREADING)
+            && !flags.post_proc_flag)
+        {
+            ctx->pbi->put_rows = put_decoded_rows;
+            ctx->pbi->put_rows_priv = ctx;
+            ctx->slice_user_priv = user_priv;
+        }
+
         if (vp8dx_receive_compressed_data(ctx->pbi, data_sz, data, deadline))
         {
             VP8D_COMP *pbi = (VP8D_COMP *)ctx->pbi;
             res = update_error_state(ctx, &pbi->common.error);
+            ctx->slice_rows_put = 0;
         }
 
-        if (!res && 0 == vp8dx_get_raw_frame(ctx->pbi, &sd, &time_stamp, &time_end_stamp, &flags))
+        /* Frames decoded to seek are not output, nor postprocessed. */
+        if (!res && !ctx->fast_seek
+            && 0 == vp8dx_get_raw_frame(ctx->pbi, &sd, &time_stamp, &time_end_stamp, &flags))
         {
+#if CONFIG_MULTITHREAD
+            if (ctx->pbi->frame_threads)
+                user_priv = ctx->pbi->ft_out_user_priv;
+#endif
             yuvconfig2image(&ctx->img, &sd, user_priv);
+            ctx->img.fb_priv = frame_buffer_priv(ctx->pbi, &sd);
             ctx->img_avail = 1;
+
+            if (ctx->base.dec.put_slice_cb.u.put_slice)
+            {
+                put_slice(ctx, &ctx->img, ctx->img.d_h);
+                ctx->slice_rows_put = 0;
+
+#if CONFIG_MULTITHREAD
+                /* Frame threading can complete several frames in one call,
+                 * and put_slice users do not call get_frame for the rest.
+                 */
+                while (ctx->pbi->frame_threads
+                       && !vp8dx_get_raw_frame(ctx->pbi, &sd, &time_stamp,
+                                               &time_end_stamp, &flags))
+                {
+                    yuvconfig2image(&ctx->img, &sd, ctx->pbi->ft_out_user_priv);
+                    ctx->img.fb_priv = frame_buffer_priv(ctx->pbi, &sd);
+                    put_slice(ctx, &ctx->img, ctx->img.d_h);
+                    ctx->slice_rows_put = 0;
+                }
+#endif
+            }
         }
     }
 
     return res;
 }
 
+/* Decodes the items of the batch with the instance of item i, in order. */
+static void decode_batch_stream(vpx_codec_batch_item_t *items,
+                                unsigned int count, unsigned int i)
+{
+    vpx_codec_ctx_t *ctx = items[i].ctx;
+
+    for (; i < count; i++)
+        if (items[i].ctx == ctx)
+            items[i].res = vp8_decode(ctx->priv->alg_priv, items[i].data,
+                                      items[i].data_sz, items[i].user_priv,
+                                      items[i].deadline);
+}
+
+/* Returns non-zero if item i is the first of its instance in the batch. */
+static int first_of_stream(vpx_codec_batch_item_t *items, unsigned int i)
+{
+    unsigned int j;
+
+    for (j = 0; j < i; j++)
+        if (items[j].ctx == items[i].ctx)
+            return 0;
+
+    return 1;
+}
+
+#if CONFIG_MULTITHREAD
+/* A batch decode, shared by the calling thread and the thread pool jobs */
+typedef struct
+{
+    vpx_codec_batch_item_t *items;
+    unsigned int count;
+    volatile int next_item;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int jobs_running;
+} vp8_batch_t;
+
+/* Instances that decode their rows on the thread pool may wait on its
+ * workers, so pool jobs leave them to the calling thread.
+ */
+static int stream_uses_pool(vpx_codec_batch_item_t *item)
+{
+    return (item->ctx->init_flags & VPX_CODEC_USE_THREAD_POOL) != 0;
+}
+
+/* Claims and decodes the streams of the batch until all are taken, but
+ * for the ones using the thread pool.
+ */
+static void decode_batch_streams(vp8_batch_t *batch)
+{
+    unsigned int i;
+
+    while ((i = atomic_fetch_add(&batch->next_item, 1)) < batch->count)
+    {
+        if (stream_uses_pool(&batch->items[i]))
+            continue;
+
+        if (first_of_stream(batch->items, i))
+            decode_batch_stream(batch->items, batch->count, i);
+    }
+}
+
+static void decode_batch_job(void *arg1, void *arg2)
+{
+    vp8_batch_t *batch = (vp8_batch_t *)arg1;
+
+    (void)arg2;
+    decode_batch_streams(batch);
+
+    pthread_mutex_lock(&batch->mutex);
+    if (--batch->jobs_running == 0)
+        pthread_cond_broadcast(&batch->cond);
+    pthread_mutex_unlock(&batch->mutex);
+}
+#endif
+
+/* Decodes the streams of the batch in parallel on the shared thread pool,
+ * with the calling thread taking part.
+ */
+static void vp8_decode_batch(vpx_codec_batch_item_t *items,
+                             unsigned int count)
+{
+    unsigned int i;
+
+#if CONFIG_MULTITHREAD
+    VP8_THREAD_POOL *pool = NULL;
+    VP8_POOL_JOB *jobs = NULL;
+    vp8_batch_t batch;
+    int num_jobs = 0;
+
+    /* Shared initialization is done here, before any job runs. */
+    vp8dx_initialize();
+
+    if (count > 1)
+        pool = vp8_thread_pool_acquire(vp8_get_cpu_count());
+
+    if (pool)
+    {
+        num_jobs = pool->num_workers < (int)count - 1 ? pool->num_workers
+                                                       : (int)count - 1;
+        jobs = vpx_calloc(num_jobs, sizeof(*jobs));
+
+        if (!jobs || pthread_mutex_init(&batch.mutex, NULL))
+            num_jobs = 0;
+        else if (pthread_cond_init(&batch.cond, NULL))
+        {
+            pthread_mutex_destroy(&batch.mutex);
+            num_jobs = 0;
+        }
+    }
+
+    if (num_jobs)
+    {
+        batch.items = items;
+        batch.count = count;
+        batch.next_item = 0;
+        batch.jobs_running = num_jobs;
+
+        for (i = 0; i < (unsigned int)num_jobs; i++)
+        {
+            jobs[i].fn = decode_batch_job;
+            jobs[i].arg1 = &batch;
+            vp8_thread_pool_submit(pool, &jobs[i]);
+        }
+
+        /* This thread decodes the streams the jobs leave to it, and then
+         * helps with the others.
+         */
+        for (i = 0; i < count; i++)
+            if (stream_uses_pool(&items[i]) && first_of_stream(items, i))
+                decode_batch_stream(items, count, i);
+
+        decode_batch_streams(&batch);
+
+        pthread_mutex_lock(&batch.mutex);
+        while (batch.jobs_running)
+            pthread_cond_wait(&batch.cond, &batch.mutex);
+        pthread_mutex_unlock(&batch.mutex);
+
+        pthread_cond_destroy(&batch.cond);
+        pthread_mutex_destroy(&batch.mutex);
+    }
+
+    vpx_free(jobs);
+
+    if (pool)
+        vp8_thread_pool_release(pool);
+
+    if (num_jobs)
+        return;
+#endif
+
+    for (i = 0; i < count; i++)
+        if (first_of_stream(items, i))
+            decode_batch_stream(items, count, i);
+}
+
 static vpx_image_t *vp8_get_frame(vpx_codec_alg_priv_t  *ctx,
                                   vpx_codec_iter_t      *iter)
 {
@@ -497,6 +814,23 @@ static vpx_image_t *vp8_get_frame(vpx_codec_alg_priv_t  *ctx,
             img = &ctx->img;
             *iter = img;
         }
+#if CONFIG_MULTITHREAD
+        else if (ctx->pbi->frame_threads)
+        {
+            /* Frame threading can complete several frames in one call. */
+            YV12_BUFFER_CONFIG sd;
+            int64_t time_stamp, time_end_stamp;
+            vp8_ppflags_t flags = {0};
+
+            if (!vp8dx_get_raw_frame(ctx->pbi, &sd, &time_stamp,
+                                     &time_end_stamp, &flags))
+            {
+                yuvconfig2image(&ctx->img, &sd, ctx->pbi->ft_out_user_priv);
+                ctx->img.fb_priv = frame_buffer_priv(ctx->pbi, &sd);
+                img = &ctx->img;
+            }
+        }
+#endif
     }
 
     return img;
@@ -724,6 +1058,13 @@ static vpx_codec_err_t vp8_get_last_ref_frame(vpx_codec_alg_priv_t *ctx,
 
     if (ref_info)
     {
+#if CONFIG_MULTITHREAD
+        if (pbi->frame_threads)
+        {
+            *ref_info = pbi->ft_ref_frame_used;
+            return VPX_CODEC_OK;
+        }
+#endif
         *ref_info =
             (vp8dx_references_buffer( oci, ALTREF_FRAME )?VP8_ALTR_FRAME:0) |
             (vp8dx_references_buffer( oci, GOLDEN_FRAME )?VP8_GOLD_FRAME:0) |
@@ -745,7 +1086,10 @@ static vpx_codec_err_t vp8_get_frame_corrupted(vpx_codec_alg_priv_t *ctx,
     if (corrupted)
     {
         VP8D_COMP *pbi = (VP8D_COMP *)ctx->pbi;
-        *corrupted = pbi->common.frame_to_show->corrupted;
+
+        /* No frame completed yet when decoding frames in parallel. */
+        *corrupted = pbi->common.frame_to_show ?
+                     pbi->common.frame_to_show->corrupted : 0;
 
         return VPX_CODEC_OK;
     }
@@ -754,6 +1098,143 @@ static vpx_codec_err_t vp8_get_frame_corrupted(vpx_codec_alg_priv_t *ctx,
 
 }
 
+static vpx_codec_err_t vp8_set_fast_seek(vpx_codec_alg_priv_t *ctx,
+                                         int ctrl_id,
+                                         va_list args)
+{
+    int flags = va_arg(args, int);
+
+    if (flags & ~(VP8_SEEK_SKIP_NONREF | VP8_SEEK_SKIP_LOOPFILTER))
+        return VPX_CODEC_INVALID_PARAM;
+
+    if (frame_threading_active(ctx))
+        return VPX_CODEC_INCAPABLE;
+
+    ctx->fast_seek = flags;
+    return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t vp8_set_reduced_resolution(vpx_codec_alg_priv_t *ctx,
+                                                  int ctrl_id,
+                                                  va_list args)
+{
+    int scale = va_arg(args, int);
+
+    if (scale < 0 || scale > 2)
+        return VPX_CODEC_INVALID_PARAM;
+
+    if (frame_threading_active(ctx))
+        return VPX_CODEC_INCAPABLE;
+
+    ctx->reduced_resolution = scale;
+    return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t vp8_set_frame_passes(vpx_codec_alg_priv_t *ctx,
+                                            int ctrl_id,
+                                            va_list args)
+{
+    int enable = va_arg(args, int);
+
+    if (frame_threading_active(ctx))
+        return VPX_CODEC_INCAPABLE;
+
+    ctx->frame_passes = enable != 0;
+    return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t vp8_get_frame_threading(vpx_codec_alg_priv_t *ctx,
+                                               int ctrl_id,
+                                               va_list args)
+{
+    int *frame_threading = va_arg(args, int *);
+
+    if (frame_threading)
+    {
+        *frame_threading = frame_threading_active(ctx);
+        return VPX_CODEC_OK;
+    }
+    else
+        return VPX_CODEC_INVALID_PARAM;
+}
+
+static vpx_codec_err_t vp8_get_frame_skipped(vpx_codec_alg_priv_t *ctx,
+                                             int ctrl_id,
+                                             va_list args)
+{
+    int *skipped = va_arg(args, int *);
+
+    if (skipped)
+    {
+        VP8D_COMP *pbi = (VP8D_COMP *)ctx->pbi;
+
+        *skipped = pbi ? pbi->frame_skipped : 0;
+        return VPX_CODEC_OK;
+    }
+    else
+        return VPX_CODEC_INVALID_PARAM;
+}
+
+static vpx_codec_err_t vp8_set_stats(vpx_codec_alg_priv_t *ctx,
+                                     int ctrl_id,
+                                     va_list args)
+{
+    int enable = va_arg(args, int);
+
+    if (enable && !ctx->stats_enabled && ctx->pbi)
+    {
+        VP8D_COMP *pbi = (VP8D_COMP *)ctx->pbi;
+
+        vpx_memset(&pbi->stats_frame, 0, sizeof(pbi->stats_frame));
+        vpx_memset(&pbi->stats_total, 0, sizeof(pbi->stats_total));
+    }
+
+    ctx->stats_enabled = enable != 0;
+    return VPX_CODEC_OK;
+}
+
+static void copy_stats(vp8d_stats_counters_t *dst, const VP8D_STATS *src)
+{
+    int i;
+
+    dst->frames = src->frames;
+    dst->mode_mv_time = src->time[STAT_MODES] / 1000;
+    dst->entropy_time = src->time[STAT_TOKENS] / 1000;
+    dst->recon_time = src->time[STAT_RECON] / 1000;
+    dst->loop_filter_time = src->time[STAT_LOOP_FILTER] / 1000;
+    dst->extend_time = src->time[STAT_EXTEND] / 1000;
+    dst->postproc_time = src->time[STAT_POSTPROC] / 1000;
+    dst->thread_wait_time = src->time[STAT_THREAD_WAIT] / 1000;
+    dst->first_partition_bytes = src->partition_bytes[0];
+
+    for (i = 0; i < 8; i++)
+        dst->token_partition_bytes[i] = src->partition_bytes[i + 1];
+}
+
+static vpx_codec_err_t vp8_get_stats(vpx_codec_alg_priv_t *ctx,
+                                     int ctrl_id,
+                                     va_list args)
+{
+    vp8d_stats_t *stats = va_arg(args, vp8d_stats_t *);
+
+    if (stats)
+    {
+        VP8D_COMP *pbi = (VP8D_COMP *)ctx->pbi;
+
+        vpx_memset(stats, 0, sizeof(*stats));
+
+        if (pbi)
+        {
+            copy_stats(&stats->frame, &pbi->stats_frame);
+            copy_stats(&stats->total, &pbi->stats_total);
+        }
+
+        return VPX_CODEC_OK;
+    }
+    else
+        return VPX_CODEC_INVALID_PARAM;
+}
+
 vpx_codec_ctrl_fn_map_t vp8_ctf_maps[] =
 {
     {VP8_SET_REFERENCE,             vp8_set_reference},
@@ -766,10 +1247,31 @@ vpx_codec_ctrl_fn_map_t vp8_ctf_maps[] =
     {VP8D_GET_LAST_REF_UPDATES,     vp8_get_last_ref_updates},
     {VP8D_GET_FRAME_CORRUPTED,      vp8_get_frame_corrupted},
     {VP8D_GET_LAST_REF_USED,        vp8_get_last_ref_frame},
+    {VP8D_SET_FAST_SEEK,            vp8_set_fast_seek},
+    {VP8D_GET_FRAME_SKIPPED,        vp8_get_frame_skipped},
+    {VP8D_SET_REDUCED_RESOLUTION,   vp8_set_reduced_resolution},
+    {VP8D_SET_STATS,                vp8_set_stats},
+    {VP8D_GET_STATS,                vp8_get_stats},
+    {VP8D_GET_FRAME_THREADING,      vp8_get_frame_threading},
+    {VP8D_SET_FRAME_PASSES,         vp8_set_frame_passes},
     { -1, NULL},
 };
 
 
+vpx_codec_err_t vpx_codec_vp8_dx_set_thread_pool_size(unsigned int threads)
+{
+#if CONFIG_MULTITHREAD
+    if (!threads || threads > 1024)
+        return VPX_CODEC_INVALID_PARAM;
+
+    vp8dx_initialize();
+    return vp8_thread_pool_set_size(threads) ? VPX_CODEC_ERROR : VPX_CODEC_OK;
+#else
+    return VPX_CODEC_INCAPABLE;
+#endif
+}
+
+
 #ifndef VERSION_STRING
 #define VERSION_STRING
 #endif
@@ -778,7 +1280,9 @@ CODEC_INTERFACE(vpx_codec_vp8_dx) =
     "WebM Project VP8 Decoder" VERSION_STRING,
     VPX_CODEC_INTERNAL_ABI_VERSION,
     VPX_CODEC_CAP_DECODER | VP8_CAP_POSTPROC | VP8_CAP_ERROR_CONCEALMENT |
-    VPX_CODEC_CAP_INPUT_FRAGMENTS,
+    VPX_CODEC_CAP_INPUT_FRAGMENTS | VP8_CAP_FRAME_THREADING |
+    VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER | VP8_CAP_THREAD_POOL |
+    VPX_CODEC_CAP_PUT_SLICE,
     /* vpx_codec_caps_t          caps; */
     vp8_init,         /* vpx_codec_init_fn_t       init; */
     vp8_destroy,      /* vpx_codec_destroy_fn_t    destroy; */
@@ -790,6 +1294,7 @@ CODEC_INTERFACE(vpx_codec_vp8_dx) =
         vp8_get_si,       /* vpx_codec_get_si_fn_t     get_si; */
         vp8_decode,       /* vpx_codec_decode_fn_t     decode; */
         vp8_get_frame,    /* vpx_codec_frame_get_fn_t  frame_get; */
+        vp8_decode_batch, /* vpx_codec_decode_batch_fn_t decode_batch; */
     },
     { /* encoder functions */
         NOT_IMPLEMENTED,
@@ -0,0 +1,280 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * This is a benchmark of decoding one VP8 stream. The IVF file is read
+ * into memory and decoded the number of times given, and the time of the
+ * fastest pass is reported per frame. One more pass is decoded with the
+ * decoder statistics enabled, to break the time down by decoding stage and
+ * hash the frames; its times include the cost of the statistics.
+ *
+ * To compare loop filtering each MB row as it is decoded with filtering
+ * the frame once it is decoded, run the same stream both ways:
+ *
+ *   vp8_decode_benchmark clip.ivf 20 1
+ *   vp8_decode_benchmark clip.ivf 20 1 frame-passes
+ *
+ * The frame hash must be the same both ways.
+ *
+ * With bools, the bool decoder alone is timed instead: the data of each
+ * frame is read as bools, with a fixed sequence of probabilities, until
+ * it runs out, and the time is reported per bool. The bools are hashed,
+ * for checking that a change to the bool decoder reads the same values:
+ *
+ *   vp8_decode_benchmark clip.ivf 20 1 bools
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vpx_config.h"
+#define VPX_CODEC_DISABLE_COMPAT 1
+#include "vpx/vpx_decoder.h"
+#include "vpx/vp8dx.h"
+#include "vpx_ports/vpx_timer.h"
+#include "vp8/decoder/dboolhuff.h"
+#define interface (vpx_codec_vp8_dx())
+
+#define IVF_FILE_HDR_SZ  (32)
+#define IVF_FRAME_HDR_SZ (12)
+
+static const unsigned char *file_data;
+static size_t file_size;
+static int decoder_threads;
+static int frame_passes;
+static unsigned char bool_probs[256];
+
+static void die(const char *fmt, const char *arg) {
+    fprintf(stderr, fmt, arg);
+    fprintf(stderr, "\n");
+    exit(EXIT_FAILURE);
+}
+
+static void die_codec(vpx_codec_ctx_t *ctx, const char *s) {
+    const char *detail = vpx_codec_error_detail(ctx);
+
+    fprintf(stderr, "%s: %s\n", s, vpx_codec_error(ctx));
+    if (detail)
+        fprintf(stderr, "    %s\n", detail);
+    exit(EXIT_FAILURE);
+}
+
+static unsigned int mem_get_le32(const unsigned char *mem) {
+    return (mem[3] << 24)|(mem[2] << 16)|(mem[1] << 8)|(mem[0]);
+}
+
+/* Returns the position of the next frame and sets its size, or returns 0
+ * at the end of the file.
+ */
+static size_t next_frame(size_t pos, unsigned int *frame_sz) {
+    if (pos + IVF_FRAME_HDR_SZ > file_size)
+        return 0;
+    *frame_sz = mem_get_le32(file_data + pos);
+    pos += IVF_FRAME_HDR_SZ;
+    return *frame_sz <= file_size - pos ? pos : 0;
+}
+
+static unsigned int hash_frame(unsigned int hash, const vpx_image_t *img) {
+    int plane, y, x;
+
+    for (plane = 0; plane < 3; plane++) {
+        const int shift = plane ? 1 : 0;
+        const unsigned char *row = img->planes[plane];
+
+        for (y = 0; y < (int)(img->d_h + shift) >> shift; y++) {
+            for (x = 0; x < (int)(img->d_w + shift) >> shift; x++)
+                hash = (hash ^ row[x]) * 16777619;
+            row += img->stride[plane];
+        }
+    }
+    return hash;
+}
+
+/* Decodes the file once, and returns the number of frames output and the
+ * time the decode calls took. With stats set, the statistics are collected
+ * and the frames are hashed.
+ */
+static int decode_pass(int64_t *dx_time, vp8d_stats_t *stats,
+                       unsigned int *hash) {
+    vpx_codec_ctx_t codec;
+    vpx_codec_dec_cfg_t cfg = {0};
+    size_t pos = IVF_FILE_HDR_SZ;
+    unsigned int frame_sz;
+    int frames = 0;
+
+    cfg.threads = decoder_threads;
+    if (vpx_codec_dec_init(&codec, interface, &cfg, 0))
+        die_codec(&codec, "Failed to initialize decoder");
+    if (frame_passes && vpx_codec_control(&codec, VP8D_SET_FRAME_PASSES, 1))
+        die_codec(&codec, "Failed to set frame passes");
+    if (stats && vpx_codec_control(&codec, VP8D_SET_STATS, 1))
+        die_codec(&codec, "Failed to enable the statistics");
+
+    while ((pos = next_frame(pos, &frame_sz))) {
+        vpx_codec_iter_t iter = NULL;
+        vpx_image_t *img;
+        struct vpx_usec_timer timer;
+
+        vpx_usec_timer_start(&timer);
+        if (vpx_codec_decode(&codec, file_data + pos, frame_sz, NULL, 0))
+            die_codec(&codec, "Failed to decode frame");
+        vpx_usec_timer_mark(&timer);
+        *dx_time += vpx_usec_timer_elapsed(&timer);
+        pos += frame_sz;
+
+        while ((img = vpx_codec_get_frame(&codec, &iter))) {
+            if (stats)
+                *hash = hash_frame(*hash, img);
+            frames++;
+        }
+    }
+
+    if (stats && vpx_codec_control(&codec, VP8D_GET_STATS, stats))
+        die_codec(&codec, "Failed to get the statistics");
+    if (vpx_codec_destroy(&codec))
+        die_codec(&codec, "Failed to destroy codec");
+
+    return frames;
+}
+
+/* Reads the data of each frame as bools, and returns the number read and
+ * the time the reads took.
+ */
+static uint64_t read_bools(int64_t *dx_time, unsigned int *hash) {
+    size_t pos = IVF_FILE_HDR_SZ;
+    unsigned int frame_sz;
+    uint64_t bools = 0;
+
+    while ((pos = next_frame(pos, &frame_sz))) {
+        BOOL_DECODER bd;
+        struct vpx_usec_timer timer;
+        unsigned int h = *hash;
+        int i = 0;
+
+        vpx_usec_timer_start(&timer);
+        vp8dx_start_decode(&bd, file_data + pos, frame_sz);
+
+        /* The end of the data is checked every 64 bools. */
+        while (!vp8dx_bool_error(&bd)) {
+            int n;
+
+            for (n = 0; n < 64; n++, i++)
+                h = (h ^ vp8dx_decode_bool(&bd, bool_probs[i & 255]))
+                    * 16777619;
+        }
+        vpx_usec_timer_mark(&timer);
+        *dx_time += vpx_usec_timer_elapsed(&timer);
+
+        *hash = h;
+        bools += i;
+        pos += frame_sz;
+    }
+
+    return bools;
+}
+
+static double per_frame(uint64_t usecs, unsigned int frames) {
+    return frames ? (double)usecs / frames : 0.0;
+}
+
+int main(int argc, char **argv) {
+    FILE *infile;
+    unsigned char *data;
+    int passes, pass, frames = 0, bools_only, i;
+    uint64_t bools = 0;
+    int64_t best = -1, dx_time;
+    unsigned int hash = 2166136261u;
+    vp8d_stats_t stats;
+    const vp8d_stats_counters_t *total = &stats.total;
+
+    if (argc != 4 && !(argc == 5 && (!strcmp(argv[4], "frame-passes")
+                                     || !strcmp(argv[4], "bools"))))
+        die("Usage: %s <infile> <passes> <threads> [frame-passes|bools]",
+            argv[0]);
+
+    passes = strtol(argv[2], NULL, 0);
+    decoder_threads = strtol(argv[3], NULL, 0);
+    frame_passes = argc == 5 && !strcmp(argv[4], "frame-passes");
+    bools_only = argc == 5 && !strcmp(argv[4], "bools");
+    if (passes < 1 || decoder_threads < 1)
+        die("Invalid arguments, try %s with no argument", argv[0]);
+
+    if (!(infile = fopen(argv[1], "rb")))
+        die("Failed to open %s for reading", argv[1]);
+    fseek(infile, 0, SEEK_END);
+    file_size = ftell(infile);
+    fseek(infile, 0, SEEK_SET);
+    data = malloc(file_size);
+    if (!data || fread(data, 1, file_size, infile) != file_size)
+        die("Failed to read %s", argv[1]);
+    fclose(infile);
+    file_data = data;
+
+    if (file_size < IVF_FILE_HDR_SZ || memcmp(data, "DKIF", 4))
+        die("%s is not an IVF file", argv[1]);
+
+    if (bools_only) {
+        /* Probabilities of 1 to 255, skewed towards the ends as those of
+         * the tokens are.
+         */
+        srand(1);
+        for (i = 0; i < 256; i++) {
+            const int p = rand() % 128;
+
+            bool_probs[i] = rand() % 2 ? 1 + p * p / 128 : 255 - p * p / 128;
+        }
+
+        for (pass = 0; pass < passes; pass++) {
+            dx_time = 0;
+            hash = 2166136261u;
+            bools = read_bools(&dx_time, &hash);
+
+            if (best < 0 || dx_time < best)
+                best = dx_time;
+        }
+
+        printf("%s, bools\n", argv[1]);
+        printf("%.0f bools, best of %d passes: %.2f ns per bool\n",
+               (double)bools, passes,
+               bools ? best * 1000.0 / bools : 0.0);
+        printf("bool hash %08x\n", hash);
+
+        free(data);
+        return EXIT_SUCCESS;
+    }
+
+    for (pass = 0; pass < passes; pass++) {
+        dx_time = 0;
+        frames = decode_pass(&dx_time, NULL, NULL);
+
+        if (best < 0 || dx_time < best)
+            best = dx_time;
+    }
+
+    dx_time = 0;
+    decode_pass(&dx_time, &stats, &hash);
+
+    printf("%s, %d threads%s\n", argv[1], decoder_threads,
+           frame_passes ? ", frame passes" : "");
+    printf("%d frames, best of %d passes: %.3f ms per frame\n", frames,
+           passes, frames ? best / 1000.0 / frames : 0.0);
+    printf("per frame with statistics, in us: modes %.1f, tokens %.1f, "
+           "recon %.1f, loop filter %.1f, extend %.1f, thread wait %.1f\n",
+           per_frame(total->mode_mv_time, total->frames),
+           per_frame(total->entropy_time, total->frames),
+           per_frame(total->recon_time, total->frames),
+           per_frame(total->loop_filter_time, total->frames),
+           per_frame(total->extend_time, total->frames),
+           per_frame(total->thread_wait_time, total->frames));
+    printf("frame hash %08x\n", hash);
+
+    free(data);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,268 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * This is a benchmark of decoding many VP8 streams at once, as a server
+ * would. Each stream is a decode of the same IVF file, by a decoder
+ * instance on its own application thread, or, in batch mode, by one
+ * vpx_codec_decode_batch() call per frame for all streams. The decoders
+ * either run their own row threads or share the decoder thread pool. The
+ * aggregate frame rate, and the CPU time and context switches of the
+ * process are reported, and the decoded frames of the streams are checked
+ * to match.
+ *
+ * To compare the pool with per-decoder threads, run the same streams both
+ * ways, with a pool of one thread per core:
+ *
+ *   vp8_multi_stream_decoder 100 0 4 clip.ivf
+ *   vp8_multi_stream_decoder 100 <cores> 4 clip.ivf
+ *
+ * A decoder starts no more row threads than there are cores, so without
+ * the pool the process runs up to 100 * (min(4, cores) - 1) row threads,
+ * and with it, <cores>. The frame hash must be the same both ways.
+ *
+ * The CPU time per frame shows what waiting on other threads costs. To
+ * measure it with twice as many threads as cores, decode one stream per
+ * core with 2 threads each, on a machine with 2 cores or more:
+ *
+ *   vp8_multi_stream_decoder <cores> 0 2 clip.ivf
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#define VPX_CODEC_DISABLE_COMPAT 1
+#include "vpx/vpx_decoder.h"
+#include "vpx/vp8dx.h"
+#define interface (vpx_codec_vp8_dx())
+
+#define IVF_FILE_HDR_SZ  (32)
+#define IVF_FRAME_HDR_SZ (12)
+
+static const unsigned char *file_data;
+static size_t file_size;
+static int decoder_threads;
+static int use_pool;
+
+typedef struct
+{
+    pthread_t thread;
+    vpx_codec_ctx_t codec;
+    int frames;
+    int failed;
+    unsigned int hash;
+} stream_t;
+
+static void die(const char *fmt, const char *arg) {
+    fprintf(stderr, fmt, arg);
+    fprintf(stderr, "\n");
+    exit(EXIT_FAILURE);
+}
+
+static unsigned int mem_get_le32(const unsigned char *mem) {
+    return (mem[3] << 24)|(mem[2] << 16)|(mem[1] << 8)|(mem[0]);
+}
+
+/* Returns the position of the next frame and sets its size, or returns 0
+ * at the end of the file.
+ */
+static size_t next_frame(size_t pos, unsigned int *frame_sz) {
+    if (pos + IVF_FRAME_HDR_SZ > file_size)
+        return 0;
+    *frame_sz = mem_get_le32(file_data + pos);
+    pos += IVF_FRAME_HDR_SZ;
+    return *frame_sz <= file_size - pos ? pos : 0;
+}
+
+static void hash_frames(stream_t *stream) {
+    vpx_codec_iter_t iter = NULL;
+    vpx_image_t *img;
+
+    while ((img = vpx_codec_get_frame(&stream->codec, &iter))) {
+        int plane, y, x;
+
+        for (plane = 0; plane < 3; plane++) {
+            const int shift = plane ? 1 : 0;
+            const unsigned char *row = img->planes[plane];
+
+            for (y = 0; y < (int)(img->d_h + shift) >> shift; y++) {
+                for (x = 0; x < (int)(img->d_w + shift) >> shift; x++)
+                    stream->hash = (stream->hash ^ row[x]) * 16777619;
+                row += img->stride[plane];
+            }
+        }
+        stream->frames++;
+    }
+}
+
+static int init_stream(stream_t *stream) {
+    vpx_codec_dec_cfg_t cfg = {0};
+
+    cfg.threads = decoder_threads;
+    stream->hash = 2166136261u;
+    return vpx_codec_dec_init(&stream->codec, interface, &cfg,
+                              use_pool ? VPX_CODEC_USE_THREAD_POOL : 0);
+}
+
+static void *decode_stream(void *arg) {
+    stream_t *stream = (stream_t *)arg;
+    size_t pos = IVF_FILE_HDR_SZ;
+    unsigned int frame_sz;
+
+    if (init_stream(stream)) {
+        stream->failed = 1;
+        return NULL;
+    }
+
+    while ((pos = next_frame(pos, &frame_sz))) {
+        if (vpx_codec_decode(&stream->codec, file_data + pos, frame_sz,
+                             NULL, 0))
+            stream->failed = 1;
+        pos += frame_sz;
+        hash_frames(stream);
+    }
+
+    if (vpx_codec_destroy(&stream->codec))
+        stream->failed = 1;
+
+    return NULL;
+}
+
+static void decode_batches(stream_t *streams, int num_streams) {
+    vpx_codec_batch_item_t *items = calloc(num_streams, sizeof(*items));
+    size_t pos = IVF_FILE_HDR_SZ;
+    unsigned int frame_sz;
+    int i;
+
+    if (!items)
+        die("Failed to allocate the batch%s", "");
+
+    for (i = 0; i < num_streams; i++) {
+        if (init_stream(&streams[i]))
+            die("Failed to initialize decoder%s", "");
+        items[i].ctx = &streams[i].codec;
+    }
+
+    while ((pos = next_frame(pos, &frame_sz))) {
+        for (i = 0; i < num_streams; i++) {
+            items[i].data = file_data + pos;
+            items[i].data_sz = frame_sz;
+        }
+        vpx_codec_decode_batch(items, num_streams);
+        pos += frame_sz;
+
+        for (i = 0; i < num_streams; i++) {
+            if (items[i].res)
+                streams[i].failed = 1;
+            hash_frames(&streams[i]);
+        }
+    }
+
+    for (i = 0; i < num_streams; i++)
+        if (vpx_codec_destroy(&streams[i].codec))
+            streams[i].failed = 1;
+
+    free(items);
+}
+
+int main(int argc, char **argv) {
+    FILE *infile;
+    unsigned char *data;
+    stream_t *streams;
+    int num_streams, pool_size, batch, i, frames = 0, failed = 0;
+    int mismatch = 0;
+    struct timeval start, end;
+    struct rusage usage;
+    double elapsed, cpu;
+
+    if (argc != 5 && !(argc == 6 && !strcmp(argv[5], "batch")))
+        die("Usage: %s <streams> <pool size, 0 for no pool> <threads per "
+            "decoder> <infile> [batch]", argv[0]);
+
+    num_streams = strtol(argv[1], NULL, 0);
+    pool_size = strtol(argv[2], NULL, 0);
+    decoder_threads = strtol(argv[3], NULL, 0);
+    use_pool = pool_size > 0;
+    batch = argc == 6;
+    if (num_streams < 1 || pool_size < 0 || decoder_threads < 1)
+        die("Invalid arguments, try %s with no argument", argv[0]);
+
+    if (!(infile = fopen(argv[4], "rb")))
+        die("Failed to open %s for reading", argv[4]);
+    fseek(infile, 0, SEEK_END);
+    file_size = ftell(infile);
+    fseek(infile, 0, SEEK_SET);
+    data = malloc(file_size);
+    if (!data || fread(data, 1, file_size, infile) != file_size)
+        die("Failed to read %s", argv[4]);
+    fclose(infile);
+    file_data = data;
+
+    if (file_size < IVF_FILE_HDR_SZ || memcmp(data, "DKIF", 4))
+        die("%s is not an IVF file", argv[4]);
+
+    if ((use_pool || batch) && pool_size
+        && vpx_codec_vp8_dx_set_thread_pool_size(pool_size))
+        die("Failed to set the thread pool size%s", "");
+
+    streams = calloc(num_streams, sizeof(*streams));
+    if (!streams)
+        die("Failed to allocate streams%s", "");
+
+    gettimeofday(&start, NULL);
+    if (batch) {
+        decode_batches(streams, num_streams);
+    } else {
+        for (i = 0; i < num_streams; i++)
+            if (pthread_create(&streams[i].thread, NULL, decode_stream,
+                               &streams[i]))
+                die("Failed to start stream threads%s", "");
+        for (i = 0; i < num_streams; i++)
+            pthread_join(streams[i].thread, NULL);
+    }
+    gettimeofday(&end, NULL);
+
+    for (i = 0; i < num_streams; i++) {
+        frames += streams[i].frames;
+        failed |= streams[i].failed;
+        mismatch |= streams[i].hash != streams[0].hash
+                    || streams[i].frames != streams[0].frames;
+    }
+    getrusage(RUSAGE_SELF, &usage);
+
+    elapsed = (end.tv_sec - start.tv_sec)
+              + (end.tv_usec - start.tv_usec) / 1000000.0;
+    cpu = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0
+          + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+    printf("%d streams%s, %d threads per decoder, ", num_streams,
+           batch ? " in batches" : "", decoder_threads);
+    if (use_pool)
+        printf("pool of %d threads\n", pool_size);
+    else
+        printf("no pool\n");
+    printf("%d frames in %.3f s: %.1f fps aggregate\n", frames, elapsed,
+           elapsed > 0 ? frames / elapsed : 0.0);
+    printf("CPU time %.3f s: %.3f ms per frame\n", cpu,
+           frames ? cpu * 1000 / frames : 0.0);
+    printf("context switches: %ld voluntary, %ld involuntary\n",
+           usage.ru_nvcsw, usage.ru_nivcsw);
+    printf("frame hash %08x\n", streams[0].hash);
+    if (failed)
+        printf("Some frames failed to decode\n");
+    if (mismatch)
+        printf("The streams were not decoded identically\n");
+
+    free(streams);
+    free(data);
+    return failed || mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
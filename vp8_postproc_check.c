@@ -0,0 +1,224 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * This checks the SIMD versions of the postprocessing kernels against
+ * their C versions, on random data: the MFQE blending kernels, and the
+ * banded vertical de-macroblock filter, over band splits and widths.
+ * It exits with a failure on the first mismatch.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vpx_config.h"
+#include "vpx_rtcd.h"
+#if ARCH_X86 || ARCH_X86_64
+#include "vpx_ports/x86.h"
+#endif
+
+#define MAX_COLS   128
+#define MAX_ROWS   80
+#define BORDER     8
+#define PITCH      (MAX_COLS + 2 * BORDER)
+
+extern const short vp8_rv[];
+
+typedef void (*filter_by_weight_fn_t)(unsigned char *src, int src_stride,
+                                      unsigned char *dst, int dst_stride,
+                                      int src_weight);
+
+typedef void (*down_band_fn_t)(unsigned char *dst, int pitch, int row_start,
+                               int row_end, int cols, int flimit,
+                               unsigned char *pending, const short *rv);
+
+static int checks, failures;
+
+static void fill_random(unsigned char *buf, int size, int range)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        buf[i] = 128 + rand() % (2 * range + 1) - range;
+}
+
+static void check_filter_by_weight(const char *name, int size,
+                                   filter_by_weight_fn_t ref,
+                                   filter_by_weight_fn_t simd)
+{
+    unsigned char src[32 * 32], dst_ref[32 * 32], dst_simd[32 * 32];
+    int weight, trial;
+
+    for (weight = 0; weight <= 16; weight++)
+    {
+        for (trial = 0; trial < 16; trial++)
+        {
+            const int src_stride = size + rand() % 16;
+            const int dst_stride = size + rand() % 16;
+
+            fill_random(src, sizeof(src), 128);
+            fill_random(dst_ref, sizeof(dst_ref), 128);
+            memcpy(dst_simd, dst_ref, sizeof(dst_ref));
+
+            ref(src, src_stride, dst_ref, dst_stride, weight);
+            simd(src, src_stride, dst_simd, dst_stride, weight);
+
+            checks++;
+
+            if (memcmp(dst_ref, dst_simd, sizeof(dst_ref)))
+            {
+                printf("%s mismatch: weight %d, strides %d %d\n", name,
+                       weight, src_stride, dst_stride);
+                failures++;
+                return;
+            }
+        }
+    }
+}
+
+/* Runs the filter over rows in the bands given, then flushes the rows still
+ * pending, as the postprocessor does. The frame and its borders are ready
+ * up front.
+ */
+static void run_down_band(down_band_fn_t fn, unsigned char *frame, int rows,
+                          int cols, int flimit, const int *band_ends,
+                          int num_bands, const short *rv)
+{
+    unsigned char pending[8 * MAX_COLS];
+    unsigned char *y = frame + BORDER * PITCH + BORDER;
+    int row_start = 0, band, i;
+
+    for (band = 0; band < num_bands; band++)
+    {
+        fn(y, PITCH, row_start, band_ends[band], cols, flimit, pending, rv);
+        row_start = band_ends[band];
+    }
+
+    for (i = rows; i < rows + 8; i++)
+        memcpy(y + (i - 8) * PITCH, pending + (i & 7) * cols, cols);
+}
+
+/* The SIMD kernels dither column c with rv[c & 7], as
+ * vp8_mbpost_proc_down_xmm() does, where the C kernel uses
+ * rv[(c * 17) & 127]. The reference runs the C kernel one column at a time
+ * to dither the same way.
+ */
+static void down_band_ref(unsigned char *dst, int pitch, int row_start,
+                          int row_end, int cols, int flimit,
+                          unsigned char *pending, const short *rv)
+{
+    static unsigned char column_pending[MAX_COLS][8];
+    int c, r;
+
+    for (c = 0; c < cols; c++)
+    {
+        for (r = 0; r < 8; r++)
+            column_pending[c][r] = pending[r * cols + c];
+
+        vp8_mbpost_proc_down_band_c(dst + c, pitch, row_start, row_end, 1,
+                                    flimit, column_pending[c], rv + (c & 7));
+
+        for (r = 0; r < 8; r++)
+            pending[r * cols + c] = column_pending[c][r];
+    }
+}
+
+static void check_down_band(const char *name, down_band_fn_t simd)
+{
+    static unsigned char frame_ref[(MAX_ROWS + 2 * BORDER) * PITCH];
+    static unsigned char frame_simd[(MAX_ROWS + 2 * BORDER) * PITCH];
+    int cols, trial;
+
+    for (cols = 8; cols <= MAX_COLS; cols += 8)
+    {
+        for (trial = 0; trial < 8; trial++)
+        {
+            const int rows = 16 + rand() % (MAX_ROWS - 15);
+            const int flimit = rand() % 2 ? rand() % 2000 : 1 << 30;
+            int band_ends[MAX_ROWS];
+            int num_bands = 0, row = 0, i;
+
+            /* Bands of 1 to 24 rows, 16 at most in the first one as in the
+             * postprocessor, whose first band leaves its last 7 rows.
+             */
+            while (row < rows)
+            {
+                row += 1 + rand() % (num_bands ? 24 : 9);
+
+                if (row > rows)
+                    row = rows;
+
+                band_ends[num_bands++] = row;
+            }
+
+            fill_random(frame_ref, sizeof(frame_ref), trial < 4 ? 8 : 128);
+
+            /* replicate the top and bottom rows into the borders */
+            for (i = 0; i < BORDER; i++)
+            {
+                memcpy(frame_ref + i * PITCH, frame_ref + BORDER * PITCH,
+                       PITCH);
+                memcpy(frame_ref + (BORDER + rows + i) * PITCH,
+                       frame_ref + (BORDER + rows - 1) * PITCH, PITCH);
+            }
+
+            memcpy(frame_simd, frame_ref, sizeof(frame_ref));
+
+            run_down_band(down_band_ref, frame_ref, rows, cols, flimit,
+                          band_ends, num_bands, vp8_rv);
+            run_down_band(simd, frame_simd, rows, cols, flimit,
+                          band_ends, num_bands, vp8_rv);
+
+            checks++;
+
+            for (i = 0; i < rows; i++)
+            {
+                const int offset = (BORDER + i) * PITCH + BORDER;
+
+                if (memcmp(frame_ref + offset, frame_simd + offset, cols))
+                {
+                    printf("%s mismatch: row %d of %d, %d cols, "
+                           "%d bands, flimit %d\n", name, i, rows, cols,
+                           num_bands, flimit);
+                    failures++;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+#if ARCH_X86 || ARCH_X86_64
+    const int simd_caps = x86_simd_caps();
+#endif
+
+    (void)argc;
+    (void)argv;
+    srand(1);
+
+#if HAVE_SSE2
+    if (simd_caps & HAS_SSE2)
+    {
+        check_filter_by_weight("vp8_filter_by_weight16x16_sse2", 16,
+                               vp8_filter_by_weight16x16_c,
+                               vp8_filter_by_weight16x16_sse2);
+        check_filter_by_weight("vp8_filter_by_weight8x8_sse2", 8,
+                               vp8_filter_by_weight8x8_c,
+                               vp8_filter_by_weight8x8_sse2);
+        check_down_band("vp8_mbpost_proc_down_band_sse2",
+                        vp8_mbpost_proc_down_band_sse2);
+    }
+#endif
+
+    printf("%d checks, %d failed\n", checks, failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
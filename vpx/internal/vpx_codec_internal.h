@@ -56,7 +56,7 @@
  * types, removing or reassigning enums, adding/removing/rearranging
  * fields to structures
  */
-#define VPX_CODEC_INTERNAL_ABI_VERSION (4) /**<\hideinitializer*/
+#define VPX_CODEC_INTERNAL_ABI_VERSION (6) /**<\hideinitializer*/
 
 typedef struct vpx_codec_alg_priv  vpx_codec_alg_priv_t;
 typedef struct vpx_codec_priv_enc_mr_cfg vpx_codec_priv_enc_mr_cfg_t;
@@ -197,6 +197,21 @@ typedef vpx_codec_err_t (*vpx_codec_decode_fn_t)(vpx_codec_alg_priv_t  *ctx,
         void        *user_priv,
         long         deadline);
 
+/*!\brief batch decode function pointer prototype
+ *
+ * Decodes the items as the decode function would, setting their res
+ * members. The instances of the items all use this interface. This
+ * function is called by the generic vpx_codec_decode_batch() wrapper
+ * function, so plugins implementing this interface may trust the items to
+ * be properly initialized. It is optional: without it, the wrapper decodes
+ * the items one after another.
+ *
+ * \param[in,out] items   The frames to decode
+ * \param[in]     count   Number of items
+ */
+typedef void (*vpx_codec_decode_batch_fn_t)(vpx_codec_batch_item_t *items,
+        unsigned int count);
+
 /*!\brief Decoded frames iterator
  *
  * Iterates over a list of the frames available for display. The iterator
@@ -308,6 +323,7 @@ struct vpx_codec_iface
         vpx_codec_get_si_fn_t     get_si;      /**< \copydoc ::vpx_codec_peek_si_fn_t */
         vpx_codec_decode_fn_t     decode;      /**< \copydoc ::vpx_codec_decode_fn_t */
         vpx_codec_get_frame_fn_t  get_frame;   /**< \copydoc ::vpx_codec_get_frame_fn_t */
+        vpx_codec_decode_batch_fn_t decode_batch; /**< \copydoc ::vpx_codec_decode_batch_fn_t */
     } dec;
     struct
     {
@@ -352,6 +368,9 @@ struct vpx_codec_priv
     {
         vpx_codec_priv_cb_pair_t    put_frame_cb;
         vpx_codec_priv_cb_pair_t    put_slice_cb;
+        vpx_get_frame_buffer_cb_fn_t     get_fb_cb;
+        vpx_release_frame_buffer_cb_fn_t release_fb_cb;
+        void                            *fb_cb_priv;
     } dec;
     struct
     {
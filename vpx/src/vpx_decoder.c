@@ -42,6 +42,12 @@ vpx_codec_err_t vpx_codec_dec_init_ver(vpx_codec_ctx_t      *ctx,
     else if ((flags & VPX_CODEC_USE_INPUT_FRAGMENTS) &&
             !(iface->caps & VPX_CODEC_CAP_INPUT_FRAGMENTS))
         res = VPX_CODEC_INCAPABLE;
+    else if ((flags & VPX_CODEC_USE_FRAME_THREADING) &&
+            !(iface->caps & VPX_CODEC_CAP_FRAME_THREADING))
+        res = VPX_CODEC_INCAPABLE;
+    else if ((flags & VPX_CODEC_USE_THREAD_POOL) &&
+            !(iface->caps & VPX_CODEC_CAP_THREAD_POOL))
+        res = VPX_CODEC_INCAPABLE;
     else if (!(iface->caps & VPX_CODEC_CAP_DECODER))
         res = VPX_CODEC_INCAPABLE;
     else
@@ -141,6 +147,67 @@ vpx_codec_err_t vpx_codec_decode(vpx_codec_ctx_t    *ctx,
     return SAVE_STATUS(ctx, res);
 }
 
+
+vpx_codec_err_t vpx_codec_decode_batch(vpx_codec_batch_item_t *items,
+                                       unsigned int            count)
+{
+    vpx_codec_iface_t *iface = NULL;
+    vpx_codec_err_t res = VPX_CODEC_OK;
+    int batch = 1;
+    unsigned int i;
+
+    if (!items && count)
+        return VPX_CODEC_INVALID_PARAM;
+
+    /* Sanity checks, as for vpx_codec_decode() */
+    for (i = 0; i < count; i++)
+    {
+        vpx_codec_batch_item_t *item = &items[i];
+
+        if (!item->ctx || (!item->data && item->data_sz))
+            item->res = VPX_CODEC_INVALID_PARAM;
+        else if (!item->ctx->iface || !item->ctx->priv)
+            item->res = VPX_CODEC_ERROR;
+        else
+            item->res = VPX_CODEC_OK;
+
+        if (item->res != VPX_CODEC_OK
+            || (iface && item->ctx->iface != iface))
+            batch = 0;
+        else
+            iface = item->ctx->iface;
+    }
+
+    /* The interface decodes the batch if all items are valid instances of
+     * it, and otherwise the items are decoded one after another.
+     */
+    if (batch && iface && iface->dec.decode_batch)
+        iface->dec.decode_batch(items, count);
+    else
+    {
+        for (i = 0; i < count; i++)
+        {
+            vpx_codec_batch_item_t *item = &items[i];
+
+            if (item->res == VPX_CODEC_OK)
+                item->res = item->ctx->iface->dec.decode(
+                                item->ctx->priv->alg_priv, item->data,
+                                item->data_sz, item->user_priv,
+                                item->deadline);
+        }
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        SAVE_STATUS(items[i].ctx, items[i].res);
+
+        if (res == VPX_CODEC_OK)
+            res = items[i].res;
+    }
+
+    return res;
+}
+
 vpx_image_t *vpx_codec_get_frame(vpx_codec_ctx_t  *ctx,
                                  vpx_codec_iter_t *iter)
 {
@@ -186,7 +253,7 @@ vpx_codec_err_t vpx_codec_register_put_slice_cb(vpx_codec_ctx_t             *ctx
     if (!ctx || !cb)
         res = VPX_CODEC_INVALID_PARAM;
     else if (!ctx->iface || !ctx->priv
-             || !(ctx->iface->caps & VPX_CODEC_CAP_PUT_FRAME))
+             || !(ctx->iface->caps & VPX_CODEC_CAP_PUT_SLICE))
         res = VPX_CODEC_ERROR;
     else
     {
@@ -199,6 +266,30 @@ vpx_codec_err_t vpx_codec_register_put_slice_cb(vpx_codec_ctx_t             *ctx
 }
 
 
+vpx_codec_err_t vpx_codec_set_frame_buffer_functions(vpx_codec_ctx_t                  *ctx,
+        vpx_get_frame_buffer_cb_fn_t      cb_get,
+        vpx_release_frame_buffer_cb_fn_t  cb_release,
+        void                             *cb_priv)
+{
+    vpx_codec_err_t res;
+
+    if (!ctx || !cb_get || !cb_release)
+        res = VPX_CODEC_INVALID_PARAM;
+    else if (!ctx->iface || !ctx->priv
+             || !(ctx->iface->caps & VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER))
+        res = VPX_CODEC_ERROR;
+    else
+    {
+        ctx->priv->dec.get_fb_cb = cb_get;
+        ctx->priv->dec.release_fb_cb = cb_release;
+        ctx->priv->dec.fb_cb_priv = cb_priv;
+        res = VPX_CODEC_OK;
+    }
+
+    return SAVE_STATUS(ctx, res);
+}
+
+
 vpx_codec_err_t vpx_codec_get_mem_map(vpx_codec_ctx_t                *ctx,
                                       vpx_codec_mmap_t               *mmap,
                                       vpx_codec_iter_t               *iter)
@@ -15,6 +15,7 @@
  * @{
  */
 #include "vp8.h"
+#include "vpx_encoder.h"
 
 /*!\file
  * \brief Provides definitions for using the VP8 encoder algorithm within the
@@ -32,6 +33,37 @@
  */
 extern vpx_codec_iface_t  vpx_codec_vp8_cx_algo;
 extern vpx_codec_iface_t* vpx_codec_vp8_cx(void);
+
+/*!\brief Merges the first pass statistics of the segments of a clip
+ *
+ * The first pass can run on consecutive segments of a clip separately,
+ * each from the first frame of its segment, for instance in parallel
+ * processes. This concatenates their statistics into the
+ * rc_twopass_stats_in buffer of a last pass over the whole clip. The last
+ * pass ends a key frame group at the start of each segment, and the
+ * application should force a key frame there with #VPX_EFLAG_FORCE_KF.
+ *
+ * \param[in,out] merged          Buffer for the merged statistics. If its
+ *                                buf is NULL, only its sz is set, to the
+ *                                size the merge needs.
+ * \param[in]     segments        Statistics of the segments, in order
+ * \param[out]    segment_frames  Number of frames of each segment, if not
+ *                                NULL
+ * \param[in]     num_segments    Number of segments
+ *
+ * \retval #VPX_CODEC_OK
+ *     The statistics are merged, or their size is set.
+ * \retval #VPX_CODEC_INVALID_PARAM
+ *     A segment is not a complete first pass output, or merged is too small.
+ * \retval #VPX_CODEC_MEM_ERROR
+ *     Memory allocation failed.
+ * \retval #VPX_CODEC_INCAPABLE
+ *     The library is built for real time encoding only.
+ */
+vpx_codec_err_t vpx_codec_vp8_cx_merge_stats(vpx_fixed_buf_t *merged,
+                                             const vpx_fixed_buf_t *segments,
+                                             unsigned int *segment_frames,
+                                             unsigned int num_segments);
 /*!@} - end algorithm interface member group*/
 
 
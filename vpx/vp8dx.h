@@ -32,6 +32,26 @@
  */
 extern vpx_codec_iface_t  vpx_codec_vp8_dx_algo;
 extern vpx_codec_iface_t* vpx_codec_vp8_dx(void);
+
+/*!\brief Sets the size of the shared decoder thread pool
+ *
+ * Decoders initialized with #VPX_CODEC_USE_THREAD_POOL decode their rows
+ * on a pool of worker threads shared by the process, rather than on
+ * threads of their own. The pool starts with the first such decoder and
+ * stops with the last one. By default it has one worker per core.
+ *
+ * \param[in] threads  Number of worker threads of the pool
+ *
+ * \retval #VPX_CODEC_OK
+ *     The pool will have this size.
+ * \retval #VPX_CODEC_ERROR
+ *     The pool is running with another size.
+ * \retval #VPX_CODEC_INVALID_PARAM
+ *     threads is 0 or above 1024.
+ * \retval #VPX_CODEC_INCAPABLE
+ *     The library is built without multi-threading.
+ */
+vpx_codec_err_t vpx_codec_vp8_dx_set_thread_pool_size(unsigned int threads);
 /*!@} - end algorithm interface member group*/
 
 /* Include controls common to both the encoder and decoder */
@@ -60,10 +80,103 @@ enum vp8_dec_control_id
      */
     VP8D_GET_LAST_REF_USED,
 
+    /** control function to set the fast seek mode, a combination of
+     *  #vp8_fast_seek_flags. No frames are output while it is set.
+     */
+    VP8D_SET_FAST_SEEK,
+
+    /** check if the last decode skipped the reconstruction of the frame */
+    VP8D_GET_FRAME_SKIPPED,
+
+    /** control function to decode at reduced resolution, for previews:
+     *  the frames are reconstructed at 1/2^n of their width and height, for
+     *  n of 1 or 2, or at full resolution for 0. The output approximates
+     *  the downscaled frames. Takes effect at the next key frame. Not
+     *  supported when decoding frames in parallel. Frames decoded at
+     *  reduced resolution are not postprocessed, and #VP8_SET_REFERENCE
+     *  and #VP8_COPY_REFERENCE fail with #VPX_CODEC_INCAPABLE until a key
+     *  frame decoded at full resolution.
+     */
+    VP8D_SET_REDUCED_RESOLUTION,
+
+    /** control function to enable (1) or disable (0) the decoder
+     *  statistics. Enabling them resets the totals.
+     */
+    VP8D_SET_STATS,
+
+    /** control function to get the decoder statistics, a #vp8d_stats_t */
+    VP8D_GET_STATS,
+
+    /** check if frames are decoded in parallel. Only then are frames held
+     *  back until a decode call with no data flushes them. Before the first
+     *  frame, tells whether they will be.
+     */
+    VP8D_GET_FRAME_THREADING,
+
+    /** control function to loop filter and extend the borders of each
+     *  frame in passes over the whole frame once it is decoded (1), rather
+     *  than row by row as it is decoded (0, the default), for comparing the
+     *  two. The output is the same. Only decoding on a single thread is
+     *  affected. Not supported when decoding frames in parallel.
+     */
+    VP8D_SET_FRAME_PASSES,
+
     VP8_DECODER_CTRL_ID_MAX
 } ;
 
 
+/*!\brief VP8 decoder fast seek flags
+ *
+ * Speed up decoding frames that will not be displayed, such as those before
+ * the target of a seek, with the #VP8D_SET_FAST_SEEK control. Not supported
+ * when decoding frames in parallel.
+ */
+enum vp8_fast_seek_flags
+{
+    /** Skip the frames that update no reference frame */
+    VP8_SEEK_SKIP_NONREF = 1 << 0,
+
+    /** Do not loop filter the frames. The reference frames then differ from
+     *  the encoder's until the next key frame, which degrades the frames
+     *  decoded after the seek.
+     */
+    VP8_SEEK_SKIP_LOOPFILTER = 1 << 1
+};
+
+
+/*!\brief VP8 decoder statistics counters
+ *
+ * Times are in microseconds. The decoding times of work that several
+ * threads share are summed over the threads, so they may add up to more
+ * than the time the decode took. Postprocessing is timed as a whole.
+ */
+typedef struct vp8d_stats_counters
+{
+    unsigned int frames;            /**< frames decoded */
+    uint64_t mode_mv_time;          /**< frame header, modes and motion vectors */
+    uint64_t entropy_time;          /**< residual token decoding */
+    uint64_t recon_time;            /**< prediction and inverse transform */
+    uint64_t loop_filter_time;      /**< loop filtering */
+    uint64_t extend_time;           /**< frame border extension */
+    uint64_t postproc_time;         /**< postprocessing of the output frame */
+    uint64_t thread_wait_time;      /**< waiting for the rows of other threads */
+    uint64_t first_partition_bytes; /**< size of the first partition */
+    uint64_t token_partition_bytes[8]; /**< size of each token partition */
+} vp8d_stats_counters_t;
+
+
+/*!\brief VP8 decoder statistics, see #VP8D_GET_STATS
+ *
+ * The statistics are collected while enabled with #VP8D_SET_STATS, at the
+ * cost of a clock read per section of each macroblock.
+ */
+typedef struct vp8d_stats
+{
+    vp8d_stats_counters_t frame;    /**< the last frame decoded */
+    vp8d_stats_counters_t total;    /**< all frames since enabled */
+} vp8d_stats_t;
+
+
 /*!\brief VP8 decoder control function parameter type
  *
  * Defines the data types that VP8D control functions take. Note that
@@ -75,6 +188,13 @@ enum vp8_dec_control_id
 VPX_CTRL_USE_TYPE(VP8D_GET_LAST_REF_UPDATES,   int *)
 VPX_CTRL_USE_TYPE(VP8D_GET_FRAME_CORRUPTED,    int *)
 VPX_CTRL_USE_TYPE(VP8D_GET_LAST_REF_USED,      int *)
+VPX_CTRL_USE_TYPE(VP8D_SET_FAST_SEEK,          int)
+VPX_CTRL_USE_TYPE(VP8D_GET_FRAME_SKIPPED,      int *)
+VPX_CTRL_USE_TYPE(VP8D_SET_REDUCED_RESOLUTION, int)
+VPX_CTRL_USE_TYPE(VP8D_SET_STATS,              int)
+VPX_CTRL_USE_TYPE(VP8D_GET_STATS,              vp8d_stats_t *)
+VPX_CTRL_USE_TYPE(VP8D_GET_FRAME_THREADING,    int *)
+VPX_CTRL_USE_TYPE(VP8D_SET_FRAME_PASSES,       int)
 
 /*! @} - end defgroup vp8_decoder */
 
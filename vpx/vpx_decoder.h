@@ -57,6 +57,13 @@ extern "C" {
                                                        packet loss */
 #define VPX_CODEC_CAP_INPUT_FRAGMENTS   0x100000 /**< Can receive encoded frames
                                                     one fragment at a time */
+#define VPX_CODEC_CAP_FRAME_THREADING   0x200000 /**< Can decode several frames
+                                                    in parallel */
+#define VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER 0x400000 /**< Can decode into frame
+                                                     buffers supplied by the
+                                                     application */
+#define VPX_CODEC_CAP_THREAD_POOL   0x800000 /**< Can decode on a thread pool
+                                                shared by decoder instances */
 
     /*! \brief Initialization-time Feature Enabling
      *
@@ -71,6 +78,13 @@ extern "C" {
 #define VPX_CODEC_USE_INPUT_FRAGMENTS   0x40000 /**< The input frame should be
                                                     passed to the decoder one
                                                     fragment at a time */
+#define VPX_CODEC_USE_FRAME_THREADING   0x80000 /**< Decode consecutive frames
+                                                    in parallel, delaying the
+                                                    output */
+#define VPX_CODEC_USE_THREAD_POOL   0x100000 /**< Decode on the thread pool
+                                                shared by decoder instances,
+                                                rather than on threads of
+                                                this instance */
 
     /*!\brief Stream properties
      *
@@ -196,6 +210,11 @@ extern "C" {
      * empty. When no more data is available, this function should be called
      * with NULL as data and 0 as data_sz. The memory passed to this function
      * must be available until the frame has been decoded.
+     * If the decoder is configured with VPX_CODEC_USE_FRAME_THREADING enabled,
+     * the frames decoded from a call may only become available in later
+     * calls, and a call may make several frames available. Calling this
+     * function with NULL as data and 0 as data_sz at the end of the stream
+     * makes the remaining frames available.
      *
      * \param[in] ctx          Pointer to this instance's context
      * \param[in] data         Pointer to this block of new coded data. If
@@ -219,6 +238,42 @@ extern "C" {
                                      long                deadline);
 
 
+    /*!\brief A frame of a batch decode
+     *
+     * One call to vpx_codec_decode(), of a batch.
+     */
+    typedef struct vpx_codec_batch_item
+    {
+        vpx_codec_ctx_t    *ctx;        /**< Decoder instance */
+        const uint8_t      *data;       /**< Coded data */
+        unsigned int        data_sz;    /**< Size of the coded data */
+        void               *user_priv;  /**< Application specific data */
+        long                deadline;   /**< Soft deadline, in us */
+        vpx_codec_err_t     res;        /**< Result of the decode */
+    } vpx_codec_batch_item_t;
+
+
+    /*!\brief Decode frames of several streams
+     *
+     * Decodes each item as vpx_codec_decode() would, and returns once all
+     * are decoded. The decoders may decode items of different instances in
+     * parallel, so that a caller decoding many streams per tick makes one
+     * call rather than one per stream. Items of the same instance are
+     * decoded in order. The frames are then retrieved from each instance
+     * with vpx_codec_get_frame().
+     *
+     * \param[in,out] items   The frames to decode. The res member of each
+     *                        item is set to its result.
+     * \param[in]     count   Number of items
+     *
+     * \return Returns #VPX_CODEC_OK if all items were decoded without error,
+     *         #VPX_CODEC_INVALID_PARAM if items is NULL, and otherwise the
+     *         first error of an item.
+     */
+    vpx_codec_err_t vpx_codec_decode_batch(vpx_codec_batch_item_t *items,
+                                           unsigned int            count);
+
+
     /*!\brief Decoded frames iterator
      *
      * Iterates over a list of the frames available for display. The iterator
@@ -320,6 +375,80 @@ extern "C" {
 
     /*!@} - end defgroup cap_put_slice*/
 
+    /*!\defgroup cap_external_frame_buffer External Frame Buffer Functions
+     *
+     * The following functions are required to be implemented for all decoders
+     * that advertise the VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER capability.
+     * Calling these functions for codecs that don't advertise this capability
+     * will result in an error code being returned, usually VPX_CODEC_ERROR
+     * @{
+     */
+
+    /*!\brief External frame buffer
+     *
+     * A buffer supplied by the application for the decoder to reconstruct
+     * frames into.
+     */
+    typedef struct vpx_codec_frame_buffer
+    {
+        uint8_t *data;  /**< Pointer to the data buffer */
+        size_t   size;  /**< Size of data in bytes */
+        void    *priv;  /**< Frame buffer's private data, for the application */
+    } vpx_codec_frame_buffer_t;
+
+    /*!\brief get frame buffer callback prototype
+     *
+     * This callback is invoked by the decoder to get a buffer of at least
+     * min_size bytes to decode a frame into. The application sets the data,
+     * size and priv members of fb and returns 0, or returns a negative value
+     * if no buffer is available, which fails the decoding of the frame. The
+     * buffer needs no particular alignment or initialization.
+     */
+    typedef int (*vpx_get_frame_buffer_cb_fn_t)(void                     *cb_priv,
+            size_t                    min_size,
+            vpx_codec_frame_buffer_t *fb);
+
+    /*!\brief release frame buffer callback prototype
+     *
+     * This callback is invoked by the decoder when it no longer uses a buffer
+     * it got from the get frame buffer callback. It returns 0 on success.
+     */
+    typedef int (*vpx_release_frame_buffer_cb_fn_t)(void                     *cb_priv,
+            vpx_codec_frame_buffer_t *fb);
+
+    /*!\brief Decode into frame buffers supplied by the application.
+     *
+     * Registers functions the decoder calls to get and release the buffers
+     * it reconstructs frames into, in place of its internal ones. Images
+     * returned by vpx_codec_get_frame() that are held by such a buffer have
+     * their fb_priv member set to the buffer's priv, so the application can
+     * keep them after the next call to vpx_codec_decode(), as long as it
+     * does not give the buffer out again before the decoder has released it
+     * and the application is done with it. Postprocessed images are held by
+     * the decoder.
+     *
+     * Must be called before the first call to vpx_codec_decode(). Decoders
+     * may not use external frame buffers with some of their features, such
+     * as frame threading.
+     *
+     * \param[in] ctx          Pointer to this instance's context
+     * \param[in] cb_get       Pointer to the get callback function
+     * \param[in] cb_release   Pointer to the release callback function
+     * \param[in] cb_priv      Callback's private data
+     *
+     * \retval #VPX_CODEC_OK
+     *     Callbacks successfully registered.
+     * \retval #VPX_CODEC_ERROR
+     *     Decoder context not initialized, or algorithm not capable of
+     *     using external frame buffers.
+     */
+    vpx_codec_err_t vpx_codec_set_frame_buffer_functions(vpx_codec_ctx_t                  *ctx,
+            vpx_get_frame_buffer_cb_fn_t      cb_get,
+            vpx_release_frame_buffer_cb_fn_t  cb_release,
+            void                             *cb_priv);
+
+    /*!@} - end defgroup cap_external_frame_buffer */
+
     /*!@} - end defgroup decoder*/
 
 #endif
@@ -28,7 +28,7 @@ extern "C" {
      * types, removing or reassigning enums, adding/removing/rearranging
      * fields to structures
      */
-#define VPX_IMAGE_ABI_VERSION (1) /**<\hideinitializer*/
+#define VPX_IMAGE_ABI_VERSION (2) /**<\hideinitializer*/
 
 
 #define VPX_IMG_FMT_PLANAR     0x100  /**< Image is a planar format */
@@ -134,6 +134,12 @@ extern "C" {
         void    *user_priv; /**< may be set by the application to associate data
                          *   with this image. */
 
+        /* The following member is set by decoders using application supplied
+         * frame buffers, see vpx_codec_set_frame_buffer_functions().
+         */
+        void    *fb_priv; /**< priv of the frame buffer holding the image,
+                        *   or NULL if the image is held by the decoder. */
+
         /* The following members should be treated as private. */
         unsigned char *img_data;       /**< private */
         int      img_data_owner; /**< private */
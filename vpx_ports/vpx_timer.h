@@ -11,6 +11,7 @@
 
 #ifndef VPX_TIMER_H
 #define VPX_TIMER_H
+#include "vpx/vpx_integer.h"
 
 #if CONFIG_OS_SUPPORT
 
@@ -27,6 +28,7 @@
  * POSIX specific includes
  */
 #include <sys/time.h>
+#include <time.h>
 
 /* timersub is not provided by msys at this time. */
 #ifndef timersub
@@ -95,6 +97,33 @@ vpx_usec_timer_elapsed(struct vpx_usec_timer *t)
 #endif
 }
 
+
+/* Returns a monotonic timestamp in nanoseconds, cheap enough to time
+ * sections of a few microseconds.
+ */
+static int64_t
+vpx_nsec_timestamp(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER count, freq;
+
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return count.QuadPart / freq.QuadPart * 1000000000 +
+           count.QuadPart % freq.QuadPart * 1000000000 / freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000000 + tv.tv_usec * 1000;
+#endif
+}
+
 #else /* CONFIG_OS_SUPPORT = 0*/
 
 /* Empty timer functions if CONFIG_OS_SUPPORT = 0 */
@@ -116,6 +145,9 @@ vpx_usec_timer_mark(struct vpx_usec_timer *t) { }
 static long
 vpx_usec_timer_elapsed(struct vpx_usec_timer *t) { return 0; }
 
+static int64_t
+vpx_nsec_timestamp(void) { return 0; }
+
 #endif /* CONFIG_OS_SUPPORT */
 
 #endif
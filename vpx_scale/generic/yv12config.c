@@ -48,6 +48,53 @@ vp8_yv12_de_alloc_frame_buffer(YV12_BUFFER_CONFIG *ybf)
     return 0;
 }
 
+/****************************************************************************
+ *
+ ****************************************************************************/
+static int
+setup_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height, int border, unsigned char *buffer)
+{
+    int y_stride = ((width + 2 * border) + 31) & ~31;
+    int yplane_size = (height + 2 * border) * y_stride;
+    int uv_width = width >> 1;
+    int uv_height = height >> 1;
+    /** There is currently a bunch of code which assumes
+      *  uv_stride == y_stride/2, so enforce this here. */
+    int uv_stride = y_stride >> 1;
+    int uvplane_size = (uv_height + border) * uv_stride;
+
+    /** Only support allocating buffers that have a height and width that
+      *  are multiples of 16, and a border that's a multiple of 32.
+      * The border restriction is required to get 16-byte alignment of the
+      *  start of the chroma rows without intoducing an arbitrary gap
+      *  between planes, which would break the semantics of things like
+      *  vpx_img_set_rect(). */
+    if ((width & 0xf) | (height & 0xf) | (border & 0x1f))
+        return -3;
+
+    ybf->y_width  = width;
+    ybf->y_height = height;
+    ybf->y_stride = y_stride;
+
+    ybf->uv_width = uv_width;
+    ybf->uv_height = uv_height;
+    ybf->uv_stride = uv_stride;
+
+    ybf->border = border;
+    ybf->frame_size = yplane_size + 2 * uvplane_size;
+
+    if (buffer)
+    {
+        ybf->y_buffer = buffer + (border * y_stride) + border;
+        ybf->u_buffer = buffer + yplane_size + (border / 2  * uv_stride) + border / 2;
+        ybf->v_buffer = buffer + yplane_size + uvplane_size + (border / 2  * uv_stride) + border / 2;
+    }
+
+    ybf->corrupted = 0; /* assume not currupted by errors */
+
+    return 0;
+}
+
 /****************************************************************************
  *
  ****************************************************************************/
@@ -58,36 +105,14 @@ vp8_yv12_alloc_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height, int
 
     if (ybf)
     {
-        int y_stride = ((width + 2 * border) + 31) & ~31;
-        int yplane_size = (height + 2 * border) * y_stride;
-        int uv_width = width >> 1;
-        int uv_height = height >> 1;
-        /** There is currently a bunch of code which assumes
-          *  uv_stride == y_stride/2, so enforce this here. */
-        int uv_stride = y_stride >> 1;
-        int uvplane_size = (uv_height + border) * uv_stride;
+        int ret;
 
         vp8_yv12_de_alloc_frame_buffer(ybf);
 
-        /** Only support allocating buffers that have a height and width that
-          *  are multiples of 16, and a border that's a multiple of 32.
-          * The border restriction is required to get 16-byte alignment of the
-          *  start of the chroma rows without intoducing an arbitrary gap
-          *  between planes, which would break the semantics of things like
-          *  vpx_img_set_rect(). */
-        if ((width & 0xf) | (height & 0xf) | (border & 0x1f))
-            return -3;
-
-        ybf->y_width  = width;
-        ybf->y_height = height;
-        ybf->y_stride = y_stride;
-
-        ybf->uv_width = uv_width;
-        ybf->uv_height = uv_height;
-        ybf->uv_stride = uv_stride;
+        ret = setup_frame_buffer(ybf, width, height, border, NULL);
 
-        ybf->border = border;
-        ybf->frame_size = yplane_size + 2 * uvplane_size;
+        if (ret < 0)
+            return ret;
 
         ybf->buffer_alloc = (unsigned char *) vpx_memalign(32, ybf->frame_size);
 
@@ -104,11 +129,7 @@ vp8_yv12_alloc_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height, int
         }
 #endif
 
-        ybf->y_buffer = ybf->buffer_alloc + (border * y_stride) + border;
-        ybf->u_buffer = ybf->buffer_alloc + yplane_size + (border / 2  * uv_stride) + border / 2;
-        ybf->v_buffer = ybf->buffer_alloc + yplane_size + uvplane_size + (border / 2  * uv_stride) + border / 2;
-
-        ybf->corrupted = 0; /* assume not currupted by errors */
+        setup_frame_buffer(ybf, width, height, border, ybf->buffer_alloc);
     }
     else
     {
@@ -117,3 +138,35 @@ vp8_yv12_alloc_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height, int
 
     return 0;
 }
+
+/****************************************************************************
+ *
+ ****************************************************************************/
+int
+vp8_yv12_frame_buffer_size(int width, int height, int border)
+{
+    YV12_BUFFER_CONFIG ybf;
+
+    if (setup_frame_buffer(&ybf, width, height, border, NULL) < 0)
+        return -3;
+
+    return ybf.frame_size;
+}
+
+/****************************************************************************
+ *
+ ****************************************************************************/
+int
+vp8_yv12_wrap_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height, int border, unsigned char *buffer)
+{
+    if (ybf && buffer)
+    {
+        vp8_yv12_de_alloc_frame_buffer(ybf);
+
+        return setup_frame_buffer(ybf, width, height, border, buffer);
+    }
+    else
+    {
+        return -2;
+    }
+}
@@ -75,6 +75,14 @@ extern "C"
     int vp8_yv12_alloc_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height, int border);
     int vp8_yv12_de_alloc_frame_buffer(YV12_BUFFER_CONFIG *ybf);
 
+    /* Frame buffers can also be laid out in memory owned by the caller, of
+     * at least vp8_yv12_frame_buffer_size() bytes. The buffer_alloc member of
+     * such buffers is NULL, and vp8_yv12_de_alloc_frame_buffer() leaves the
+     * memory alone.
+     */
+    int vp8_yv12_frame_buffer_size(int width, int height, int border);
+    int vp8_yv12_wrap_frame_buffer(YV12_BUFFER_CONFIG *ybf, int width, int height, int border, unsigned char *buffer);
+
 #ifdef __cplusplus
 }
 #endif
@@ -89,6 +89,16 @@ static const arg_def_t verbosearg = ARG_DEF("v", "verbose", 0,
                                   "Show version string");
 static const arg_def_t error_concealment = ARG_DEF(NULL, "error-concealment", 0,
                                        "Enable decoder error-concealment");
+static const arg_def_t frameparallelarg = ARG_DEF(NULL, "frame-parallel", 0,
+                                       "Decode frames in parallel (with --threads)");
+static const arg_def_t framebuffersarg = ARG_DEF(NULL, "frame-buffers", 0,
+                                       "Decode into frame buffers allocated by vpxdec");
+static const arg_def_t seekarg = ARG_DEF(NULL, "seek", 1,
+                                       "Decode the first n frames without output, skipping non-reference frames");
+static const arg_def_t reducearg = ARG_DEF(NULL, "reduce", 1,
+                                       "Decode approximately at 1/2^n of the width and height (n = 1, 2)");
+static const arg_def_t threadpoolarg = ARG_DEF(NULL, "thread-pool", 1,
+                                       "Decode on the shared thread pool, with n threads (with --threads)");
 
 
 #if CONFIG_MD5
@@ -103,8 +113,8 @@ static const arg_def_t *all_args[] =
 #if CONFIG_MD5
     &md5arg,
 #endif
-    &error_concealment,
-    NULL
+    &error_concealment, &frameparallelarg, &framebuffersarg, &seekarg,
+    &reducearg, &threadpoolarg, NULL
 };
 
 #if CONFIG_VP8_DECODER
@@ -624,6 +634,69 @@ fail:
 }
 
 
+/* Pool of frame buffers handed out to the decoder */
+struct frame_buffer
+{
+    vpx_codec_frame_buffer_t fb;
+    int                      in_use;
+};
+
+struct frame_buffer_pool
+{
+    struct frame_buffer     *fbs;
+    int                      num_fbs;
+};
+
+static int get_frame_buffer(void *cb_priv, size_t min_size,
+                            vpx_codec_frame_buffer_t *fb)
+{
+    struct frame_buffer_pool *pool = cb_priv;
+    struct frame_buffer *f = NULL;
+    int i;
+
+    for (i = 0; i < pool->num_fbs; i++)
+        if (!pool->fbs[i].in_use)
+        {
+            f = &pool->fbs[i];
+            break;
+        }
+
+    if (!f)
+    {
+        f = realloc(pool->fbs, (pool->num_fbs + 1) * sizeof(*f));
+        if (!f)
+            return -1;
+        pool->fbs = f;
+        f = &pool->fbs[pool->num_fbs++];
+        memset(f, 0, sizeof(*f));
+    }
+
+    if (f->fb.size < min_size)
+    {
+        free(f->fb.data);
+        f->fb.data = malloc(min_size);
+        f->fb.size = f->fb.data ? min_size : 0;
+        if (!f->fb.data)
+            return -1;
+    }
+
+    f->in_use = 1;
+    fb->data = f->fb.data;
+    fb->size = f->fb.size;
+    /* The pool may move, so the buffer is known by its index. */
+    fb->priv = (void *)(intptr_t)(f - pool->fbs);
+    return 0;
+}
+
+static int release_frame_buffer(void *cb_priv, vpx_codec_frame_buffer_t *fb)
+{
+    struct frame_buffer_pool *pool = cb_priv;
+
+    pool->fbs[(intptr_t)fb->priv].in_use = 0;
+    return 0;
+}
+
+
 void show_progress(int frame_in, int frame_out, unsigned long dx_time)
 {
     fprintf(stderr, "%d decoded frames/%d showed frames in %lu us (%.2f fps)\r",
@@ -707,6 +780,10 @@ int main(int argc, const char **argv_)
     int                    frame_in = 0, frame_out = 0, flipuv = 0, noblit = 0, do_md5 = 0, progress = 0;
     int                    stop_after = 0, postproc = 0, summary = 0, quiet = 1;
     int                    ec_enabled = 0;
+    int                    frame_parallel = 0, flushed = 0;
+    int                    frame_buffers = 0;
+    int                    thread_pool = 0;
+    struct frame_buffer_pool fb_pool = {0};
     vpx_codec_iface_t       *iface = NULL;
     unsigned int           fourcc;
     unsigned long          dx_time = 0;
@@ -731,6 +808,8 @@ int main(int argc, const char **argv_)
 #endif
     struct input_ctx        input = {0};
     int                     frames_corrupted = 0;
+    int                     seek_frames = 0, frames_skipped = 0;
+    int                     reduce = 0;
     int                     dec_flags = 0;
 
     /* Parse command line */
@@ -860,6 +939,29 @@ int main(int argc, const char **argv_)
         {
             ec_enabled = 1;
         }
+        else if (arg_match(&arg, &frameparallelarg, argi))
+        {
+            frame_parallel = 1;
+        }
+        else if (arg_match(&arg, &threadpoolarg, argi))
+        {
+            thread_pool = arg_parse_uint(&arg);
+        }
+        else if (arg_match(&arg, &framebuffersarg, argi))
+        {
+            frame_buffers = 1;
+        }
+        else if (arg_match(&arg, &seekarg, argi))
+        {
+            seek_frames = arg_parse_uint(&arg);
+        }
+        else if (arg_match(&arg, &reducearg, argi))
+        {
+            reduce = arg_parse_uint(&arg);
+
+            if (reduce > 2)
+                die("Error: Invalid --reduce value %d\n", reduce);
+        }
 
 #endif
         else
@@ -910,6 +1012,9 @@ int main(int argc, const char **argv_)
         return EXIT_FAILURE;
     }
 
+    width = (width + (1 << reduce) - 1) >> reduce;
+    height = (height + (1 << reduce) - 1) >> reduce;
+
     /* If the output file is not set or doesn't have a sequence number in
      * it, then we only open it once.
      */
@@ -981,7 +1086,16 @@ int main(int argc, const char **argv_)
         }
 
     dec_flags = (postproc ? VPX_CODEC_USE_POSTPROC : 0) |
-                (ec_enabled ? VPX_CODEC_USE_ERROR_CONCEALMENT : 0);
+                (ec_enabled ? VPX_CODEC_USE_ERROR_CONCEALMENT : 0) |
+                (frame_parallel ? VPX_CODEC_USE_FRAME_THREADING : 0) |
+                (thread_pool ? VPX_CODEC_USE_THREAD_POOL : 0);
+#if CONFIG_VP8_DECODER
+    if (thread_pool && vpx_codec_vp8_dx_set_thread_pool_size(thread_pool))
+    {
+        fprintf(stderr, "Failed to set the thread pool size\n");
+        return EXIT_FAILURE;
+    }
+#endif
     if (vpx_codec_dec_init(&decoder, iface ? iface :  ifaces[0].iface, &cfg,
                            dec_flags))
     {
@@ -992,6 +1106,14 @@ int main(int argc, const char **argv_)
     if (!quiet)
         fprintf(stderr, "%s\n", decoder.name);
 
+    if (frame_buffers
+        && vpx_codec_set_frame_buffer_functions(&decoder, get_frame_buffer,
+                                                release_frame_buffer, &fb_pool))
+    {
+        fprintf(stderr, "Failed to configure frame buffers: %s\n", vpx_codec_error(&decoder));
+        return EXIT_FAILURE;
+    }
+
 #if CONFIG_VP8_DECODER
 
     if (vp8_pp_cfg.post_proc_flag
@@ -1028,19 +1150,52 @@ int main(int argc, const char **argv_)
         fprintf(stderr, "Failed to configure motion vector visualizer: %s\n", vpx_codec_error(&decoder));
         return EXIT_FAILURE;
     }
+
+    if (reduce
+        && vpx_codec_control(&decoder, VP8D_SET_REDUCED_RESOLUTION, reduce))
+    {
+        fprintf(stderr, "Failed to configure reduced resolution: %s\n", vpx_codec_error(&decoder));
+        return EXIT_FAILURE;
+    }
+
+    if (seek_frames
+        && vpx_codec_control(&decoder, VP8D_SET_FAST_SEEK, VP8_SEEK_SKIP_NONREF))
+    {
+        fprintf(stderr, "Failed to configure fast seek: %s\n", vpx_codec_error(&decoder));
+        return EXIT_FAILURE;
+    }
 #endif
 
     /* Decode file */
-    while (!read_frame(&input, &buf, &buf_sz, &buf_alloc_sz))
+    while (!flushed)
     {
         vpx_codec_iter_t  iter = NULL;
         vpx_image_t    *img;
         struct vpx_usec_timer timer;
         int                   corrupted;
+        int                   got_data = 0;
+
+        if (!(stop_after && frame_in >= stop_after))
+            got_data = !read_frame(&input, &buf, &buf_sz, &buf_alloc_sz);
+
+        if (!got_data)
+        {
+            int frame_threading = 0;
+
+            /* The frame-parallel decoder holds frames back until flushed. */
+            if (!frame_parallel
+                || vpx_codec_control(&decoder, VP8D_GET_FRAME_THREADING,
+                                     &frame_threading)
+                || !frame_threading)
+                break;
+
+            flushed = 1;
+        }
 
         vpx_usec_timer_start(&timer);
 
-        if (vpx_codec_decode(&decoder, buf, buf_sz, NULL, 0))
+        if (vpx_codec_decode(&decoder, got_data ? buf : NULL,
+                             got_data ? buf_sz : 0, NULL, 0))
         {
             const char *detail = vpx_codec_error_detail(&decoder);
             fprintf(stderr, "Failed to decode frame: %s\n", vpx_codec_error(&decoder));
@@ -1054,7 +1209,8 @@ int main(int argc, const char **argv_)
         vpx_usec_timer_mark(&timer);
         dx_time += vpx_usec_timer_elapsed(&timer);
 
-        ++frame_in;
+        if (got_data)
+            ++frame_in;
 
         if (vpx_codec_control(&decoder, VP8D_GET_FRAME_CORRUPTED, &corrupted))
         {
@@ -1064,15 +1220,33 @@ int main(int argc, const char **argv_)
         }
         frames_corrupted += corrupted;
 
-        if ((img = vpx_codec_get_frame(&decoder, &iter)))
-            ++frame_out;
+        if (seek_frames && got_data)
+        {
+            int skipped;
 
-        if (progress)
-            show_progress(frame_in, frame_out, dx_time);
+            if (vpx_codec_control(&decoder, VP8D_GET_FRAME_SKIPPED, &skipped))
+            {
+                fprintf(stderr, "Failed VP8D_GET_FRAME_SKIPPED: %s\n",
+                        vpx_codec_error(&decoder));
+                goto fail;
+            }
+            frames_skipped += skipped;
 
-        if (!noblit)
+            /* Output the frames from the seek target on. */
+            if (frame_in == seek_frames
+                && vpx_codec_control(&decoder, VP8D_SET_FAST_SEEK, 0))
+            {
+                fprintf(stderr, "Failed VP8D_SET_FAST_SEEK: %s\n",
+                        vpx_codec_error(&decoder));
+                goto fail;
+            }
+        }
+
+        while ((img = vpx_codec_get_frame(&decoder, &iter)))
         {
-            if (img)
+            ++frame_out;
+
+            if (!noblit)
             {
                 unsigned int y;
                 char out_fn[PATH_MAX];
@@ -1084,7 +1258,8 @@ int main(int argc, const char **argv_)
 
                     out_fn[len] = '\0';
                     generate_filename(outfile_pattern, out_fn, len-1,
-                                      img->d_w, img->d_h, frame_in);
+                                      img->d_w, img->d_h,
+                                      frame_parallel ? frame_out : frame_in);
                     out = out_open(out_fn, do_md5);
                 }
                 else if(use_y4m)
@@ -1119,8 +1294,8 @@ int main(int argc, const char **argv_)
             }
         }
 
-        if (stop_after && frame_in >= stop_after)
-            break;
+        if (progress)
+            show_progress(frame_in, frame_out, dx_time);
     }
 
     if (summary || progress)
@@ -1129,6 +1304,9 @@ int main(int argc, const char **argv_)
         fprintf(stderr, "\n");
     }
 
+    if (frames_skipped && (summary || progress))
+        fprintf(stderr, "%d frames skipped while seeking.\n", frames_skipped);
+
     if (frames_corrupted)
         fprintf(stderr, "WARNING: %d frames corrupted.\n",frames_corrupted);
 
@@ -1143,6 +1321,10 @@ fail:
     if (single_file && !noblit)
         out_close(out, outfile, do_md5);
 
+    for (i = 0; i < fb_pool.num_fbs; i++)
+        free(fb_pool.fbs[i].fb.data);
+    free(fb_pool.fbs);
+
     if(input.nestegg_ctx)
         nestegg_destroy(input.nestegg_ctx);
     if(input.kind != WEBM_FILE)
@@ -258,6 +258,70 @@ vpx_fixed_buf_t stats_get(stats_io_t *stats)
     return stats->buf;
 }
 
+/* Opens the stats of the last pass from a comma separated list of the
+ * first pass files of consecutive segments of the input, merged into one
+ * buffer. Returns the number of frames of each segment, which start with
+ * a key frame.
+ */
+int stats_open_segments(stats_io_t *stats, const char *fpf_list,
+                        unsigned int **segment_frames,
+                        unsigned int *num_segments)
+{
+    char            *names, *name;
+    stats_io_t      *segments;
+    vpx_fixed_buf_t *bufs;
+    unsigned int     n = 1, i = 0;
+    int              res = 1;
+    const char      *p;
+
+    for (p = fpf_list; *p; p++)
+        if (*p == ',')
+            n++;
+
+    names = strdup(fpf_list);
+    segments = calloc(n, sizeof(*segments));
+    bufs = calloc(n, sizeof(*bufs));
+    *segment_frames = calloc(n, sizeof(**segment_frames));
+    *num_segments = n;
+
+    if (!names || !segments || !bufs || !*segment_frames)
+    {
+        fprintf(stderr, "Failed to allocate first-pass segments\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (name = strtok(names, ","); name && i < n; name = strtok(NULL, ","))
+    {
+        if (!stats_open_file(&segments[i], name, 1))
+        {
+            fprintf(stderr, "Failed to open first-pass segment %s\n", name);
+            exit(EXIT_FAILURE);
+        }
+
+        bufs[i] = stats_get(&segments[i]);
+        i++;
+    }
+
+    stats->pass = 1;
+    stats->file = NULL;
+    stats->buf.buf = NULL;
+
+    if (i != n
+        || vpx_codec_vp8_cx_merge_stats(&stats->buf, bufs, NULL, n)
+        || !(stats->buf.buf = malloc(stats->buf.sz))
+        || vpx_codec_vp8_cx_merge_stats(&stats->buf, bufs, *segment_frames, n))
+        res = 0;
+
+    for (i = 0; i < n; i++)
+        if (segments[i].file)
+            stats_close(&segments[i], 1);
+
+    free(bufs);
+    free(segments);
+    free(names);
+    return res;
+}
+
 /* Stereo 3D packed frame format */
 typedef enum stereo_format
 {
@@ -929,9 +993,11 @@ static const arg_def_t passes           = ARG_DEF("p", "passes", 1,
 static const arg_def_t pass_arg         = ARG_DEF(NULL, "pass", 1,
         "Pass to execute (1/2)");
 static const arg_def_t fpf_name         = ARG_DEF(NULL, "fpf", 1,
-        "First pass statistics file name");
+        "First pass statistics file name, or comma separated segment files");
 static const arg_def_t limit = ARG_DEF(NULL, "limit", 1,
                                        "Stop encoding after n input frames");
+static const arg_def_t skip = ARG_DEF(NULL, "skip", 1,
+                                      "Skip the first n input frames");
 static const arg_def_t deadline         = ARG_DEF("d", "deadline", 1,
         "Deadline per frame (usec)");
 static const arg_def_t best_dl          = ARG_DEF(NULL, "best", 0,
@@ -955,7 +1021,8 @@ static const arg_def_t rate_hist_n         = ARG_DEF(NULL, "rate-hist", 1,
 static const arg_def_t *main_args[] =
 {
     &debugmode,
-    &outputfile, &codecarg, &passes, &pass_arg, &fpf_name, &limit, &deadline,
+    &outputfile, &codecarg, &passes, &pass_arg, &fpf_name, &limit, &skip,
+    &deadline,
     &best_dl, &good_dl, &rt_dl,
     &verbosearg, &psnrarg, &use_ivf, &q_hist_n, &rate_hist_n,
     NULL
@@ -1463,7 +1530,9 @@ int main(int argc, const char **argv_)
     char                   **argv, **argi, **argj;
     int                      arg_usage = 0, arg_passes = 1, arg_deadline = 0;
     int                      arg_ctrls[ARG_CTRL_CNT_MAX][2], arg_ctrl_cnt = 0;
-    int                      arg_limit = 0;
+    int                      arg_limit = 0, arg_skip = 0;
+    unsigned int            *segment_frames = NULL, num_segments = 0;
+    unsigned int             segment, segment_start;
     static const arg_def_t **ctrl_args = no_args;
     static const int        *ctrl_args_map = NULL;
     int                      verbose = 0, show_psnr = 0;
@@ -1555,6 +1624,8 @@ int main(int argc, const char **argv_)
             verbose = 1;
         else if (arg_match(&arg, &limit, argi))
             arg_limit = arg_parse_uint(&arg);
+        else if (arg_match(&arg, &skip, argi))
+            arg_skip = arg_parse_uint(&arg);
         else if (arg_match(&arg, &psnrarg, argi))
             show_psnr = 1;
         else if (arg_match(&arg, &framerate, argi))
@@ -1593,6 +1664,9 @@ int main(int argc, const char **argv_)
             die("Must specify --fpf when --pass=%d and --passes=2\n", one_pass_only);
     }
 
+    if (stats_fn && strchr(stats_fn, ',') && one_pass_only != 2)
+        die("A list of --fpf segment files needs --pass=2\n");
+
     /* Populate encoder configuration */
     res = vpx_codec_enc_config_default(codec->iface, &cfg, arg_usage);
 
@@ -1908,7 +1982,16 @@ int main(int argc, const char **argv_)
             return EXIT_FAILURE;
         }
 
-        if (stats_fn)
+        if (stats_fn && strchr(stats_fn, ','))
+        {
+            if (!stats_open_segments(&stats, stats_fn, &segment_frames,
+                                     &num_segments))
+            {
+                fprintf(stderr, "Failed to merge first-pass segments\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if (stats_fn)
         {
             if (!stats_open_file(&stats, stats_fn, pass))
             {
@@ -1964,8 +2047,15 @@ int main(int argc, const char **argv_)
             ctx_exit_on_error(&encoder, "Failed to control codec");
         }
 
+        /* Discard the input frames before the segment to encode */
+        for (i = 0; i < arg_skip; i++)
+            if (!read_frame(infile, &raw, file_type, &y4m, &detect))
+                break;
+
         frame_avail = 1;
         got_data = 0;
+        segment = 0;
+        segment_start = 0;
 
         while (frame_avail || got_data)
         {
@@ -1973,6 +2063,7 @@ int main(int argc, const char **argv_)
             const vpx_codec_cx_pkt_t *pkt;
             struct vpx_usec_timer timer;
             int64_t frame_start, next_frame_start;
+            vpx_enc_frame_flags_t flags = 0;
 
             if (!arg_limit || frames_in < arg_limit)
             {
@@ -1989,6 +2080,14 @@ int main(int argc, const char **argv_)
             else
                 frame_avail = 0;
 
+            /* Each segment of merged first pass stats starts a key frame */
+            if (frame_avail && segment < num_segments
+                && frames_in - 1 == segment_start)
+            {
+                flags |= VPX_EFLAG_FORCE_KF;
+                segment_start += segment_frames[segment++];
+            }
+
             vpx_usec_timer_start(&timer);
 
             frame_start = (cfg.g_timebase.den * (int64_t)(frames_in - 1)
@@ -1998,7 +2097,7 @@ int main(int argc, const char **argv_)
                                 / cfg.g_timebase.num / arg_framerate.num;
             vpx_codec_encode(&encoder, frame_avail ? &raw : NULL, frame_start,
                              next_frame_start - frame_start,
-                             0, arg_deadline);
+                             flags, arg_deadline);
             vpx_usec_timer_mark(&timer);
             cx_time += vpx_usec_timer_elapsed(&timer);
             ctx_exit_on_error(&encoder, "Failed to encode frame");
@@ -2136,6 +2235,7 @@ int main(int argc, const char **argv_)
     destroy_rate_histogram(&rate_hist);
 
     vpx_img_free(&raw);
+    free(segment_frames);
     free(argv);
     return EXIT_SUCCESS;
 }